@@ -0,0 +1,108 @@
+#include <ps-requester.h>
+#include <ps-signer.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+using namespace mcl::bls12;
+
+// every heap allocation of the process goes through these
+static std::atomic<size_t> s_allocation_num{0};
+
+void*
+operator new(size_t size)
+{
+  s_allocation_num++;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept
+{
+  std::free(p);
+}
+
+// heap allocations per call of f, after warming up scratch space and caller-owned outputs
+template<class F>
+static double
+allocationsPerCall(F f)
+{
+  const size_t warmup_num = 4, call_num = 100;
+  for (size_t i = 0; i < warmup_num; i++) {
+    f();
+  }
+  size_t before = s_allocation_num;
+  for (size_t i = 0; i < call_num; i++) {
+    f();
+  }
+  return static_cast<double>(s_allocation_num - before) / call_num;
+}
+
+// heap allocations of User-RequestID and User-ProveID with the vector API and the view API
+int
+main(int argc, char const *argv[])
+{
+  PSCurve::init();
+  G1 g, authority_pk, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+
+  std::cout << "attributes\toperation\tvector_api[allocs/call]\tview_api[allocs/call]" << std::endl;
+  for (size_t attribute_num : {3, 10, 50}) {
+    PSSigner idp(attribute_num, g, gg);
+    auto pk = idp.key_gen();
+    PSRequester user(pk);
+    std::vector<std::tuple<std::string, bool>> attributes;
+    std::vector<PSAttributeView> views;
+    for (size_t i = 0; i < attribute_num; i++) {
+      // longer than the small string buffer, so copies allocate
+      attributes.emplace_back("attribute-value-" + std::to_string(i) + "-0123456789", i < attribute_num / 2 + 1);
+    }
+    for (const auto& attribute : attributes) {
+      views.emplace_back(std::get<0>(attribute), std::get<1>(attribute));
+    }
+
+    PSBlindingContext context;
+    PSCredRequest request;
+    double vector_allocations = allocationsPerCall([&] { user.el_passo_request_id(attributes, "request", context); });
+    double view_allocations = allocationsPerCall([&] {
+      user.el_passo_request_id(views.data(), views.size(), "request", context, request);
+    });
+    std::cout << attribute_num << "\tRequestID\t" << vector_allocations << "\t" << view_allocations << std::endl;
+
+    PSCredential sig;
+    idp.el_passo_provide_id(request, "request", sig);
+    sig = user.unblind_credential(sig, context);
+    IdProof proof;
+    vector_allocations = allocationsPerCall([&] {
+      user.el_passo_prove_id(sig, attributes, "session", "service", authority_pk, g, h);
+    });
+    view_allocations = allocationsPerCall([&] {
+      user.el_passo_prove_id(sig, views.data(), views.size(), "session", "service", authority_pk, g, h, proof);
+    });
+    std::cout << attribute_num << "\tProveID\t" << vector_allocations << "\t" << view_allocations << std::endl;
+
+    vector_allocations = allocationsPerCall([&] {
+      user.el_passo_prove_id_without_id_retrieval(sig, attributes, "session", "service");
+    });
+    view_allocations = allocationsPerCall([&] {
+      user.el_passo_prove_id_without_id_retrieval(sig, views.data(), views.size(), "session", "service", proof);
+    });
+    std::cout << attribute_num << "\tProveID_without_id_retrieval\t" << vector_allocations << "\t" << view_allocations
+              << std::endl;
+  }
+}
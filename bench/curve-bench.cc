@@ -0,0 +1,71 @@
+#include <ps-requester.h>
+#include <ps-signer.h>
+#include <ps-verifier.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace mcl::bls12;
+
+static const double DURATION_S = 1;
+
+// operations per second of f(), run for DURATION_S
+template<class F>
+static double
+throughputOf(F f)
+{
+  size_t op_num = 0;
+  auto begin = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed(0);
+  while (elapsed.count() < DURATION_S) {
+    f();
+    op_num++;
+    elapsed = std::chrono::steady_clock::now() - begin;
+  }
+  return op_num / elapsed.count();
+}
+
+// IDP-ProvideID, User-ProveID and RP-VerifyID throughput on the curve of this build,
+// built once per curve ("make bench" runs both)
+int
+main(int argc, char const *argv[])
+{
+  PSCurve::init();
+  G1 g, authority_pk, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+
+  std::cout << "curve\tattributes\tprovide_id[op/s]\tprove_id[op/s]\tverify_id[op/s]" << std::endl;
+  for (size_t attribute_num : {5, 20}) {
+    PSSigner idp(attribute_num, g, gg);
+    auto pk = idp.key_gen();
+    PSRequester user(pk);
+    PSVerifier rp(pk);
+    std::vector<std::tuple<std::string, bool>> attributes;
+    for (size_t i = 0; i < attribute_num; i++) {
+      attributes.push_back(std::make_tuple("attribute" + std::to_string(i), i < 2));
+    }
+    auto request = user.el_passo_request_id(attributes, "bench");
+
+    PSCredential sig;
+    bool result = true;
+    double provide_ops = throughputOf([&] { result &= idp.el_passo_provide_id(request, "bench", sig); });
+    auto ubld_sig = user.unblind_credential(sig);
+    IdProof proof;
+    double prove_ops = throughputOf([&] {
+      proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority_pk, g, h);
+    });
+    double verify_ops = throughputOf([&] {
+      result &= rp.el_passo_verify_id(proof, "bench", "service", authority_pk, g, h);
+    });
+    if (!result) {
+      std::cerr << "verification failed" << std::endl;
+      return 1;
+    }
+    std::cout << PSCurve::NAME << "\t" << attribute_num << "\t" << provide_ops << "\t" << prove_ops
+              << "\t" << verify_ops << std::endl;
+  }
+}
@@ -0,0 +1,82 @@
+#include <ps-fixed-size.h>
+#include <ps-requester.h>
+#include <ps-verifier.h>
+
+#include <chrono>
+#include <iostream>
+
+using namespace mcl::bls12;
+
+static const size_t ROUND_NUM = 20;
+
+// average time of f() in µs
+template<class F>
+static double
+timeOf(F f)
+{
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < ROUND_NUM; round++) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - begin).count() / ROUND_NUM;
+}
+
+// IDP-ProvideID and RP-VerifyID over N attributes, the first half of which are committed,
+// with the dynamic classes and the fixed-size ones
+template<size_t N>
+static void
+benchmark(const G1& g, const G2& gg, const G1& authority_pk, const G1& h)
+{
+  constexpr uint64_t HIDDEN_MASK = (uint64_t(1) << (N / 2)) - 1;
+  PSSigner idp(N, g, gg);
+  auto pk = idp.key_gen();
+  PSSignerN<N> fixed_idp(idp);
+  PSRequester user(pk);
+  PSVerifier rp(pk);
+  PSVerifierN<N> fixed_rp(pk);
+
+  std::vector<std::tuple<std::string, bool>> attributes;
+  for (size_t i = 0; i < N; i++) {
+    attributes.push_back(std::make_tuple("attribute" + std::to_string(i), i < N / 2));
+  }
+  auto request = user.el_passo_request_id(attributes, "bench");
+  auto fixed_request = PSCredRequestN<N, HIDDEN_MASK>::fromCredRequest(request);
+  PSCredential sig;
+  bool result = true;
+  double provide_us = timeOf([&] { result &= idp.el_passo_provide_id(request, "bench", sig); });
+  double fixed_provide_us = timeOf([&] { result &= fixed_idp.el_passo_provide_id(fixed_request, "bench", sig); });
+
+  auto ubld_sig = user.unblind_credential(sig);
+  auto proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority_pk, g, h);
+  auto fixed_proof = IdProofN<N, HIDDEN_MASK>::fromIdProof(proof);
+  double verify_us = timeOf([&] {
+    result &= rp.el_passo_verify_id(proof, "bench", "service", authority_pk, g, h);
+  });
+  double fixed_verify_us = timeOf([&] {
+    result &= fixed_rp.el_passo_verify_id(fixed_proof, "bench", "service", authority_pk, g, h);
+  });
+  if (!result) {
+    std::cerr << "verification failed over " << N << " attributes" << std::endl;
+    exit(1);
+  }
+  std::cout << N << "\t" << provide_us << "\t" << fixed_provide_us << "\t" << provide_us / fixed_provide_us
+            << "\t" << verify_us << "\t" << fixed_verify_us << "\t" << verify_us / fixed_verify_us << std::endl;
+}
+
+int
+main(int argc, char const *argv[])
+{
+  PSCurve::init();
+  G1 g, authority_pk, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+
+  std::cout << "attributes\tprovide_id[µs]\tprovide_id_n[µs]\tspeedup\tverify_id[µs]\tverify_id_n[µs]\tspeedup" << std::endl;
+  benchmark<4>(g, gg, authority_pk, h);
+  benchmark<16>(g, gg, authority_pk, h);
+  benchmark<64>(g, gg, authority_pk, h);
+}
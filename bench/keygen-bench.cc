@@ -0,0 +1,52 @@
+#include <ps-signer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+using namespace mcl::bls12;
+
+// IDP-KeyGen time over attribute counts and thread counts
+int
+main(int argc, char const *argv[])
+{
+  PSCurve::init();
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+
+  size_t max_thread_num = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> thread_nums;
+  for (size_t thread_num = 1; thread_num < max_thread_num; thread_num *= 2) {
+    thread_nums.push_back(thread_num);
+  }
+  thread_nums.push_back(max_thread_num);
+
+  std::cout << "attributes\tthreads\tkey_gen[ms]\tkey_gen_streamed[ms]\tspeedup" << std::endl;
+  for (size_t attribute_num : {10, 100, 1000, 10000}) {
+    double serial_ms = 0;
+    for (size_t thread_num : thread_nums) {
+      PSThreadPool pool(thread_num);
+      PSSigner idp(attribute_num, g, gg);
+
+      auto begin = std::chrono::steady_clock::now();
+      idp.key_gen(pool);
+      auto end = std::chrono::steady_clock::now();
+      double ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+      std::ostringstream pk_stream;
+      begin = std::chrono::steady_clock::now();
+      idp.key_gen(pool, pk_stream);
+      end = std::chrono::steady_clock::now();
+      double streamed_ms = std::chrono::duration<double, std::milli>(end - begin).count();
+
+      if (thread_num == 1) {
+        serial_ms = ms;
+      }
+      std::cout << attribute_num << "\t" << thread_num << "\t" << ms << "\t" << streamed_ms
+                << "\t" << serial_ms / ms << std::endl;
+    }
+  }
+}
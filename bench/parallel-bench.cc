@@ -0,0 +1,83 @@
+#include <ps-requester.h>
+#include <ps-signer.h>
+#include <ps-verifier.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+using namespace mcl::bls12;
+
+// User-ProveID and RP-VerifyID time of a single proof over attribute counts and thread counts
+int
+main(int argc, char const *argv[])
+{
+  PSCurve::init();
+  G1 g, authority_pk, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+
+  size_t max_thread_num = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<size_t> thread_nums;
+  for (size_t thread_num = 1; thread_num < max_thread_num; thread_num *= 2) {
+    thread_nums.push_back(thread_num);
+  }
+  thread_nums.push_back(max_thread_num);
+  const size_t round_num = 10;
+
+  std::cout << "attributes\tthreads\tprove_id[µs]\tverify_id[µs]\tprove_speedup\tverify_speedup" << std::endl;
+  for (size_t attribute_num : {10, 100, 1000}) {
+    PSSigner idp(attribute_num, g, gg);
+    auto pk = idp.key_gen();
+    PSRequester user(pk);
+    PSVerifier rp(pk);
+
+    // s, gamma and about half of the other attributes stay hidden from the RP
+    std::vector<std::tuple<std::string, bool>> attributes;
+    for (size_t i = 0; i < attribute_num; i++) {
+      attributes.push_back(std::make_tuple("attribute" + std::to_string(i), i < 2 || i % 2 == 0));
+    }
+    auto request = user.el_passo_request_id(attributes, "bench");
+    PSCredential sig;
+    idp.el_passo_provide_id(request, "bench", sig);
+    auto ubld_sig = user.unblind_credential(sig);
+
+    double serial_prove_us = 0, serial_verify_us = 0;
+    for (size_t thread_num : thread_nums) {
+      PSThreadPool pool(thread_num);
+      user.use_thread_pool(thread_num == 1 ? nullptr : &pool);
+      rp.use_thread_pool(thread_num == 1 ? nullptr : &pool);
+
+      IdProof proof;
+      double prove_us = 0, verify_us = 0;
+      for (size_t round = 0; round < round_num; round++) {
+        auto begin = std::chrono::steady_clock::now();
+        proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority_pk, g, h);
+        auto end = std::chrono::steady_clock::now();
+        prove_us += std::chrono::duration<double, std::micro>(end - begin).count();
+
+        begin = std::chrono::steady_clock::now();
+        bool result = rp.el_passo_verify_id(proof, "bench", "service", authority_pk, g, h);
+        end = std::chrono::steady_clock::now();
+        verify_us += std::chrono::duration<double, std::micro>(end - begin).count();
+        if (!result) {
+          std::cerr << "verification failed" << std::endl;
+          return 1;
+        }
+      }
+      prove_us /= round_num;
+      verify_us /= round_num;
+      if (thread_num == 1) {
+        serial_prove_us = prove_us;
+        serial_verify_us = verify_us;
+      }
+      std::cout << attribute_num << "\t" << thread_num << "\t" << prove_us << "\t" << verify_us
+                << "\t" << serial_prove_us / prove_us << "\t" << serial_verify_us / verify_us << std::endl;
+    }
+    user.use_thread_pool(nullptr);
+    rp.use_thread_pool(nullptr);
+  }
+}
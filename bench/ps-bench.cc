@@ -0,0 +1,293 @@
+#include <ps-requester.h>
+#include <ps-signer.h>
+#include <ps-verifier.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+using namespace mcl::bls12;
+
+/**
+ * ps-bench: microbenchmarks of every EL PASSO operation and encoding path over attribute counts.
+ *
+ * Each operation runs --warmup times unmeasured, then --repetitions times measured one by one.
+ * A human-readable table goes to stdout and, with --json, the same results go to FILE so that
+ * releases can be compared.
+ *
+ * Usage:
+ *   ps-bench [--attributes 1,2,4,...,1024] [--warmup 3] [--repetitions 30] [--filter OPERATION]
+ *            [--json FILE]
+ */
+
+struct PSBenchResult {
+  std::string operation;
+  size_t attribute_num;
+  double p50_us;
+  double p99_us;
+  double mean_us;
+  double min_us;
+  double max_us;
+};
+
+struct PSBenchOptions {
+  std::vector<size_t> attribute_nums;
+  size_t warmup_num = 3;
+  size_t repetition_num = 30;
+  std::string filter;
+  std::string json_path;
+};
+
+class PSBench {
+public:
+  explicit PSBench(const PSBenchOptions& options)
+      : m_options(options)
+  {
+  }
+
+  // runs f() warmup + repetition times and records the timed repetitions as @p operation
+  template<class F>
+  void
+  measure(const std::string& operation, size_t attribute_num, F f)
+  {
+    if (!m_options.filter.empty() && operation.find(m_options.filter) == std::string::npos) {
+      return;
+    }
+    for (size_t i = 0; i < m_options.warmup_num; i++) {
+      f();
+    }
+    std::vector<double> samples(m_options.repetition_num);
+    for (auto& sample : samples) {
+      auto begin = std::chrono::steady_clock::now();
+      f();
+      auto end = std::chrono::steady_clock::now();
+      sample = std::chrono::duration<double, std::micro>(end - begin).count();
+    }
+    std::sort(samples.begin(), samples.end());
+    PSBenchResult result;
+    result.operation = operation;
+    result.attribute_num = attribute_num;
+    result.p50_us = percentile(samples, 50);
+    result.p99_us = percentile(samples, 99);
+    result.mean_us = 0;
+    for (double sample : samples) {
+      result.mean_us += sample;
+    }
+    result.mean_us /= samples.size();
+    result.min_us = samples.front();
+    result.max_us = samples.back();
+    std::cout << result.operation << "\t" << result.attribute_num << "\t" << result.p50_us << "\t"
+              << result.p99_us << "\t" << result.mean_us << std::endl;
+    m_results.push_back(result);
+  }
+
+  void
+  writeJson(std::ostream& os) const
+  {
+    os << "{\n  \"curve\": \"" << PSCurve::NAME << "\",\n"
+       << "  \"warmup\": " << m_options.warmup_num << ",\n"
+       << "  \"repetitions\": " << m_options.repetition_num << ",\n"
+       << "  \"results\": [";
+    for (size_t i = 0; i < m_results.size(); i++) {
+      const auto& result = m_results[i];
+      os << (i == 0 ? "\n" : ",\n")
+         << "    {\"operation\": \"" << result.operation << "\", \"attributes\": " << result.attribute_num
+         << ", \"p50_us\": " << result.p50_us << ", \"p99_us\": " << result.p99_us
+         << ", \"mean_us\": " << result.mean_us << ", \"min_us\": " << result.min_us
+         << ", \"max_us\": " << result.max_us << "}";
+    }
+    os << "\n  ]\n}" << std::endl;
+  }
+
+private:
+  // nearest-rank percentile of sorted samples
+  static double
+  percentile(const std::vector<double>& samples, size_t p)
+  {
+    size_t rank = (p * samples.size() + 99) / 100;
+    return samples[std::max<size_t>(rank, 1) - 1];
+  }
+
+private:
+  PSBenchOptions m_options;
+  std::vector<PSBenchResult> m_results;
+};
+
+static void
+check(bool result, const std::string& operation)
+{
+  if (!result) {
+    std::cerr << operation << " failed" << std::endl;
+    exit(1);
+  }
+}
+
+// every operation over @p attribute_num attributes, s and gamma committed and the others in plaintext
+//
+// The inputs of every operation (key, request, credentials, proofs and encodings) are built untimed
+// first, so --filter only decides which operations are timed and any single one can be measured alone.
+static void
+benchmark(PSBench& bench, size_t attribute_num)
+{
+  G1 g, authority_pk, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  size_t hidden_num = std::min<size_t>(2, attribute_num);
+  // the identity retrieval token needs both s and gamma committed
+  bool id_retrieval = hidden_num == 2;
+  PSAuthorityContext authority(authority_pk, g, h);
+  authority.precompute();
+
+  // inputs
+  PSSigner idp(attribute_num, g, gg);
+  PSPubKey pk = idp.key_gen();
+  PSRequester user(pk);
+  PSVerifier rp(pk);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  std::vector<std::string> all_attributes;
+  for (size_t i = 0; i < attribute_num; i++) {
+    all_attributes.push_back("attribute-" + std::to_string(i));
+    attributes.emplace_back(all_attributes.back(), i < hidden_num);
+  }
+  PSBlindingContext context;
+  PSCredRequest request = user.el_passo_request_id(attributes, "bench", context);
+  PSCredential sig;
+  check(idp.el_passo_provide_id(request, "bench", sig), "provide_id");
+  PSCredential ubld_sig = user.unblind_credential(sig, context);
+  PSCredential rnd_sig = user.randomize_credential(ubld_sig);
+  IdProof proof, authority_proof;
+  if (id_retrieval) {
+    proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority_pk, g, h);
+    authority_proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority);
+  }
+  IdProof proof2 = user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, "bench", "service");
+  IdProof& encoded_proof = id_retrieval ? proof : proof2;
+  PSBuffer pk_buf = pk.toBufferString();
+  PSBuffer request_buf = request.toBufferString();
+  PSBuffer sig_buf = sig.toBufferString();
+  PSBuffer proof_buf = encoded_proof.toBufferString();
+  std::string base64 = proof_buf.toBase64();
+
+  // timed operations, each writing to its own output
+  PSSigner bench_idp(attribute_num, g, gg);
+  PSPubKey bench_pk;
+  bench.measure("key_gen", attribute_num, [&] { bench_pk = bench_idp.key_gen(); });
+  PSBlindingContext bench_context;
+  PSCredRequest bench_request;
+  bench.measure("request_id", attribute_num, [&] {
+    bench_request = user.el_passo_request_id(attributes, "bench", bench_context);
+  });
+  PSCredential bench_sig;
+  bool result = true;
+  bench.measure("provide_id", attribute_num, [&] { result &= idp.el_passo_provide_id(request, "bench", bench_sig); });
+  check(result, "provide_id");
+  bench.measure("unblind", attribute_num, [&] { bench_sig = user.unblind_credential(sig, context); });
+  bench.measure("randomize", attribute_num, [&] { bench_sig = user.randomize_credential(ubld_sig); });
+  bench.measure("verify", attribute_num, [&] { result &= rp.verify(rnd_sig, all_attributes); });
+  check(result, "verify");
+
+  IdProof bench_proof;
+  if (id_retrieval) {
+    bench.measure("prove_id", attribute_num, [&] {
+      bench_proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority_pk, g, h);
+    });
+    bench.measure("verify_id", attribute_num, [&] {
+      result &= rp.el_passo_verify_id(proof, "bench", "service", authority_pk, g, h);
+    });
+    check(result, "verify_id");
+
+    // the same with fixed-base tables for authority_pk, g and h
+    bench.measure("prove_id_authority_tables", attribute_num, [&] {
+      bench_proof = user.el_passo_prove_id(ubld_sig, attributes, "bench", "service", authority);
+    });
+    bench.measure("verify_id_authority_tables", attribute_num, [&] {
+      result &= rp.el_passo_verify_id(authority_proof, "bench", "service", authority);
+    });
+    check(result, "verify_id_authority_tables");
+  }
+  bench.measure("prove_id_without_id_retrieval", attribute_num, [&] {
+    bench_proof = user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, "bench", "service");
+  });
+  bench.measure("verify_id_without_id_retrieval", attribute_num, [&] {
+    result &= rp.el_passo_verify_id_without_id_retrieval(proof2, "bench", "service");
+  });
+  check(result, "verify_id_without_id_retrieval");
+
+  PSBuffer buf;
+  bench.measure("pk_encode", attribute_num, [&] { buf = pk.toBufferString(); });
+  bench.measure("pk_decode", attribute_num, [&] { bench_pk = PSPubKey::fromBufferString(pk_buf); });
+  bench.measure("request_encode", attribute_num, [&] { buf = request.toBufferString(); });
+  bench.measure("request_decode", attribute_num, [&] { bench_request = PSCredRequest::fromBufferString(request_buf); });
+  bench.measure("credential_encode", attribute_num, [&] { buf = sig.toBufferString(); });
+  bench.measure("credential_decode", attribute_num, [&] { bench_sig = PSCredential::fromBufferString(sig_buf); });
+  bench.measure("proof_encode", attribute_num, [&] { buf = encoded_proof.toBufferString(); });
+  bench.measure("proof_decode", attribute_num, [&] { bench_proof = IdProof::fromBufferString(proof_buf); });
+  std::string bench_base64;
+  bench.measure("base64_encode", attribute_num, [&] { bench_base64 = proof_buf.toBase64(); });
+  bench.measure("base64_decode", attribute_num, [&] { buf = PSBuffer::fromBase64(base64); });
+}
+
+int
+main(int argc, char const* argv[])
+{
+  PSBenchOptions options;
+  for (size_t attribute_num = 1; attribute_num <= 1024; attribute_num *= 2) {
+    options.attribute_nums.push_back(attribute_num);
+  }
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (i + 1 >= argc || option.compare(0, 2, "--") != 0) {
+      std::cerr << "usage: ps-bench [--attributes 1,2,4,...,1024] [--warmup 3] [--repetitions 30]\n"
+                << "                [--filter OPERATION] [--json FILE]" << std::endl;
+      return 1;
+    }
+    std::string value = argv[++i];
+    if (option == "--attributes") {
+      options.attribute_nums.clear();
+      for (size_t begin = 0; begin < value.size();) {
+        size_t end = std::min(value.find(',', begin), value.size());
+        options.attribute_nums.push_back(std::stoul(value.substr(begin, end - begin)));
+        begin = end + 1;
+      }
+    }
+    else if (option == "--warmup") {
+      options.warmup_num = std::stoul(value);
+    }
+    else if (option == "--repetitions") {
+      options.repetition_num = std::max(1ul, std::stoul(value));
+    }
+    else if (option == "--filter") {
+      options.filter = value;
+    }
+    else if (option == "--json") {
+      options.json_path = value;
+    }
+    else {
+      std::cerr << "unknown option " << option << std::endl;
+      return 1;
+    }
+  }
+
+  PSCurve::init();
+  PSBench bench(options);
+  std::cout << "operation\tattributes\tp50[µs]\tp99[µs]\tmean[µs]" << std::endl;
+  for (size_t attribute_num : options.attribute_nums) {
+    if (attribute_num == 0) {
+      continue;
+    }
+    benchmark(bench, attribute_num);
+  }
+  if (!options.json_path.empty()) {
+    std::ofstream json(options.json_path);
+    bench.writeJson(json);
+    if (!json) {
+      std::cerr << "cannot write " << options.json_path << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,269 @@
+#include "ps-authority.h"
+#include "ps-random.h"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+PSAuthorityContext::PSAuthorityContext(const G1& authority_pk, const G1& g, const G1& h)
+    : m_points{authority_pk, g, h}
+{
+}
+
+void
+PSAuthorityContext::precompute()
+{
+  for (size_t i = 0; i < BASE_NUM; i++) {
+    m_tables[i] = PSFixedBaseTable<G1>(m_points[i]);
+  }
+}
+
+bool
+PSAuthorityContext::precomputed() const
+{
+  return !m_tables[G].empty();
+}
+
+const G1&
+PSAuthorityContext::authority_pk() const
+{
+  return m_points[AUTHORITY_PK];
+}
+
+const G1&
+PSAuthorityContext::g() const
+{
+  return m_points[G];
+}
+
+const G1&
+PSAuthorityContext::h() const
+{
+  return m_points[H];
+}
+
+void
+PSAuthorityContext::mulAdd(Base base, G1& z, const Fr& s) const
+{
+  if (!m_tables[base].empty()) {
+    m_tables[base].mulAdd(z, s);
+    return;
+  }
+  G1 _temp;
+  G1::mul(_temp, m_points[base], s);
+  G1::add(z, z, _temp);
+}
+
+void
+PSAuthorityContext::mulAdd2(Base base, G1& z1, const Fr& s1, G1& z2, const Fr& s2) const
+{
+  if (!m_tables[base].empty()) {
+    m_tables[base].mulAdd2(z1, s1, z2, s2);
+    return;
+  }
+  mulAdd(base, z1, s1);
+  mulAdd(base, z2, s2);
+}
+
+static Fr
+generateSecretKey()
+{
+  Fr sk;
+  PSRandom::generateFr(sk);
+  return sk;
+}
+
+static G1
+publicKeyOf(const Fr& sk, const G1& g)
+{
+  G1 authority_pk;
+  G1::mul(authority_pk, g, sk);
+  return authority_pk;
+}
+
+PSAuthority::PSAuthority(const G1& g, const G1& h)
+    : PSAuthority(generateSecretKey(), g, h)
+{
+}
+
+PSAuthority::PSAuthority(const Fr& sk, const G1& g, const G1& h)
+    : m_sk(sk)
+    , m_context(publicKeyOf(sk, g), g, h)
+{
+}
+
+const PSAuthorityContext&
+PSAuthority::context() const
+{
+  return m_context;
+}
+
+void
+PSAuthority::precompute()
+{
+  m_context.precompute();
+}
+
+void
+PSAuthority::enroll(const std::vector<std::string>& identities, PSThreadPool& thread_pool)
+{
+  // h^gamma of every identity, bucketed by shard
+  std::vector<std::string> keys(identities.size());
+  std::vector<size_t> shards(identities.size());
+  std::vector<std::vector<size_t>> buckets(SHARD_NUM);
+  std::mutex buckets_mutex;
+  thread_pool.parallelFor(identities.size(), [&](size_t begin, size_t end) {
+    Fr _gamma;
+    G1 _h_gamma;
+    for (size_t i = begin; i < end; i++) {
+      _gamma.setHashOf(identities[i].data(), identities[i].size());
+      _h_gamma.clear();
+      m_context.mulAdd(PSAuthorityContext::H, _h_gamma, _gamma);
+      keys[i] = indexKey(_h_gamma, shards[i]);
+    }
+    std::lock_guard<std::mutex> lock(buckets_mutex);
+    for (size_t i = begin; i < end; i++) {
+      buckets[shards[i]].push_back(i);
+    }
+  });
+
+  // the identities not enrolled yet, each shard checking only its bucket; of repeated identities, the
+  // first is kept
+  std::vector<uint8_t> added(identities.size(), 0);
+  thread_pool.parallelFor(SHARD_NUM, [&](size_t begin, size_t end) {
+    for (size_t shard = begin; shard < end; shard++) {
+      auto& bucket = buckets[shard];
+      std::sort(bucket.begin(), bucket.end());
+      std::unordered_set<std::string_view> seen;
+      for (size_t i : bucket) {
+        added[i] = m_shards[shard].count(keys[i]) == 0 && seen.insert(keys[i]).second;
+      }
+    }
+  });
+  std::vector<size_t> indices(identities.size());
+  size_t added_num = 0;
+  for (size_t i = 0; i < identities.size(); i++) {
+    if (added[i]) {
+      indices[i] = m_identities.size() + added_num++;
+    }
+  }
+
+  // nothing has changed so far; if filling the shards or appending the identities fails, both are undone
+  size_t first = m_identities.size();
+  try {
+    m_identities.reserve(first + added_num);
+    thread_pool.parallelFor(SHARD_NUM, [&](size_t begin, size_t end) {
+      for (size_t shard = begin; shard < end; shard++) {
+        for (size_t i : buckets[shard]) {
+          if (added[i]) {
+            m_shards[shard].emplace(keys[i], indices[i]);
+          }
+        }
+      }
+    });
+    for (size_t i = 0; i < identities.size(); i++) {
+      if (added[i]) {
+        m_identities.push_back(identities[i]);
+      }
+    }
+  }
+  catch (...) {
+    for (size_t i = 0; i < identities.size(); i++) {
+      auto it = m_shards[shards[i]].find(keys[i]);
+      if (added[i] && it != m_shards[shards[i]].end() && it->second == indices[i]) {
+        m_shards[shards[i]].erase(it);
+      }
+    }
+    m_identities.resize(first);
+    throw;
+  }
+}
+
+size_t
+PSAuthority::enrolledNum() const
+{
+  return m_identities.size();
+}
+
+G1
+PSAuthority::decrypt(const G1& E1, const G1& E2) const
+{
+  G1 _h_gamma;
+  G1::mul(_h_gamma, E1, m_sk);
+  G1::sub(_h_gamma, E2, _h_gamma);
+  return _h_gamma;
+}
+
+std::optional<std::string>
+PSAuthority::identify(const G1& E1, const G1& E2) const
+{
+  size_t shard;
+  std::string key = indexKey(decrypt(E1, E2), shard);
+  auto it = m_shards[shard].find(key);
+  if (it == m_shards[shard].end()) {
+    return std::nullopt;
+  }
+  return m_identities[it->second];
+}
+
+std::optional<std::string>
+PSAuthority::identify(const IdProof& proof) const
+{
+  if (!proof.E1.has_value() || !proof.E2.has_value()) {
+    return std::nullopt;
+  }
+  return identify(proof.E1.value(), proof.E2.value());
+}
+
+std::vector<std::optional<std::string>>
+PSAuthority::identifyBatch(const std::vector<IdProof>& proofs, PSThreadPool& thread_pool) const
+{
+  std::vector<std::optional<std::string>> identities(proofs.size());
+  thread_pool.parallelFor(proofs.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      identities[i] = identify(proofs[i]);
+    }
+  });
+  return identities;
+}
+
+PSBuffer
+PSAuthority::toBufferString() const
+{
+  PSBuffer buffer;
+  buffer.appendFrElement(m_sk);
+  buffer.appendG1Element(m_context.g());
+  buffer.appendG1Element(m_context.h());
+  return buffer;
+}
+
+PSAuthority
+PSAuthority::fromBufferString(const PSBuffer& buf)
+{
+  Fr sk;
+  G1 g, h;
+  try {
+    size_t step = buf.parseFrElement(0, sk);
+    size_t g_step = step == 0 ? 0 : buf.parseG1Element(step, g);
+    size_t h_step = g_step == 0 ? 0 : buf.parseG1Element(step + g_step, h);
+    if (h_step != 0) {
+      return PSAuthority(sk, g, h);
+    }
+  }
+  catch (const std::out_of_range&) {
+  }
+  throw std::runtime_error("malformed authority key");
+}
+
+std::string
+PSAuthority::indexKey(const G1& h_gamma, size_t& shard)
+{
+  char buf[256];
+  size_t size = h_gamma.serialize(buf, sizeof(buf));
+  std::string key(buf, size);
+  shard = std::hash<std::string>()(key) % SHARD_NUM;
+  return key;
+}
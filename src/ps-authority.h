@@ -0,0 +1,177 @@
+#ifndef PS_SRC_PS_AUTHORITY_H_
+#define PS_SRC_PS_AUTHORITY_H_
+
+#include "ps-precompute.h"
+#include "ps-thread-pool.h"
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief The public points of an accountability authority that EL PASSO ProveID and VerifyID with
+ *        identity retrieval agree on: the El Gamal public key y = authority_pk, g and h.
+ *
+ * The points never change within a deployment, so a requester or verifier builds the context once and,
+ * after PSAuthorityContext::precompute(), the El Gamal part of every proof (E1 = g^epsilon,
+ * E2 = y^epsilon * h^gamma, and their commitments) runs on fixed-base tables. Copies of a context share
+ * the same tables.
+ */
+class PSAuthorityContext {
+public:
+  enum Base {
+    AUTHORITY_PK,
+    G,
+    H,
+    BASE_NUM
+  };
+
+public:
+  PSAuthorityContext(const G1& authority_pk, const G1& g, const G1& h);
+
+  /**
+   * @brief Build fixed-base tables for authority_pk, g and h.
+   *
+   * Each table takes PSFixedBaseTable<G1>::BYTE_SIZE bytes.
+   */
+  void
+  precompute();
+
+  bool
+  precomputed() const;
+
+  const G1&
+  authority_pk() const;
+
+  const G1&
+  g() const;
+
+  const G1&
+  h() const;
+
+  /**
+   * @brief z = z * base^s, through the table of base when precomputed.
+   */
+  void
+  mulAdd(Base base, G1& z, const Fr& s) const;
+
+  /**
+   * @brief z1 = z1 * base^s1 and z2 = z2 * base^s2, in one pass over the table of base when precomputed.
+   */
+  void
+  mulAdd2(Base base, G1& z1, const Fr& s1, G1& z2, const Fr& s2) const;
+
+private:
+  G1 m_points[BASE_NUM];
+  PSFixedBaseTable<G1> m_tables[BASE_NUM];  // empty if not precomputed
+};
+
+/**
+ * @brief The accountability authority: holds the El Gamal secret key x of authority_pk = g^x and recovers
+ *        the identity behind the identity retrieval token (E1, E2) of an EL PASSO ProveID.
+ *
+ * Decrypting E2 / E1^x gives h^gamma, where gamma is the hash of the user's second attribute. Users are
+ * enrolled with that attribute beforehand, and a hash index from h^gamma to the enrolled attribute maps
+ * the decryption back to the user. The index is split into shards that are filled in parallel.
+ *
+ * Identification may run concurrently, but not concurrently with PSAuthority::enroll().
+ */
+class PSAuthority {
+public:
+  static constexpr size_t SHARD_NUM = 64;
+
+public:
+  /**
+   * @brief Generate a new secret key for @p g and @p h.
+   */
+  PSAuthority(const G1& g, const G1& h);
+
+  /**
+   * @brief Restore an authority from its secret key.
+   */
+  PSAuthority(const Fr& sk, const G1& g, const G1& h);
+
+  /**
+   * @brief The public points to hand to requesters and verifiers, with tables for h after
+   *        PSAuthority::precompute().
+   */
+  const PSAuthorityContext&
+  context() const;
+
+  /**
+   * @brief Build the fixed-base tables of the public points, which speed up PSAuthority::enroll().
+   */
+  void
+  precompute();
+
+  /**
+   * @brief Add users to the index by their second attribute, gamma, as given to PSRequester.
+   *
+   * Each h^gamma is computed and inserted into its shard on @p thread_pool. Identities already enrolled,
+   * or repeated in @p identities, are skipped. If enrolling fails, no identity of @p identities is added.
+   */
+  void
+  enroll(const std::vector<std::string>& identities, PSThreadPool& thread_pool);
+
+  /**
+   * @brief The number of distinct enrolled identities.
+   */
+  size_t
+  enrolledNum() const;
+
+  /**
+   * @brief h^gamma = E2 / E1^x
+   */
+  G1
+  decrypt(const G1& E1, const G1& E2) const;
+
+  /**
+   * @brief The enrolled identity behind the token (E1, E2), if any.
+   */
+  std::optional<std::string>
+  identify(const G1& E1, const G1& E2) const;
+
+  /**
+   * @brief The enrolled identity behind the token of @p proof, if any. The proof should have been
+   *        verified with PSVerifier::el_passo_verify_id() against this authority's public points.
+   */
+  std::optional<std::string>
+  identify(const IdProof& proof) const;
+
+  /**
+   * @brief Identify every proof of an incident at once, decrypting and looking up on @p thread_pool.
+   *
+   * @return the identities, in the order of @p proofs, empty for proofs without a token or whose user
+   *         is not enrolled.
+   */
+  std::vector<std::optional<std::string>>
+  identifyBatch(const std::vector<IdProof>& proofs, PSThreadPool& thread_pool) const;
+
+  /**
+   * @brief Encode the secret key, g and h. The encoding must be kept as secret as the key.
+   */
+  PSBuffer
+  toBufferString() const;
+
+  /**
+   * @throw std::runtime_error if @p buf is malformed.
+   */
+  static PSAuthority
+  fromBufferString(const PSBuffer& buf);
+
+private:
+  // the index key of h^gamma and its shard
+  static std::string
+  indexKey(const G1& h_gamma, size_t& shard);
+
+private:
+  Fr m_sk;
+  PSAuthorityContext m_context;
+  std::vector<std::string> m_identities;
+  std::unordered_map<std::string, size_t> m_shards[SHARD_NUM];  // serialized h^gamma -> m_identities index
+};
+
+#endif  // PS_SRC_PS_AUTHORITY_H_
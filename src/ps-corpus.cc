@@ -0,0 +1,368 @@
+#include "ps-corpus.h"
+#include "ps-random.h"
+#include "ps-requester.h"
+#include "ps-signer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+
+static const char CORPUS_MAGIC[8] = {'P', 'S', 'C', 'O', 'R', 'P', 'U', 'S'};
+static const size_t CORPUS_HEADER_SIZE = 12;  // magic and version
+static const size_t RECORD_HEADER_SIZE = 6;   // length, kind and corruption
+static const size_t RELEASE_STEP = 16 << 20;  // bytes read before the pages behind are dropped
+
+static const char* const KIND_NAMES[static_cast<size_t>(PSCorpusKind::NUM)] = {
+  "pubkey", "authority", "request", "credential", "proof", "proof_without_id_retrieval"};
+static const char* const CORRUPTION_NAMES[static_cast<size_t>(PSCorruption::NUM)] = {
+  "none", "challenge", "response", "signature", "attribute", "context", "truncated"};
+
+static void
+appendUint32(std::string& out, uint32_t value)
+{
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+static uint32_t
+parseUint32(const uint8_t* in)
+{
+  return (uint32_t(in[0]) << 24) | (uint32_t(in[1]) << 16) | (uint32_t(in[2]) << 8) | uint32_t(in[3]);
+}
+
+PSCorpusWriter::PSCorpusWriter(std::ostream& os)
+    : m_os(os)
+{
+  std::string header(CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+  appendUint32(header, VERSION);
+  m_os.write(header.data(), header.size());
+}
+
+void
+PSCorpusWriter::append(PSCorpusKind kind, PSCorruption corruption, const std::vector<std::string>& context,
+                       const PSBuffer& object)
+{
+  m_record.clear();
+  m_record.push_back(static_cast<uint8_t>(kind));
+  m_record.push_back(static_cast<uint8_t>(corruption));
+  m_record.appendStrList(context);
+  m_record.insert(m_record.end(), object.begin(), object.end());
+  if (m_record.size() > UINT32_MAX) {
+    throw std::runtime_error("corpus record too large");
+  }
+  std::string length;
+  appendUint32(length, m_record.size());
+  m_os.write(length.data(), length.size());
+  m_os.write(reinterpret_cast<const char*>(m_record.data()), m_record.size());
+  if (!m_os) {
+    throw std::runtime_error("cannot write corpus record");
+  }
+}
+
+PSCorpusReader::PSCorpusReader(const std::string& path)
+    : m_region(PSMappedRegion::mapFile(path))
+    , m_offset(CORPUS_HEADER_SIZE)
+    , m_released(0)
+{
+  if (m_region->size() < CORPUS_HEADER_SIZE ||
+      std::memcmp(m_region->data(), CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) != 0) {
+    throw std::runtime_error("not a corpus file");
+  }
+  if (parseUint32(m_region->data() + sizeof(CORPUS_MAGIC)) != PSCorpusWriter::VERSION) {
+    throw std::runtime_error("unsupported corpus version");
+  }
+  m_region->adviseSequential();
+}
+
+bool
+PSCorpusReader::next(PSCorpusRecord& record)
+{
+  const uint8_t* data = m_region->data();
+  size_t remaining = m_region->size() - m_offset;
+  if (remaining == 0) {
+    return false;
+  }
+  if (remaining < RECORD_HEADER_SIZE) {
+    throw std::runtime_error("corpus record is truncated");
+  }
+  size_t length = parseUint32(data + m_offset);
+  if (length < RECORD_HEADER_SIZE - 4 || length > remaining - 4) {
+    throw std::runtime_error("corpus record is truncated");
+  }
+  uint8_t kind = data[m_offset + 4];
+  uint8_t corruption = data[m_offset + 5];
+  if (kind >= static_cast<uint8_t>(PSCorpusKind::NUM) || corruption >= static_cast<uint8_t>(PSCorruption::NUM)) {
+    throw std::runtime_error("malformed corpus record");
+  }
+  record.kind = static_cast<PSCorpusKind>(kind);
+  record.corruption = static_cast<PSCorruption>(corruption);
+  record.object.assign(data + m_offset + RECORD_HEADER_SIZE, data + m_offset + 4 + length);
+  record.context.clear();
+  size_t step = 0;
+  try {
+    step = record.object.parseStrList(0, record.context);
+  }
+  catch (const std::out_of_range&) {
+  }
+  if (step == 0 || step > record.object.size()) {
+    throw std::runtime_error("malformed corpus record");
+  }
+  record.object.erase(record.object.begin(), record.object.begin() + step);
+  m_offset += 4 + length;
+  // records are copied out, so memory use stays flat however large the file is
+  if (m_offset - m_released >= RELEASE_STEP) {
+    m_region->release(m_offset);
+    m_released = m_offset;
+  }
+  return true;
+}
+
+// restores the calling thread's default randomness when generation ends, also on exceptions
+class PSSeededThread {
+public:
+  explicit PSSeededThread(const std::string& seed)
+  {
+    PSRandom::setThreadSource(std::make_shared<PSChaChaDrbg>(seed));
+  }
+
+  ~PSSeededThread()
+  {
+    PSRandom::setThreadSource(nullptr);
+  }
+};
+
+static uint64_t
+drawUint64(PSChaChaDrbg& drbg)
+{
+  uint8_t bytes[8];
+  drbg.generate(bytes, sizeof(bytes));
+  uint64_t value = 0;
+  for (uint8_t byte : bytes) {
+    value = (value << 8) | byte;
+  }
+  return value;
+}
+
+static std::string
+drawAttribute(PSChaChaDrbg& drbg, size_t size)
+{
+  static const char* const digits = "0123456789abcdef";
+  std::vector<uint8_t> bytes((size + 1) / 2);
+  drbg.generate(bytes.data(), bytes.size());
+  std::string attribute;
+  attribute.reserve(bytes.size() * 2);
+  for (uint8_t byte : bytes) {
+    attribute.push_back(digits[byte >> 4]);
+    attribute.push_back(digits[byte & 0xF]);
+  }
+  attribute.resize(size);
+  return attribute;
+}
+
+void
+PSCorpus::generate(const PSCorpusOptions& options, std::ostream& os)
+{
+  if (options.invalid_ratio < 0 || options.invalid_ratio > 1) {
+    throw std::runtime_error("invalid ratio must be between 0 and 1");
+  }
+  for (size_t attribute_num : options.attribute_nums) {
+    if (attribute_num < 2) {
+      throw std::runtime_error("proofs need at least 2 attributes, s and gamma");
+    }
+  }
+  for (auto kind : options.kinds) {
+    if (kind != PSCorpusKind::REQUEST && kind != PSCorpusKind::CREDENTIAL && kind != PSCorpusKind::PROOF &&
+        kind != PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL) {
+      throw std::runtime_error("only requests, credentials and proofs can be generated");
+    }
+  }
+  std::vector<PSCorruption> corruptions = options.corruptions;
+  if (corruptions.empty()) {
+    for (size_t c = 1; c < static_cast<size_t>(PSCorruption::NUM); c++) {
+      corruptions.push_back(static_cast<PSCorruption>(c));
+    }
+  }
+
+  // proofs and keys draw from the thread source, attributes and corruptions from their own stream
+  PSSeededThread seeded(options.seed);
+  PSChaChaDrbg choices(options.seed + "/choices");
+  uint64_t invalid_threshold = options.invalid_ratio >= 1
+                                 ? UINT64_MAX
+                                 : static_cast<uint64_t>(options.invalid_ratio * 18446744073709551616.0);
+
+  PSCorpusWriter writer(os);
+  G1 g, h, authority_pk;
+  G2 gg;
+  hashAndMapToG1(g, "ps-corpus-g");
+  hashAndMapToG2(gg, "ps-corpus-gg");
+  hashAndMapToG1(h, "ps-corpus-h");
+  Fr _authority_sk;
+  PSRandom::generateFr(_authority_sk);
+  G1::mul(authority_pk, g, _authority_sk);
+  PSBuffer authority;
+  authority.appendG1Element(authority_pk);
+  authority.appendG1Element(g);
+  authority.appendG1Element(h);
+  writer.append(PSCorpusKind::AUTHORITY, PSCorruption::NONE, {}, authority);
+
+  size_t record_index = 0;
+  for (size_t attribute_num : options.attribute_nums) {
+    PSSigner idp(attribute_num, g, gg);
+    PSPubKey pk = idp.key_gen();
+    if (!options.key_prefix.empty()) {
+      idp.save_key(options.key_prefix + "-" + std::to_string(attribute_num) + ".key");
+    }
+    writer.append(PSCorpusKind::PUBKEY, PSCorruption::NONE, {}, pk.toBufferString());
+    PSRequester user(pk);
+
+    for (double hidden_ratio : options.hidden_ratios) {
+      size_t hidden_num = std::min(attribute_num, std::max<size_t>(2, std::lround(hidden_ratio * attribute_num)));
+      for (auto kind : options.kinds) {
+        bool is_proof = kind == PSCorpusKind::PROOF || kind == PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL;
+        std::vector<PSCorruption> applicable;
+        for (auto corruption : corruptions) {
+          // a proof over committed attributes only has no plaintext attribute to change
+          if (appliesTo(corruption, kind) &&
+              !(is_proof && corruption == PSCorruption::ATTRIBUTE && hidden_num == attribute_num)) {
+            applicable.push_back(corruption);
+          }
+        }
+
+        for (size_t i = 0; i < options.record_num; i++, record_index++) {
+          std::vector<std::tuple<std::string, bool>> attributes;
+          for (size_t j = 0; j < attribute_num; j++) {
+            attributes.emplace_back(drawAttribute(choices, options.attribute_size), j < hidden_num);
+          }
+          PSCorruption corruption = PSCorruption::NONE;
+          if (!applicable.empty() && drawUint64(choices) < invalid_threshold) {
+            corruption = applicable[drawUint64(choices) % applicable.size()];
+          }
+          std::string associated_data = "corpus-" + std::to_string(record_index);
+          std::string service_name = "service-" + std::to_string(record_index % 16);
+          Fr _delta;
+          PSRandom::generateFr(_delta);
+
+          std::vector<std::string> context;
+          PSBuffer object;
+          PSBlindingContext blinding;
+          auto request = user.el_passo_request_id(attributes, associated_data, blinding);
+          if (kind == PSCorpusKind::REQUEST) {
+            context = {associated_data};
+            if (corruption == PSCorruption::CHALLENGE) {
+              Fr::add(request.c, request.c, _delta);
+            }
+            else if (corruption == PSCorruption::RESPONSE) {
+              Fr::add(request.rs[0], request.rs[0], _delta);
+            }
+            else if (corruption == PSCorruption::CONTEXT) {
+              context[0] += "'";
+            }
+            object = request.toBufferString();
+          }
+          else {
+            PSCredential sig;
+            if (!idp.el_passo_provide_id(request, associated_data, sig)) {
+              throw std::runtime_error("corpus credential issuance failed");
+            }
+            sig = user.unblind_credential(sig, blinding);
+            if (kind == PSCorpusKind::CREDENTIAL) {
+              for (const auto& attribute : attributes) {
+                context.push_back(std::get<0>(attribute));
+              }
+              if (corruption == PSCorruption::SIGNATURE) {
+                G1::add(sig.sig2, sig.sig2, g);
+              }
+              else if (corruption == PSCorruption::ATTRIBUTE) {
+                context.back() += "'";
+              }
+              object = sig.toBufferString();
+            }
+            else {
+              context = {associated_data, service_name};
+              IdProof proof = kind == PSCorpusKind::PROOF
+                                ? user.el_passo_prove_id(sig, attributes, associated_data, service_name,
+                                                         authority_pk, g, h)
+                                : user.el_passo_prove_id_without_id_retrieval(sig, attributes, associated_data,
+                                                                              service_name);
+              if (corruption == PSCorruption::CHALLENGE) {
+                Fr::add(proof.c, proof.c, _delta);
+              }
+              else if (corruption == PSCorruption::RESPONSE) {
+                Fr::add(proof.rs[0], proof.rs[0], _delta);
+              }
+              else if (corruption == PSCorruption::SIGNATURE) {
+                G1::add(proof.sig2, proof.sig2, g);
+              }
+              else if (corruption == PSCorruption::ATTRIBUTE) {
+                proof.attributes.back() += "'";
+              }
+              else if (corruption == PSCorruption::CONTEXT) {
+                context[1] += "'";
+              }
+              object = proof.toBufferString();
+            }
+          }
+          if (corruption == PSCorruption::TRUNCATED) {
+            object.resize(object.size() / 2);
+          }
+          writer.append(kind, corruption, context, object);
+        }
+      }
+    }
+  }
+}
+
+const char*
+PSCorpus::kindName(PSCorpusKind kind)
+{
+  return kind < PSCorpusKind::NUM ? KIND_NAMES[static_cast<size_t>(kind)] : "unknown";
+}
+
+const char*
+PSCorpus::corruptionName(PSCorruption corruption)
+{
+  return corruption < PSCorruption::NUM ? CORRUPTION_NAMES[static_cast<size_t>(corruption)] : "unknown";
+}
+
+PSCorpusKind
+PSCorpus::kindOf(const std::string& name)
+{
+  for (size_t k = 0; k < static_cast<size_t>(PSCorpusKind::NUM); k++) {
+    if (name == KIND_NAMES[k]) {
+      return static_cast<PSCorpusKind>(k);
+    }
+  }
+  return PSCorpusKind::NUM;
+}
+
+PSCorruption
+PSCorpus::corruptionOf(const std::string& name)
+{
+  for (size_t c = 0; c < static_cast<size_t>(PSCorruption::NUM); c++) {
+    if (name == CORRUPTION_NAMES[c]) {
+      return static_cast<PSCorruption>(c);
+    }
+  }
+  return PSCorruption::NUM;
+}
+
+bool
+PSCorpus::appliesTo(PSCorruption corruption, PSCorpusKind kind)
+{
+  bool is_proof = kind == PSCorpusKind::PROOF || kind == PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL;
+  bool is_object = kind == PSCorpusKind::REQUEST || kind == PSCorpusKind::CREDENTIAL || is_proof;
+  if (corruption == PSCorruption::NONE || corruption == PSCorruption::TRUNCATED) {
+    return is_object;
+  }
+  if (corruption == PSCorruption::CHALLENGE || corruption == PSCorruption::RESPONSE ||
+      corruption == PSCorruption::CONTEXT) {
+    return kind == PSCorpusKind::REQUEST || is_proof;
+  }
+  if (corruption == PSCorruption::SIGNATURE || corruption == PSCorruption::ATTRIBUTE) {
+    return kind == PSCorpusKind::CREDENTIAL || is_proof;
+  }
+  return false;
+}
@@ -0,0 +1,160 @@
+#ifndef PS_SRC_PS_CORPUS_H_
+#define PS_SRC_PS_CORPUS_H_
+
+#include "ps-encoding.h"
+#include "ps-precompute.h"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief What a corpus record holds.
+ */
+enum class PSCorpusKind : uint8_t {
+  PUBKEY,                      // object: PSPubKey of the records that follow
+  AUTHORITY,                   // object: authority_pk, g and h as G1 elements, for the records that follow
+  REQUEST,                     // context: associated data; object: PSCredRequest
+  CREDENTIAL,                  // context: all attributes; object: unblinded PSCredential
+  PROOF,                       // context: associated data, service name; object: IdProof
+  PROOF_WITHOUT_ID_RETRIEVAL,  // context: associated data, service name; object: IdProof without E1, E2
+  NUM
+};
+
+/**
+ * @brief How a record was made invalid on purpose.
+ */
+enum class PSCorruption : uint8_t {
+  NONE,
+  CHALLENGE,  // c of a request or proof is changed
+  RESPONSE,   // the first response in rs of a request or proof is changed
+  SIGNATURE,  // sig2 of a credential or proof is changed
+  ATTRIBUTE,  // a plaintext attribute of a credential or proof is changed
+  CONTEXT,    // the associated data of a request or the service name of a proof is changed
+  TRUNCATED,  // the encoding is cut in half, so it does not decode
+  NUM
+};
+
+/**
+ * @brief One record of a corpus file.
+ */
+struct PSCorpusRecord {
+  PSCorpusKind kind;
+  PSCorruption corruption;
+  std::vector<std::string> context;
+  PSBuffer object;
+
+  bool
+  expectedValid() const
+  {
+    return corruption == PSCorruption::NONE;
+  }
+};
+
+/**
+ * @brief Writes a corpus file: the magic "PSCORPUS" and a 4-byte big-endian version, then records, each
+ *        a 4-byte big-endian length followed by kind (1 byte), corruption (1 byte), the context as a
+ *        PSBuffer string list, and the encoded object.
+ */
+class PSCorpusWriter {
+public:
+  static constexpr uint32_t VERSION = 1;
+
+public:
+  /**
+   * @brief Write the file header to @p os.
+   */
+  explicit PSCorpusWriter(std::ostream& os);
+
+  /**
+   * @throw std::runtime_error if the record is too large or cannot be written.
+   */
+  void
+  append(PSCorpusKind kind, PSCorruption corruption, const std::vector<std::string>& context,
+         const PSBuffer& object);
+
+private:
+  std::ostream& m_os;
+  PSBuffer m_record;
+};
+
+/**
+ * @brief Reads the records of a memory-mapped corpus file one by one, dropping the pages already read.
+ */
+class PSCorpusReader {
+public:
+  /**
+   * @throw std::runtime_error if the file cannot be mapped or is not a corpus of this version.
+   */
+  explicit PSCorpusReader(const std::string& path);
+
+  /**
+   * @brief Read the next record into @p record. Returns false at the end of the file.
+   * @throw std::runtime_error if the record is truncated or malformed.
+   */
+  bool
+  next(PSCorpusRecord& record);
+
+private:
+  std::shared_ptr<PSMappedRegion> m_region;
+  size_t m_offset;
+  size_t m_released;  // pages before this offset were dropped
+};
+
+struct PSCorpusOptions {
+  std::string seed = "ps-corpus";
+  std::vector<size_t> attribute_nums = {8};
+  std::vector<double> hidden_ratios = {0.25};                       // committed share of the attributes, at least 2
+  std::vector<PSCorpusKind> kinds = {PSCorpusKind::REQUEST, PSCorpusKind::CREDENTIAL, PSCorpusKind::PROOF};
+  size_t record_num = 100;                                          // per kind, attribute count and hidden ratio
+  double invalid_ratio = 0.1;                                       // share of records with a corruption
+  std::vector<PSCorruption> corruptions;                            // empty for all that apply to a kind
+  size_t attribute_size = 16;                                       // bytes per attribute
+  std::string key_prefix;                                           // if set, signer keys go to PREFIX-N.key
+};
+
+/**
+ * @brief Reproducible corpora of valid and invalid requests, credentials and proofs.
+ */
+class PSCorpus {
+public:
+  /**
+   * @brief Write a corpus to @p os. The same options always produce the same bytes.
+   *
+   * For each attribute count, a PUBKEY record and then, for each hidden ratio and kind, record_num
+   * records. The first max(2, hidden ratio * attribute count) attributes are committed. Keys and
+   * proofs are drawn from a PSChaChaDrbg seeded with @p options.seed on the calling thread, so the
+   * corpus must never be used as real credentials.
+   *
+   * @throw std::runtime_error if the options are invalid or the corpus cannot be written.
+   */
+  static void
+  generate(const PSCorpusOptions& options, std::ostream& os);
+
+  static const char*
+  kindName(PSCorpusKind kind);
+
+  static const char*
+  corruptionName(PSCorruption corruption);
+
+  /**
+   * @brief The kind named @p name, e.g., "proof". PSCorpusKind::NUM if there is none.
+   */
+  static PSCorpusKind
+  kindOf(const std::string& name);
+
+  /**
+   * @brief The corruption named @p name, e.g., "challenge". PSCorruption::NUM if there is none.
+   */
+  static PSCorruption
+  corruptionOf(const std::string& name);
+
+  /**
+   * @brief Whether @p corruption can be applied to a record of @p kind.
+   */
+  static bool
+  appliesTo(PSCorruption corruption, PSCorpusKind kind);
+};
+
+#endif  // PS_SRC_PS_CORPUS_H_
@@ -0,0 +1,45 @@
+#ifndef PS_SRC_PS_CURVE_H_
+#define PS_SRC_PS_CURVE_H_
+
+#include <mcl/bls12_381.hpp>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief The pairing-friendly curve of this build, BN254 by default or BLS12-381 if built with
+ *        -DPS_CURVE_BLS12_381 (e.g., "make bls12-381").
+ *
+ * MCL implements every curve with the same G1, G2, GT and Fr types (mcl::bls12 is mcl::bn) sized for
+ * 384-bit fields, and fixes the curve when the pairing is initialized. So the PS classes are the same
+ * code for both curves, and a build only differs in the curve PSCurve::init() selects. Keys, credentials
+ * and proofs of one curve cannot be used with the other; key files are rejected when loaded.
+ *
+ * BN254 stays the default because plain initPairing(), which earlier versions called, selects it, so
+ * existing keys, credentials, proofs and the WASM modules keep working.
+ */
+class PSCurve {
+public:
+#ifdef PS_CURVE_BLS12_381
+  static constexpr const char* NAME = "BLS12-381";
+#else
+  static constexpr const char* NAME = "BN254";
+#endif
+
+public:
+  /**
+   * @brief Initialize MCL with the curve of this build.
+   *
+   * Must be called before any other function of this library, e.g., at the beginning of main().
+   */
+  static void
+  init()
+  {
+#ifdef PS_CURVE_BLS12_381
+    initPairing(mcl::BLS12_381);
+#else
+    initPairing(mcl::BN254);
+#endif
+  }
+};
+
+#endif  // PS_SRC_PS_CURVE_H_
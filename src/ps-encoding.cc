@@ -1,6 +1,10 @@
 #include "ps-encoding.h"
+#include "ps-instrumentation.h"
 
-char buf[1024];
+#include <stdexcept>
+
+// scratch space for serialization, per thread so that encoding can run on several threads
+static thread_local char buf[1024];
 
 static const std::string base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
@@ -95,6 +99,15 @@ base64_decode(const std::string& encoded_string)
   return ret;
 }
 
+// reject an element running past the end of the buffer before handing it to MCL
+static void
+checkElementEnd(const PSBuffer& buffer, size_t end)
+{
+  if (end > buffer.size()) {
+    throw std::out_of_range("PSBuffer: element exceeds the buffer");
+  }
+}
+
 static size_t
 probeVarSize(size_t var)
 {
@@ -109,6 +122,7 @@ probeVarSize(size_t var)
 
 PSBuffer
 PSBuffer::fromBase64(const std::string& base64Str) {
+  PS_PHASE(BUFFER, DECODE);
   auto vec = base64_decode(base64Str);
   PSBuffer buf;
   buf.insert(buf.end(), vec.begin(), vec.end());
@@ -117,6 +131,7 @@ PSBuffer::fromBase64(const std::string& base64Str) {
 
 std::string
 PSBuffer::toBase64() {
+  PS_PHASE(BUFFER, ENCODE);
   return base64_encode(this->data(), this->size());
 }
 
@@ -189,6 +204,7 @@ PSBuffer::parseG1Element(size_t offset, G1& g, bool withType) const
   }
   size_t size = 0;
   step += this->parseVar(offset + step, size);
+  checkElementEnd(*this, offset + step + size);
   g.deserialize(this->data() + offset + step, size);
   return step + size;
 }
@@ -221,6 +237,7 @@ PSBuffer::parseG2Element(size_t offset, G2& g, bool withType) const
   }
   size_t size = 0;
   step += this->parseVar(offset + step, size);
+  checkElementEnd(*this, offset + step + size);
   g.deserialize(this->data() + offset + step, size);
   return step + size;
 }
@@ -253,6 +270,7 @@ PSBuffer::parseFrElement(size_t offset, Fr& f, bool withType) const
   }
   size_t size = 0;
   step += this->parseVar(offset + step, size);
+  checkElementEnd(*this, offset + step + size);
   f.deserialize(this->data() + offset + step, size);
   return step + size;
 }
@@ -384,6 +402,7 @@ PSBuffer::parseStrList(size_t offset, std::vector<std::string>& strs) const
 PSBuffer
 PSCredential::toBufferString()
 {
+  PS_PHASE(BUFFER, ENCODE);
   PSBuffer buffer;
   buffer.appendG1Element(sig1);
   buffer.appendG1Element(sig2);
@@ -393,6 +412,7 @@ PSCredential::toBufferString()
 PSCredential
 PSCredential::fromBufferString(const PSBuffer& buf)
 {
+  PS_PHASE(BUFFER, DECODE);
   PSCredential credential;
   size_t step = 0;
   step += buf.parseG1Element(step, credential.sig1);
@@ -403,6 +423,7 @@ PSCredential::fromBufferString(const PSBuffer& buf)
 PSBuffer
 PSPubKey::toBufferString()
 {
+  PS_PHASE(BUFFER, ENCODE);
   PSBuffer buffer;
   buffer.appendG1Element(g);
   buffer.appendG2Element(gg);
@@ -415,6 +436,7 @@ PSPubKey::toBufferString()
 PSPubKey
 PSPubKey::fromBufferString(const PSBuffer& buf)
 {
+  PS_PHASE(BUFFER, DECODE);
   PSPubKey pubKey;
   size_t step = 0;
   step += buf.parseG1Element(step, pubKey.g);
@@ -428,6 +450,7 @@ PSPubKey::fromBufferString(const PSBuffer& buf)
 PSBuffer
 PSCredRequest::toBufferString()
 {
+  PS_PHASE(BUFFER, ENCODE);
   PSBuffer buffer;
   buffer.appendG1Element(A);
   buffer.appendFrElement(c);
@@ -439,6 +462,7 @@ PSCredRequest::toBufferString()
 PSCredRequest
 PSCredRequest::fromBufferString(const PSBuffer& buf)
 {
+  PS_PHASE(BUFFER, DECODE);
   PSCredRequest request;
   size_t step = 0;
   step += buf.parseG1Element(step, request.A);
@@ -451,6 +475,7 @@ PSCredRequest::fromBufferString(const PSBuffer& buf)
 PSBuffer
 IdProof::toBufferString()
 {
+  PS_PHASE(BUFFER, ENCODE);
   PSBuffer buffer;
   buffer.appendG1Element(sig1);
   buffer.appendG1Element(sig2);
@@ -469,6 +494,7 @@ IdProof::toBufferString()
 IdProof
 IdProof::fromBufferString(const PSBuffer& buf)
 {
+  PS_PHASE(BUFFER, DECODE);
   IdProof proof;
   size_t step = 0;
   step += buf.parseG1Element(step, proof.sig1);
@@ -1,8 +1,9 @@
 #ifndef PS_SRC_ENCODING_H_
 #define PS_SRC_ENCODING_H_
 
+#include "ps-curve.h"
+
 #include <iostream>
-#include <mcl/bls12_381.hpp>
 #include <optional>
 #include <string>
 #include <vector>
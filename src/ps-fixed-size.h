@@ -0,0 +1,582 @@
+#ifndef PS_SRC_PS_FIXED_SIZE_H_
+#define PS_SRC_PS_FIXED_SIZE_H_
+
+#include "ps-random.h"
+#include "ps-signer.h"
+#include "ps-transcript.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+using namespace mcl::bls12;
+
+/**
+ * Variants of the PS classes for deployments whose attribute number N is fixed at compile time.
+ *
+ * Public keys, proofs and requests are held in std::array, and which attribute slots are committed
+ * (hidden) is a constexpr bit mask, bit i for slot i. Loops over the slots are unrolled, hidden and
+ * plaintext slots are told apart without comparing strings, and nothing is allocated on the heap.
+ * The dynamic classes stay the default; fromX()/toX() convert at the encoding boundary.
+ */
+
+/**
+ * @brief The number of committed slots of a hidden-slot mask.
+ */
+constexpr size_t
+psHiddenNum(uint64_t hidden_mask)
+{
+  size_t _num = 0;
+  for (; hidden_mask != 0; hidden_mask &= hidden_mask - 1) {
+    _num++;
+  }
+  return _num;
+}
+
+/**
+ * @brief The number of committed slots before slot @p i, i.e., the index of slot @p i among
+ *        the committed (or the plaintext) slots.
+ */
+constexpr size_t
+psHiddenRank(uint64_t hidden_mask, size_t i)
+{
+  return i == 0 ? 0 : psHiddenNum(hidden_mask << (64 - i));
+}
+
+// calls f(std::integral_constant<size_t, I>()) for every I in [0, N), unrolled
+template<class F, size_t... I>
+inline void
+psUnroll(F& f, std::index_sequence<I...>)
+{
+  (f(std::integral_constant<size_t, I>()), ...);
+}
+
+template<size_t N, class F>
+inline void
+psUnroll(F&& f)
+{
+  psUnroll(f, std::make_index_sequence<N>());
+}
+
+/**
+ * @brief A PSPubKey over exactly N attributes.
+ */
+template<size_t N>
+class PSPubKeyN {
+public:
+  static_assert(N >= 1 && N <= 64, "attribute number must be in [1, 64]");
+
+  G1 g;
+  G2 gg;
+  G2 XX;
+  std::array<G1, N> Yi;
+  std::array<G2, N> YYi;
+
+public:
+  /**
+   * @throw std::runtime_error if @p pk is not over N attributes.
+   */
+  static PSPubKeyN
+  fromPubKey(const PSPubKey& pk);
+
+  PSPubKey
+  toPubKey() const;
+};
+
+/**
+ * @brief The slots of a credential over N attributes, with the committed ones fixed by HIDDEN_MASK.
+ */
+template<size_t N, uint64_t HIDDEN_MASK>
+class PSSlotsN {
+public:
+  static_assert(N >= 1 && N <= 64, "attribute number must be in [1, 64]");
+  static_assert(N == 64 || (HIDDEN_MASK >> N) == 0, "hidden slot beyond the attribute number");
+
+  static constexpr size_t HIDDEN_NUM = psHiddenNum(HIDDEN_MASK);
+  static constexpr size_t PLAIN_NUM = N - HIDDEN_NUM;
+
+  static constexpr bool
+  isHidden(size_t i)
+  {
+    return (HIDDEN_MASK >> i) & 1;
+  }
+
+  // the index of slot i among the committed slots if it is hidden, or among the plaintext ones otherwise
+  static constexpr size_t
+  rank(size_t i)
+  {
+    return isHidden(i) ? psHiddenRank(HIDDEN_MASK, i) : i - psHiddenRank(HIDDEN_MASK, i);
+  }
+
+  // whether the placeholders of @p attributes are exactly the committed slots
+  template<class S>
+  static bool
+  matches(const std::vector<S>& attributes);
+};
+
+/**
+ * @brief A PSCredRequest over N attributes whose committed slots are fixed by HIDDEN_MASK.
+ *
+ * Attributes are views, e.g., into the PSCredRequest they were converted from, which must outlive them.
+ * Views of committed slots are ignored.
+ */
+template<size_t N, uint64_t HIDDEN_MASK>
+class PSCredRequestN : public PSSlotsN<N, HIDDEN_MASK> {
+public:
+  G1 A;
+  Fr c;
+  std::array<Fr, PSSlotsN<N, HIDDEN_MASK>::HIDDEN_NUM + 1> rs;
+  std::array<std::string_view, N> attributes;
+
+public:
+  /**
+   * @throw std::runtime_error if the layout of @p request does not match N and HIDDEN_MASK.
+   */
+  static PSCredRequestN
+  fromCredRequest(const PSCredRequest& request);
+
+  PSCredRequest
+  toCredRequest() const;
+};
+
+/**
+ * @brief An IdProof over N attributes whose committed slots are fixed by HIDDEN_MASK.
+ *
+ * As in IdProof, rs holds one response per committed slot (s and gamma first), then r2 and, with the
+ * identity retrieval token only, r3; the last entry is unused without it. Attributes are views that must
+ * outlive the proof, and views of committed slots are ignored.
+ */
+template<size_t N, uint64_t HIDDEN_MASK>
+class IdProofN : public PSSlotsN<N, HIDDEN_MASK> {
+public:
+  G1 sig1;
+  G1 sig2;
+  G2 k;
+  G1 phi;
+  Fr c;
+  std::array<Fr, PSSlotsN<N, HIDDEN_MASK>::HIDDEN_NUM + 2> rs;
+  std::array<std::string_view, N> attributes;
+  std::optional<G1> E1;
+  std::optional<G1> E2;
+
+public:
+  /**
+   * @throw std::runtime_error if the layout of @p proof does not match N and HIDDEN_MASK.
+   */
+  static IdProofN
+  fromIdProof(const IdProof& proof);
+
+  IdProof
+  toIdProof() const;
+};
+
+/**
+ * @brief A PSSigner over exactly N attributes.
+ */
+template<size_t N>
+class PSSignerN {
+public:
+  /**
+   * @brief Use the key pair of @p signer.
+   *
+   * @throw std::runtime_error if @p signer is not over N attributes or has no key.
+   */
+  explicit PSSignerN(const PSSigner& signer);
+
+  const PSPubKeyN<N>&
+  get_pub_key() const;
+
+  /**
+   * @brief EL PASSO ProvideID, as PSSigner::el_passo_provide_id().
+   *
+   * V and the commitment are each one multi-scalar multiplication over stack arrays.
+   */
+  template<uint64_t HIDDEN_MASK>
+  bool
+  el_passo_provide_id(const PSCredRequestN<N, HIDDEN_MASK>& request,
+                      std::string_view associated_data, PSCredential& sig) const;
+
+private:
+  G1 m_sk_X;
+  PSPubKeyN<N> m_pk;
+};
+
+/**
+ * @brief A PSVerifier over exactly N attributes.
+ */
+template<size_t N>
+class PSVerifierN {
+public:
+  /**
+   * @throw std::runtime_error if @p pk is not over N attributes.
+   */
+  explicit PSVerifierN(const PSPubKey& pk);
+
+  /**
+   * @brief EL PASSO VerifyID, as PSVerifier::el_passo_verify_id().
+   *
+   * V_k and the plaintext attribute terms are each one multi-scalar multiplication over stack arrays.
+   */
+  template<uint64_t HIDDEN_MASK>
+  bool
+  el_passo_verify_id(const IdProofN<N, HIDDEN_MASK>& proof,
+                     std::string_view associated_data,
+                     std::string_view service_name,
+                     const G1& authority_pk, const G1& g, const G1& h) const;
+
+  template<uint64_t HIDDEN_MASK>
+  bool
+  el_passo_verify_id_without_id_retrieval(const IdProofN<N, HIDDEN_MASK>& proof,
+                                          std::string_view associated_data,
+                                          std::string_view service_name) const;
+
+private:
+  // V_k = k^c * XX^(1-c) * PI{ YYj^r1_j } * gg^r2
+  template<uint64_t HIDDEN_MASK>
+  void
+  commit_k(G2& V_k, const IdProofN<N, HIDDEN_MASK>& proof, const Fr& r2) const;
+
+  // e(sig1, k * PI{ YYi^hash(attribute_i) }) == e(sig2, gg) over the plaintext slots
+  template<uint64_t HIDDEN_MASK>
+  bool
+  check_signature(const IdProofN<N, HIDDEN_MASK>& proof) const;
+
+private:
+  PSPubKeyN<N> m_pk;
+};
+
+// ******************************** implementation ********************************
+
+template<size_t N>
+PSPubKeyN<N>
+PSPubKeyN<N>::fromPubKey(const PSPubKey& pk)
+{
+  if (pk.Yi.size() != N || pk.YYi.size() != N) {
+    throw std::runtime_error("public key does not match the attribute number");
+  }
+  PSPubKeyN<N> _pk;
+  _pk.g = pk.g;
+  _pk.gg = pk.gg;
+  _pk.XX = pk.XX;
+  std::copy(pk.Yi.begin(), pk.Yi.end(), _pk.Yi.begin());
+  std::copy(pk.YYi.begin(), pk.YYi.end(), _pk.YYi.begin());
+  return _pk;
+}
+
+template<size_t N>
+PSPubKey
+PSPubKeyN<N>::toPubKey() const
+{
+  PSPubKey _pk;
+  _pk.g = g;
+  _pk.gg = gg;
+  _pk.XX = XX;
+  _pk.Yi.assign(Yi.begin(), Yi.end());
+  _pk.YYi.assign(YYi.begin(), YYi.end());
+  return _pk;
+}
+
+template<size_t N, uint64_t HIDDEN_MASK>
+template<class S>
+bool
+PSSlotsN<N, HIDDEN_MASK>::matches(const std::vector<S>& attributes)
+{
+  if (attributes.size() != N) {
+    return false;
+  }
+  for (size_t i = 0; i < N; i++) {
+    if (attributes[i].empty() != isHidden(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<size_t N, uint64_t HIDDEN_MASK>
+PSCredRequestN<N, HIDDEN_MASK>
+PSCredRequestN<N, HIDDEN_MASK>::fromCredRequest(const PSCredRequest& request)
+{
+  PSCredRequestN _request;
+  if (!_request.matches(request.attributes) || request.rs.size() != _request.rs.size()) {
+    throw std::runtime_error("request does not match the attribute layout");
+  }
+  _request.A = request.A;
+  _request.c = request.c;
+  std::copy(request.rs.begin(), request.rs.end(), _request.rs.begin());
+  std::copy(request.attributes.begin(), request.attributes.end(), _request.attributes.begin());
+  return _request;
+}
+
+template<size_t N, uint64_t HIDDEN_MASK>
+PSCredRequest
+PSCredRequestN<N, HIDDEN_MASK>::toCredRequest() const
+{
+  PSCredRequest _request;
+  _request.A = A;
+  _request.c = c;
+  _request.rs.assign(rs.begin(), rs.end());
+  for (size_t i = 0; i < N; i++) {
+    _request.attributes.emplace_back(this->isHidden(i) ? std::string_view() : attributes[i]);
+  }
+  return _request;
+}
+
+template<size_t N, uint64_t HIDDEN_MASK>
+IdProofN<N, HIDDEN_MASK>
+IdProofN<N, HIDDEN_MASK>::fromIdProof(const IdProof& proof)
+{
+  IdProofN _proof;
+  size_t _rs_num = proof.E1.has_value() ? _proof.rs.size() : _proof.rs.size() - 1;
+  if (!_proof.matches(proof.attributes) || proof.rs.size() != _rs_num ||
+      proof.E1.has_value() != proof.E2.has_value()) {
+    throw std::runtime_error("proof does not match the attribute layout");
+  }
+  _proof.sig1 = proof.sig1;
+  _proof.sig2 = proof.sig2;
+  _proof.k = proof.k;
+  _proof.phi = proof.phi;
+  _proof.c = proof.c;
+  std::copy(proof.rs.begin(), proof.rs.end(), _proof.rs.begin());
+  std::copy(proof.attributes.begin(), proof.attributes.end(), _proof.attributes.begin());
+  _proof.E1 = proof.E1;
+  _proof.E2 = proof.E2;
+  return _proof;
+}
+
+template<size_t N, uint64_t HIDDEN_MASK>
+IdProof
+IdProofN<N, HIDDEN_MASK>::toIdProof() const
+{
+  IdProof _proof;
+  _proof.sig1 = sig1;
+  _proof.sig2 = sig2;
+  _proof.k = k;
+  _proof.phi = phi;
+  _proof.c = c;
+  _proof.rs.assign(rs.begin(), E1.has_value() ? rs.end() : rs.end() - 1);
+  for (size_t i = 0; i < N; i++) {
+    _proof.attributes.emplace_back(this->isHidden(i) ? std::string_view() : attributes[i]);
+  }
+  _proof.E1 = E1;
+  _proof.E2 = E2;
+  return _proof;
+}
+
+template<size_t N>
+PSSignerN<N>::PSSignerN(const PSSigner& signer)
+    : m_sk_X(signer.m_sk_X)
+{
+  m_pk = PSPubKeyN<N>::fromPubKey(signer.m_pk);
+}
+
+template<size_t N>
+const PSPubKeyN<N>&
+PSSignerN<N>::get_pub_key() const
+{
+  return m_pk;
+}
+
+template<size_t N>
+template<uint64_t HIDDEN_MASK>
+bool
+PSSignerN<N>::el_passo_provide_id(const PSCredRequestN<N, HIDDEN_MASK>& request,
+                                  std::string_view associated_data, PSCredential& sig) const
+{
+  using Request = PSCredRequestN<N, HIDDEN_MASK>;
+  // V: A^c * g^r0 * PI{ Yi^ri } over committed slots, plaintext terms: PI{ Yi^hash(attribute_i) }
+  std::array<G1, Request::HIDDEN_NUM + 2> _bases;
+  std::array<Fr, Request::HIDDEN_NUM + 2> _scalars;
+  std::array<G1, Request::PLAIN_NUM> _plain_bases;
+  std::array<Fr, Request::PLAIN_NUM> _plain_hashes;
+  _bases[0] = request.A;
+  _scalars[0] = request.c;
+  _bases[1] = m_pk.g;
+  _scalars[1] = request.rs[0];
+  psUnroll<N>([&](auto i) {
+    constexpr size_t I = decltype(i)::value;
+    if constexpr (Request::isHidden(I)) {
+      _bases[Request::rank(I) + 2] = m_pk.Yi[I];
+      _scalars[Request::rank(I) + 2] = request.rs[Request::rank(I) + 1];
+    }
+    else {
+      _plain_bases[Request::rank(I)] = m_pk.Yi[I];
+      _plain_hashes[Request::rank(I)].setHashOf(request.attributes[I].data(), request.attributes[I].size());
+    }
+  });
+  G1 _V;
+  G1::mulVec(_V, _bases.data(), _scalars.data(), _bases.size());
+
+  Fr _m_c;
+  PSTranscript transcript;
+  transcript.append(request.A);
+  transcript.append(_V);
+  transcript.challenge(_m_c, associated_data);
+  if (_m_c != request.c) {
+    return false;
+  }
+
+  G1 _commitment = request.A;
+  if constexpr (Request::PLAIN_NUM > 0) {
+    G1 _plain_sum;
+    G1::mulVec(_plain_sum, _plain_bases.data(), _plain_hashes.data(), _plain_bases.size());
+    G1::add(_commitment, _commitment, _plain_sum);
+  }
+  // sig1 = g^u, sig2 = (X * commitment)^u
+  Fr _u;
+  PSRandom::generateFr(_u);
+  G1::mul(sig.sig1, m_pk.g, _u);
+  G1::add(sig.sig2, m_sk_X, _commitment);
+  G1::mul(sig.sig2, sig.sig2, _u);
+  return true;
+}
+
+template<size_t N>
+PSVerifierN<N>::PSVerifierN(const PSPubKey& pk)
+    : m_pk(PSPubKeyN<N>::fromPubKey(pk))
+{
+}
+
+template<size_t N>
+template<uint64_t HIDDEN_MASK>
+bool
+PSVerifierN<N>::el_passo_verify_id(const IdProofN<N, HIDDEN_MASK>& proof,
+                                   std::string_view associated_data,
+                                   std::string_view service_name,
+                                   const G1& authority_pk, const G1& g, const G1& h) const
+{
+  using Proof = IdProofN<N, HIDDEN_MASK>;
+  static_assert(Proof::HIDDEN_NUM >= 2, "s and gamma must be committed");
+  if (!proof.E1.has_value() || !proof.E2.has_value()) {
+    return false;
+  }
+  G2 _V_k;
+  commit_k(_V_k, proof, proof.rs[Proof::HIDDEN_NUM]);
+
+  // V_phi = phi^c * hash(domain)^r1_s
+  G1 _V_phi, _V_E1, _V_E2, _temp;
+  G1::mul(_V_phi, proof.phi, proof.c);
+  hashAndMapToG1(_temp, service_name.data(), service_name.size());
+  G1::mul(_temp, _temp, proof.rs[0]);
+  G1::add(_V_phi, _V_phi, _temp);
+  // V_E1 = E1^c * g^r3
+  G1::mul(_V_E1, proof.E1.value(), proof.c);
+  G1::mul(_temp, g, proof.rs[Proof::HIDDEN_NUM + 1]);
+  G1::add(_V_E1, _V_E1, _temp);
+  // V_E2 = E2^c * y^r3 * h^r1_gamma
+  G1::mul(_V_E2, proof.E2.value(), proof.c);
+  G1::mul(_temp, authority_pk, proof.rs[Proof::HIDDEN_NUM + 1]);
+  G1::add(_V_E2, _V_E2, _temp);
+  G1::mul(_temp, h, proof.rs[1]);
+  G1::add(_V_E2, _V_E2, _temp);
+
+  // c = hash(k || phi || E1 || E2 || V_k || V_phi || V_E1 || V_E2 || associated_data )
+  Fr _local_c;
+  PSTranscript transcript;
+  transcript.append(proof.k);
+  transcript.append(proof.phi);
+  transcript.append(proof.E1.value());
+  transcript.append(proof.E2.value());
+  transcript.append(_V_k);
+  transcript.append(_V_phi);
+  transcript.append(_V_E1);
+  transcript.append(_V_E2);
+  transcript.challenge(_local_c, associated_data);
+  if (proof.c != _local_c) {
+    return false;
+  }
+  return check_signature(proof);
+}
+
+template<size_t N>
+template<uint64_t HIDDEN_MASK>
+bool
+PSVerifierN<N>::el_passo_verify_id_without_id_retrieval(const IdProofN<N, HIDDEN_MASK>& proof,
+                                                        std::string_view associated_data,
+                                                        std::string_view service_name) const
+{
+  using Proof = IdProofN<N, HIDDEN_MASK>;
+  static_assert(Proof::HIDDEN_NUM >= 1, "s must be committed");
+  G2 _V_k;
+  commit_k(_V_k, proof, proof.rs[Proof::HIDDEN_NUM]);
+
+  // V_phi = phi^c * hash(domain)^r1_s
+  G1 _V_phi, _temp;
+  G1::mul(_V_phi, proof.phi, proof.c);
+  hashAndMapToG1(_temp, service_name.data(), service_name.size());
+  G1::mul(_temp, _temp, proof.rs[0]);
+  G1::add(_V_phi, _V_phi, _temp);
+
+  // c = hash(k || phi || V_k || V_phi || associated_data )
+  Fr _local_c;
+  PSTranscript transcript;
+  transcript.append(proof.k);
+  transcript.append(proof.phi);
+  transcript.append(_V_k);
+  transcript.append(_V_phi);
+  transcript.challenge(_local_c, associated_data);
+  if (proof.c != _local_c) {
+    return false;
+  }
+  return check_signature(proof);
+}
+
+template<size_t N>
+template<uint64_t HIDDEN_MASK>
+void
+PSVerifierN<N>::commit_k(G2& V_k, const IdProofN<N, HIDDEN_MASK>& proof, const Fr& r2) const
+{
+  using Proof = IdProofN<N, HIDDEN_MASK>;
+  // bases: k, YYj of committed slots, gg, XX
+  std::array<G2, Proof::HIDDEN_NUM + 3> _bases;
+  std::array<Fr, Proof::HIDDEN_NUM + 3> _scalars;
+  _bases[0] = proof.k;
+  _scalars[0] = proof.c;
+  psUnroll<N>([&](auto i) {
+    constexpr size_t I = decltype(i)::value;
+    if constexpr (Proof::isHidden(I)) {
+      _bases[Proof::rank(I) + 1] = m_pk.YYi[I];
+      _scalars[Proof::rank(I) + 1] = proof.rs[Proof::rank(I)];
+    }
+  });
+  _bases[Proof::HIDDEN_NUM + 1] = m_pk.gg;
+  _scalars[Proof::HIDDEN_NUM + 1] = r2;
+  _bases[Proof::HIDDEN_NUM + 2] = m_pk.XX;
+  Fr::sub(_scalars[Proof::HIDDEN_NUM + 2], Fr::one(), proof.c);
+  G2::mulVec(V_k, _bases.data(), _scalars.data(), _bases.size());
+}
+
+template<size_t N>
+template<uint64_t HIDDEN_MASK>
+bool
+PSVerifierN<N>::check_signature(const IdProofN<N, HIDDEN_MASK>& proof) const
+{
+  using Proof = IdProofN<N, HIDDEN_MASK>;
+  G2 _final_k = proof.k;
+  if constexpr (Proof::PLAIN_NUM > 0) {
+    std::array<G2, Proof::PLAIN_NUM> _bases;
+    std::array<Fr, Proof::PLAIN_NUM> _hashes;
+    psUnroll<N>([&](auto i) {
+      constexpr size_t I = decltype(i)::value;
+      if constexpr (!Proof::isHidden(I)) {
+        _bases[Proof::rank(I)] = m_pk.YYi[I];
+        _hashes[Proof::rank(I)].setHashOf(proof.attributes[I].data(), proof.attributes[I].size());
+      }
+    });
+    G2 _plain_sum;
+    G2::mulVec(_plain_sum, _bases.data(), _hashes.data(), _bases.size());
+    G2::add(_final_k, _final_k, _plain_sum);
+  }
+  // e(sigma'_1, k) ?= e(sigma'_2, gg)
+  if (proof.sig1.isZero()) {
+    return false;
+  }
+  GT _lhs, _rhs;
+  pairing(_lhs, proof.sig1, _final_k);
+  pairing(_rhs, proof.sig2, m_pk.gg);
+  return _lhs == _rhs;
+}
+
+#endif  // PS_SRC_PS_FIXED_SIZE_H_
@@ -0,0 +1,139 @@
+#include "ps-instrumentation.h"
+#include "ps-trace.h"
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+static const char* const COMPONENT_NAMES[PSInstrumentation::COMPONENT_NUM] = {"signer", "requester", "verifier",
+                                                                              "buffer"};
+static const char* const PHASE_NAMES[PSInstrumentation::PHASE_NUM] = {"hash", "g1_mul", "g2_mul", "pairing",
+                                                                      "transcript", "encode", "decode"};
+
+// the counters of one thread, written by that thread only and read by snapshots
+struct PSThreadCounters {
+  std::atomic<uint64_t> calls[PSInstrumentation::COMPONENT_NUM][PSInstrumentation::PHASE_NUM] = {};
+  std::atomic<uint64_t> nanoseconds[PSInstrumentation::COMPONENT_NUM][PSInstrumentation::PHASE_NUM] = {};
+};
+
+// the counters of live threads, and the sum of those of exited threads
+struct PSCounterRegistry {
+  std::mutex mutex;
+  std::vector<PSThreadCounters*> threads;
+  PSInstrumentation::Snapshot exited;
+};
+
+static PSCounterRegistry&
+getRegistry()
+{
+  // never destroyed, so threads exiting after main() returns can still unregister
+  static PSCounterRegistry* registry = new PSCounterRegistry();
+  return *registry;
+}
+
+// registers the counters of its thread while the thread lives
+class PSThreadCounterSlot {
+public:
+  PSThreadCounterSlot()
+  {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.threads.push_back(&counters);
+  }
+
+  ~PSThreadCounterSlot()
+  {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (size_t c = 0; c < PSInstrumentation::COMPONENT_NUM; c++) {
+      for (size_t p = 0; p < PSInstrumentation::PHASE_NUM; p++) {
+        registry.exited.calls[c][p] += counters.calls[c][p].load(std::memory_order_relaxed);
+        registry.exited.nanoseconds[c][p] += counters.nanoseconds[c][p].load(std::memory_order_relaxed);
+      }
+    }
+    for (auto it = registry.threads.begin(); it != registry.threads.end(); ++it) {
+      if (*it == &counters) {
+        registry.threads.erase(it);
+        break;
+      }
+    }
+  }
+
+public:
+  PSThreadCounters counters;
+};
+
+static thread_local PSThreadCounterSlot s_slot;
+
+void
+PSInstrumentation::record(PSComponent component, PSPhase phase, std::chrono::steady_clock::time_point begin,
+                          std::chrono::steady_clock::time_point end)
+{
+  // a single writer, so plain loads and stores suffice
+  auto c = static_cast<size_t>(component);
+  auto p = static_cast<size_t>(phase);
+  uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+  auto& calls = s_slot.counters.calls[c][p];
+  auto& total = s_slot.counters.nanoseconds[c][p];
+  calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  total.store(total.load(std::memory_order_relaxed) + nanoseconds, std::memory_order_relaxed);
+  PSTracer::addSpan(COMPONENT_NAMES[c], PHASE_NAMES[p], begin, end);
+}
+
+PSInstrumentation::Snapshot
+PSInstrumentation::snapshot()
+{
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  Snapshot _snapshot = registry.exited;
+  for (const auto* counters : registry.threads) {
+    for (size_t c = 0; c < COMPONENT_NUM; c++) {
+      for (size_t p = 0; p < PHASE_NUM; p++) {
+        _snapshot.calls[c][p] += counters->calls[c][p].load(std::memory_order_relaxed);
+        _snapshot.nanoseconds[c][p] += counters->nanoseconds[c][p].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return _snapshot;
+}
+
+void
+PSInstrumentation::reset()
+{
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.exited = Snapshot();
+  for (auto* counters : registry.threads) {
+    for (size_t c = 0; c < COMPONENT_NUM; c++) {
+      for (size_t p = 0; p < PHASE_NUM; p++) {
+        counters->calls[c][p].store(0, std::memory_order_relaxed);
+        counters->nanoseconds[c][p].store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+std::string
+PSInstrumentation::Snapshot::toPrometheus() const
+{
+  std::ostringstream os;
+  os << "# HELP ps_phase_calls_total Number of times each phase ran.\n"
+     << "# TYPE ps_phase_calls_total counter\n";
+  for (size_t c = 0; c < COMPONENT_NUM; c++) {
+    for (size_t p = 0; p < PHASE_NUM; p++) {
+      os << "ps_phase_calls_total{component=\"" << COMPONENT_NAMES[c] << "\",phase=\"" << PHASE_NAMES[p]
+         << "\"} " << calls[c][p] << "\n";
+    }
+  }
+  os << "# HELP ps_phase_seconds_total Cumulative time spent in each phase.\n"
+     << "# TYPE ps_phase_seconds_total counter\n";
+  os.precision(9);
+  for (size_t c = 0; c < COMPONENT_NUM; c++) {
+    for (size_t p = 0; p < PHASE_NUM; p++) {
+      os << "ps_phase_seconds_total{component=\"" << COMPONENT_NAMES[c] << "\",phase=\"" << PHASE_NAMES[p]
+         << "\"} " << std::fixed << nanoseconds[c][p] / 1e9 << "\n";
+    }
+  }
+  return os.str();
+}
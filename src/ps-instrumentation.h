@@ -0,0 +1,129 @@
+#ifndef PS_SRC_PS_INSTRUMENTATION_H_
+#define PS_SRC_PS_INSTRUMENTATION_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief The class a timed phase runs in.
+ */
+enum class PSComponent : uint8_t {
+  SIGNER,
+  REQUESTER,
+  VERIFIER,
+  BUFFER,
+  NUM
+};
+
+/**
+ * @brief What a timed phase does.
+ */
+enum class PSPhase : uint8_t {
+  HASH,        // hashing attributes and service names to Fr, G1 or G2
+  G1_MUL,      // G1 scalar and multi-scalar multiplications
+  G2_MUL,      // G2 scalar and multi-scalar multiplications
+  PAIRING,     // Miller loops and final exponentiations
+  TRANSCRIPT,  // serializing points into the Fiat-Shamir transcript and deriving the challenge
+  ENCODE,      // PS data structures to PSBuffer and base64
+  DECODE,      // PSBuffer and base64 to PS data structures
+  NUM
+};
+
+/**
+ * @brief Per-phase call counters and cumulative nanosecond timers of PSSigner, PSRequester, PSVerifier
+ *        and PSBuffer.
+ *
+ * Only builds with PS_ENABLE_INSTRUMENTATION defined (e.g., "make INSTRUMENTATION=1") record anything.
+ * Otherwise PS_PHASE expands to nothing, so the library has no overhead, and snapshots are all zero.
+ * Each thread counts into its own slots, which snapshots add up together with the counts of threads
+ * that have exited.
+ */
+class PSInstrumentation {
+public:
+#ifdef PS_ENABLE_INSTRUMENTATION
+  static constexpr bool ENABLED = true;
+#else
+  static constexpr bool ENABLED = false;
+#endif
+
+  static constexpr size_t COMPONENT_NUM = static_cast<size_t>(PSComponent::NUM);
+  static constexpr size_t PHASE_NUM = static_cast<size_t>(PSPhase::NUM);
+
+  struct Snapshot {
+    uint64_t calls[COMPONENT_NUM][PHASE_NUM] = {};
+    uint64_t nanoseconds[COMPONENT_NUM][PHASE_NUM] = {};
+
+    /**
+     * @brief The counters in the Prometheus text exposition format, as ps_phase_calls_total and
+     *        ps_phase_seconds_total with component and phase labels.
+     */
+    std::string
+    toPrometheus() const;
+  };
+
+public:
+  /**
+   * @brief Add up the counters of all threads.
+   */
+  static Snapshot
+  snapshot();
+
+  /**
+   * @brief Set all counters to zero. Phases running at the same time may or may not be counted.
+   */
+  static void
+  reset();
+
+  /**
+   * @brief Count one phase from @p begin to @p end on the calling thread, and add it to the trace if the
+   *        thread is in a sampled run (see ps-trace.h).
+   */
+  static void
+  record(PSComponent component, PSPhase phase, std::chrono::steady_clock::time_point begin,
+         std::chrono::steady_clock::time_point end);
+};
+
+/**
+ * @brief Times its own lifetime as one phase.
+ */
+class PSPhaseTimer {
+public:
+  PSPhaseTimer(PSComponent component, PSPhase phase)
+      : m_component(component)
+      , m_phase(phase)
+      , m_begin(std::chrono::steady_clock::now())
+  {
+  }
+
+  ~PSPhaseTimer()
+  {
+    PSInstrumentation::record(m_component, m_phase, m_begin, std::chrono::steady_clock::now());
+  }
+
+  PSPhaseTimer(const PSPhaseTimer&) = delete;
+
+  PSPhaseTimer&
+  operator=(const PSPhaseTimer&) = delete;
+
+private:
+  PSComponent m_component;
+  PSPhase m_phase;
+  std::chrono::steady_clock::time_point m_begin;
+};
+
+#define PS_PHASE_CONCAT_(a, b) a##b
+#define PS_PHASE_CONCAT(a, b) PS_PHASE_CONCAT_(a, b)
+
+/**
+ * @brief Time the rest of the enclosing scope as @p phase of @p component, e.g.,
+ *        PS_PHASE(VERIFIER, PAIRING). Nothing at all without PS_ENABLE_INSTRUMENTATION.
+ */
+#ifdef PS_ENABLE_INSTRUMENTATION
+#define PS_PHASE(component, phase) \
+  PSPhaseTimer PS_PHASE_CONCAT(_ps_phase_timer_, __LINE__)(PSComponent::component, PSPhase::phase)
+#else
+#define PS_PHASE(component, phase)
+#endif
+
+#endif  // PS_SRC_PS_INSTRUMENTATION_H_
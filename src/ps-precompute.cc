@@ -0,0 +1,279 @@
+#include "ps-precompute.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mcl::bls12;
+
+static const size_t SCALAR_BYTE_SIZE = 32;
+
+// little-endian bytes of the scalar, zero padded to 32 bytes
+static void
+getScalarBytes(const Fr& s, uint8_t* bytes)
+{
+  size_t size = s.serialize(bytes, SCALAR_BYTE_SIZE);
+  for (size_t i = size; i < SCALAR_BYTE_SIZE; i++) {
+    bytes[i] = 0;
+  }
+}
+
+template<class T>
+PSFixedBaseTable<T>::PSFixedBaseTable(const T& base)
+{
+  auto storage = std::make_shared<std::vector<T>>(POINT_NUM);
+  build(storage->data(), base);
+  m_points = storage->data();
+  m_holder = storage;
+}
+
+template<class T>
+PSFixedBaseTable<T>::PSFixedBaseTable(const T* points, std::shared_ptr<const void> holder)
+    : m_holder(std::move(holder))
+    , m_points(points)
+{
+}
+
+template<class T>
+void
+PSFixedBaseTable<T>::build(T* points, const T& base)
+{
+  // window j holds base_j, 2 * base_j, ..., 15 * base_j where base_j = 16^j * base
+  T _base_j = base;
+  for (size_t j = 0; j < WINDOW_NUM; j++) {
+    T* _window = points + j * DIGIT_NUM;
+    _window[0] = _base_j;
+    for (size_t d = 1; d < DIGIT_NUM; d++) {
+      T::add(_window[d], _window[d - 1], _base_j);
+    }
+    T::add(_base_j, _window[DIGIT_NUM - 1], _base_j);
+    // normalized entries let additions take the mixed-coordinate path
+    for (size_t d = 0; d < DIGIT_NUM; d++) {
+      _window[d].normalize();
+    }
+  }
+}
+
+template<class T>
+bool
+PSFixedBaseTable<T>::empty() const
+{
+  return m_points == nullptr;
+}
+
+template<class T>
+const T*
+PSFixedBaseTable<T>::data() const
+{
+  return m_points;
+}
+
+template<class T>
+void
+PSFixedBaseTable<T>::mul(T& z, const Fr& s) const
+{
+  z.clear();
+  mulAdd(z, s);
+}
+
+template<class T>
+void
+PSFixedBaseTable<T>::mulAdd(T& z, const Fr& s) const
+{
+  uint8_t _bytes[SCALAR_BYTE_SIZE];
+  getScalarBytes(s, _bytes);
+  for (size_t j = 0; j < WINDOW_NUM; j++) {
+    uint8_t _digit = (j % 2 == 0) ? (_bytes[j / 2] & 0x0F) : (_bytes[j / 2] >> 4);
+    if (_digit != 0) {
+      T::add(z, z, m_points[j * DIGIT_NUM + _digit - 1]);
+    }
+  }
+}
+
+template<class T>
+void
+PSFixedBaseTable<T>::mulAdd2(T& z1, const Fr& s1, T& z2, const Fr& s2) const
+{
+  uint8_t _bytes1[SCALAR_BYTE_SIZE], _bytes2[SCALAR_BYTE_SIZE];
+  getScalarBytes(s1, _bytes1);
+  getScalarBytes(s2, _bytes2);
+  for (size_t j = 0; j < WINDOW_NUM; j++) {
+    const T* _window = m_points + j * DIGIT_NUM;
+    uint8_t _digit1 = (j % 2 == 0) ? (_bytes1[j / 2] & 0x0F) : (_bytes1[j / 2] >> 4);
+    uint8_t _digit2 = (j % 2 == 0) ? (_bytes2[j / 2] & 0x0F) : (_bytes2[j / 2] >> 4);
+    if (_digit1 != 0) {
+      T::add(z1, z1, _window[_digit1 - 1]);
+    }
+    if (_digit2 != 0) {
+      T::add(z2, z2, _window[_digit2 - 1]);
+    }
+  }
+}
+
+template class PSFixedBaseTable<G1>;
+template class PSFixedBaseTable<G2>;
+
+PSPairingTable::PSPairingTable(const G2& Q)
+{
+  auto storage = std::make_shared<std::vector<Fp6>>();
+  precomputeG2(*storage, Q);
+  m_coeffs = storage->data();
+  m_holder = storage;
+}
+
+PSPairingTable::PSPairingTable(const Fp6* coeffs, std::shared_ptr<const void> holder)
+    : m_holder(std::move(holder))
+    , m_coeffs(coeffs)
+{
+}
+
+size_t
+PSPairingTable::coeffNum()
+{
+  // fixed by the curve, so probing any point once is enough
+  static const size_t num = [] {
+    std::vector<Fp6> _coeffs;
+    G2 _Q;
+    hashAndMapToG2(_Q, "coeff-num");
+    precomputeG2(_coeffs, _Q);
+    return _coeffs.size();
+  }();
+  return num;
+}
+
+void
+PSPairingTable::build(Fp6* coeffs, const G2& Q)
+{
+  precomputeG2(coeffs, Q);
+}
+
+bool
+PSPairingTable::empty() const
+{
+  return m_coeffs == nullptr;
+}
+
+const Fp6*
+PSPairingTable::data() const
+{
+  return m_coeffs;
+}
+
+PSSignerTables
+PSSignerTables::build(const PSPubKey& pk)
+{
+  PSSignerTables tables;
+  tables.g = PSFixedBaseTable<G1>(pk.g);
+  tables.Yi.reserve(pk.Yi.size());
+  for (const auto& Y : pk.Yi) {
+    tables.Yi.emplace_back(Y);
+  }
+  return tables;
+}
+
+bool
+PSSignerTables::empty() const
+{
+  return g.empty();
+}
+
+PSVerifierTables
+PSVerifierTables::build(const PSPubKey& pk)
+{
+  PSVerifierTables tables;
+  tables.gg = PSFixedBaseTable<G2>(pk.gg);
+  tables.XX = PSFixedBaseTable<G2>(pk.XX);
+  tables.YYi.reserve(pk.YYi.size());
+  for (const auto& YY : pk.YYi) {
+    tables.YYi.emplace_back(YY);
+  }
+  tables.gg_lines = PSPairingTable(pk.gg);
+  return tables;
+}
+
+bool
+PSVerifierTables::empty() const
+{
+  return gg.empty();
+}
+
+PSRequesterTables
+PSRequesterTables::build(const PSPubKey& pk)
+{
+  PSRequesterTables tables;
+  tables.gg = PSFixedBaseTable<G2>(pk.gg);
+  tables.YYi.reserve(pk.YYi.size());
+  for (const auto& YY : pk.YYi) {
+    tables.YYi.emplace_back(YY);
+  }
+  return tables;
+}
+
+bool
+PSRequesterTables::empty() const
+{
+  return gg.empty();
+}
+
+PSMappedRegion::PSMappedRegion(const uint8_t* data, size_t size)
+    : m_data(data)
+    , m_size(size)
+{
+}
+
+PSMappedRegion::~PSMappedRegion()
+{
+  if (m_data != nullptr) {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+}
+
+std::shared_ptr<PSMappedRegion>
+PSMappedRegion::mapFile(const std::string& path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    throw std::runtime_error("cannot stat " + path);
+  }
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error("cannot map " + path);
+  }
+  return std::make_shared<PSMappedRegion>(static_cast<const uint8_t*>(addr), st.st_size);
+}
+
+const uint8_t*
+PSMappedRegion::data() const
+{
+  return m_data;
+}
+
+size_t
+PSMappedRegion::size() const
+{
+  return m_size;
+}
+
+void
+PSMappedRegion::adviseSequential() const
+{
+  madvise(const_cast<uint8_t*>(m_data), m_size, MADV_SEQUENTIAL);
+}
+
+void
+PSMappedRegion::release(size_t offset) const
+{
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t length = std::min(offset, m_size) / page_size * page_size;
+  if (length != 0) {
+    madvise(const_cast<uint8_t*>(m_data), length, MADV_DONTNEED);
+  }
+}
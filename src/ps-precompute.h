@@ -0,0 +1,214 @@
+#ifndef PS_SRC_PS_PRECOMPUTE_H_
+#define PS_SRC_PS_PRECOMPUTE_H_
+
+#include "ps-encoding.h"
+
+#include <memory>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief Fixed-base window table of a single G1 or G2 point.
+ *
+ * The table stores (d * 16^j) * base for every 4-bit window j of a scalar and every digit d in [1, 15],
+ * so that multiplying the base by a scalar costs at most 64 point additions and no doubling.
+ * Points are normalized and laid out contiguously in POINT_NUM entries. A table either owns its points
+ * or views points owned by someone else (e.g., a mapped key file), in which case @p holder keeps that
+ * memory alive. Copies of a table share the same points.
+ */
+template<class T>
+class PSFixedBaseTable {
+public:
+  static constexpr size_t WINDOW_BITS = 4;
+  static constexpr size_t WINDOW_NUM = 64;  // 256-bit scalars
+  static constexpr size_t DIGIT_NUM = (1 << WINDOW_BITS) - 1;
+  static constexpr size_t POINT_NUM = WINDOW_NUM * DIGIT_NUM;
+  static constexpr size_t BYTE_SIZE = POINT_NUM * sizeof(T);
+
+public:
+  PSFixedBaseTable() = default;
+
+  /**
+   * @brief Build a table that owns its points.
+   */
+  explicit PSFixedBaseTable(const T& base);
+
+  /**
+   * @brief View POINT_NUM points built by PSFixedBaseTable::build().
+   *
+   * @param points input The first point of the table.
+   * @param holder input The owner of the memory @p points lives in.
+   */
+  PSFixedBaseTable(const T* points, std::shared_ptr<const void> holder);
+
+  /**
+   * @brief Write the POINT_NUM points of the table of @p base into @p points.
+   */
+  static void
+  build(T* points, const T& base);
+
+  bool
+  empty() const;
+
+  const T*
+  data() const;
+
+  /**
+   * @brief z = base^s
+   */
+  void
+  mul(T& z, const Fr& s) const;
+
+  /**
+   * @brief z = z * base^s
+   */
+  void
+  mulAdd(T& z, const Fr& s) const;
+
+  /**
+   * @brief z1 = z1 * base^s1 and z2 = z2 * base^s2 in one pass over the table.
+   */
+  void
+  mulAdd2(T& z1, const Fr& s1, T& z2, const Fr& s2) const;
+
+private:
+  std::shared_ptr<const void> m_holder;
+  const T* m_points = nullptr;
+};
+
+/**
+ * @brief Miller-line coefficients of a fixed G2 point, so that pairings with the point skip
+ *        the G2 part of the Miller loop.
+ *
+ * Like PSFixedBaseTable, a table either owns its coefficients or views memory owned elsewhere.
+ */
+class PSPairingTable {
+public:
+  PSPairingTable() = default;
+
+  /**
+   * @brief Build a table that owns its coefficients.
+   */
+  explicit PSPairingTable(const G2& Q);
+
+  /**
+   * @brief View PSPairingTable::coeffNum() coefficients built by PSPairingTable::build().
+   */
+  PSPairingTable(const Fp6* coeffs, std::shared_ptr<const void> holder);
+
+  /**
+   * @brief The number of Fp6 coefficients of a table under the current pairing parameters.
+   */
+  static size_t
+  coeffNum();
+
+  static void
+  build(Fp6* coeffs, const G2& Q);
+
+  bool
+  empty() const;
+
+  const Fp6*
+  data() const;
+
+private:
+  std::shared_ptr<const void> m_holder;
+  const Fp6* m_coeffs = nullptr;
+};
+
+/**
+ * @brief Tables used by PSSigner: g and every Yi.
+ */
+class PSSignerTables {
+public:
+  static PSSignerTables
+  build(const PSPubKey& pk);
+
+  bool
+  empty() const;
+
+public:
+  PSFixedBaseTable<G1> g;
+  std::vector<PSFixedBaseTable<G1>> Yi;
+};
+
+/**
+ * @brief Tables used by PSVerifier: gg, XX, every YYi, and the Miller lines of gg.
+ */
+class PSVerifierTables {
+public:
+  static PSVerifierTables
+  build(const PSPubKey& pk);
+
+  bool
+  empty() const;
+
+public:
+  PSFixedBaseTable<G2> gg;
+  PSFixedBaseTable<G2> XX;
+  std::vector<PSFixedBaseTable<G2>> YYi;
+  PSPairingTable gg_lines;
+};
+
+/**
+ * @brief Tables used by PSRequester: gg and every YYi.
+ */
+class PSRequesterTables {
+public:
+  static PSRequesterTables
+  build(const PSPubKey& pk);
+
+  bool
+  empty() const;
+
+public:
+  PSFixedBaseTable<G2> gg;
+  std::vector<PSFixedBaseTable<G2>> YYi;
+};
+
+/**
+ * @brief A read-only memory mapping, unmapped when the last table viewing it goes away.
+ */
+class PSMappedRegion {
+public:
+  PSMappedRegion(const uint8_t* data, size_t size);
+
+  ~PSMappedRegion();
+
+  PSMappedRegion(const PSMappedRegion&) = delete;
+
+  PSMappedRegion&
+  operator=(const PSMappedRegion&) = delete;
+
+  /**
+   * @brief Map the whole file at @p path read-only.
+   *
+   * @throw std::runtime_error if the file cannot be opened or mapped.
+   */
+  static std::shared_ptr<PSMappedRegion>
+  mapFile(const std::string& path);
+
+  const uint8_t*
+  data() const;
+
+  size_t
+  size() const;
+
+  /**
+   * @brief Hint that the region is read once from front to back.
+   */
+  void
+  adviseSequential() const;
+
+  /**
+   * @brief Drop the pages before @p offset from memory. They are read from the file again if touched.
+   */
+  void
+  release(size_t offset) const;
+
+private:
+  const uint8_t* m_data;
+  size_t m_size;
+};
+
+#endif  // PS_SRC_PS_PRECOMPUTE_H_
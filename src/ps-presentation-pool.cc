@@ -0,0 +1,109 @@
+#include "ps-presentation-pool.h"
+
+using namespace mcl::bls12;
+
+PSPresentationPool::PSPresentationPool(const PSRequester& requester, const PSCredential& sig,
+                                       const std::vector<std::tuple<std::string, bool>>& attributes,
+                                       size_t capacity, PSThreadPool& thread_pool)
+    : m_requester(requester)
+    , m_sig(sig)
+    , m_attributes(attributes)
+    , m_capacity(capacity)
+    , m_thread_pool(thread_pool)
+{
+}
+
+PSPresentationPool::PSPresentationPool(const PSRequester& requester, const PSCredential& sig,
+                                       const std::vector<std::tuple<std::string, bool>>& attributes,
+                                       const G1& authority_pk, const G1& g, const G1& h,
+                                       size_t capacity, PSThreadPool& thread_pool)
+    : PSPresentationPool(requester, sig, attributes, PSAuthorityContext(authority_pk, g, h), capacity, thread_pool)
+{
+}
+
+PSPresentationPool::PSPresentationPool(const PSRequester& requester, const PSCredential& sig,
+                                       const std::vector<std::tuple<std::string, bool>>& attributes,
+                                       const PSAuthorityContext& authority,
+                                       size_t capacity, PSThreadPool& thread_pool)
+    : m_requester(requester)
+    , m_sig(sig)
+    , m_attributes(attributes)
+    , m_authority(authority)
+    , m_capacity(capacity)
+    , m_thread_pool(thread_pool)
+{
+}
+
+PSPresentationPool::~PSPresentationPool()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv.wait(lock, [this] { return m_pending == 0; });
+}
+
+void
+PSPresentationPool::fill()
+{
+  size_t missing_num;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    missing_num = m_capacity - std::min(m_capacity, m_ready.size() + m_pending);
+    m_pending += missing_num;
+  }
+  for (size_t i = 0; i < missing_num; i++) {
+    m_thread_pool.post([this] {
+      std::optional<PSPresentationContext> context;
+      try {
+        context = prepare();
+      }
+      catch (const std::exception&) {
+        // take() prepares on demand and reports the error
+      }
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (context.has_value()) {
+        m_ready.push_back(std::move(context.value()));
+      }
+      m_pending--;
+      m_cv.notify_all();
+    });
+  }
+}
+
+PSPresentationContext
+PSPresentationPool::take()
+{
+  std::optional<PSPresentationContext> context;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_ready.empty()) {
+      context = std::move(m_ready.front());
+      m_ready.pop_front();
+    }
+  }
+  if (!context.has_value()) {
+    context = prepare();
+  }
+  fill();
+  return std::move(context.value());
+}
+
+size_t
+PSPresentationPool::readyNum()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_ready.size();
+}
+
+IdProof
+PSPresentationPool::prove(const std::string& associated_data, const std::string& service_name)
+{
+  return m_requester.el_passo_prove_id_online(take(), associated_data, service_name);
+}
+
+PSPresentationContext
+PSPresentationPool::prepare() const
+{
+  if (m_authority.has_value()) {
+    return m_requester.el_passo_prepare_prove_id(m_sig, m_attributes, m_authority.value());
+  }
+  return m_requester.el_passo_prepare_prove_id_without_id_retrieval(m_sig, m_attributes);
+}
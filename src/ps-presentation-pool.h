@@ -0,0 +1,108 @@
+#ifndef PS_SRC_PS_PRESENTATION_POOL_H_
+#define PS_SRC_PS_PRESENTATION_POOL_H_
+
+#include "ps-requester.h"
+#include "ps-thread-pool.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief A pool of presentation contexts for one credential, prepared ahead of EL PASSO ProveID.
+ *
+ * Contexts are prepared on @p thread_pool, e.g., while a login page loads, so that a sign on only runs
+ * PSRequester::el_passo_prove_id_online(). With a PSThreadPool of size 1 (e.g., in WebAssembly),
+ * PSPresentationPool::fill() prepares the contexts on the calling thread.
+ *
+ * The requester and the thread pool must outlive the PSPresentationPool.
+ */
+class PSPresentationPool {
+public:
+  /**
+   * @brief Construct a pool of contexts for PSRequester::el_passo_prove_id_without_id_retrieval().
+   *
+   * @param requester input The owner of @p sig.
+   * @param sig input The unblinded PS signature.
+   * @param attributes input As in PSRequester::el_passo_prove_id().
+   * @param capacity input The number of contexts to keep ready.
+   * @param thread_pool input The threads preparing the contexts.
+   */
+  PSPresentationPool(const PSRequester& requester, const PSCredential& sig,
+                     const std::vector<std::tuple<std::string, bool>>& attributes,
+                     size_t capacity, PSThreadPool& thread_pool);
+
+  /**
+   * @brief Construct a pool of contexts for PSRequester::el_passo_prove_id().
+   */
+  PSPresentationPool(const PSRequester& requester, const PSCredential& sig,
+                     const std::vector<std::tuple<std::string, bool>>& attributes,
+                     const G1& authority_pk, const G1& g, const G1& h,
+                     size_t capacity, PSThreadPool& thread_pool);
+
+  /**
+   * @brief Construct a pool of contexts for PSRequester::el_passo_prove_id(), preparing the identity
+   *        retrieval token with the tables of @p authority if precomputed.
+   */
+  PSPresentationPool(const PSRequester& requester, const PSCredential& sig,
+                     const std::vector<std::tuple<std::string, bool>>& attributes,
+                     const PSAuthorityContext& authority,
+                     size_t capacity, PSThreadPool& thread_pool);
+
+  /**
+   * @brief Wait for the contexts being prepared.
+   */
+  ~PSPresentationPool();
+
+  PSPresentationPool(const PSPresentationPool&) = delete;
+
+  PSPresentationPool&
+  operator=(const PSPresentationPool&) = delete;
+
+  /**
+   * @brief Start preparing contexts until the pool holds its capacity.
+   */
+  void
+  fill();
+
+  /**
+   * @brief Take a ready context, or prepare one on the calling thread if none is ready, and start
+   *        preparing its replacement.
+   */
+  PSPresentationContext
+  take();
+
+  /**
+   * @brief The number of ready contexts.
+   */
+  size_t
+  readyNum();
+
+  /**
+   * @brief Take a context and run PSRequester::el_passo_prove_id_online().
+   */
+  IdProof
+  prove(const std::string& associated_data, const std::string& service_name);
+
+private:
+  PSPresentationContext
+  prepare() const;
+
+private:
+  const PSRequester& m_requester;
+  PSCredential m_sig;
+  std::vector<std::tuple<std::string, bool>> m_attributes;
+  std::optional<PSAuthorityContext> m_authority;
+  size_t m_capacity;
+  PSThreadPool& m_thread_pool;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<PSPresentationContext> m_ready;
+  size_t m_pending = 0;  // contexts being prepared
+};
+
+#endif  // PS_SRC_PS_PRESENTATION_POOL_H_
@@ -0,0 +1,228 @@
+#include "ps-random.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cybozu/sha2.hpp>
+#include <mutex>
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace mcl::bls12;
+
+static inline uint32_t
+rotl(uint32_t x, int n)
+{
+  return (x << n) | (x >> (32 - n));
+}
+
+#define PS_CHACHA_QUARTER_ROUND(a, b, c, d) \
+  a += b; d ^= a; d = rotl(d, 16);          \
+  c += d; b ^= c; b = rotl(b, 12);          \
+  a += b; d ^= a; d = rotl(d, 8);           \
+  c += d; b ^= c; b = rotl(b, 7);
+
+// one 64-byte ChaCha20 block, RFC 7539 with a 64-bit block counter and a zero nonce
+static void
+chachaBlock(const uint32_t key[8], uint64_t counter, uint8_t out[64])
+{
+  uint32_t input[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+                        key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+                        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), 0, 0};
+  uint32_t x[16];
+  std::memcpy(x, input, sizeof(x));
+  for (int i = 0; i < 10; i++) {
+    PS_CHACHA_QUARTER_ROUND(x[0], x[4], x[8], x[12])
+    PS_CHACHA_QUARTER_ROUND(x[1], x[5], x[9], x[13])
+    PS_CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14])
+    PS_CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15])
+    PS_CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15])
+    PS_CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12])
+    PS_CHACHA_QUARTER_ROUND(x[2], x[7], x[8], x[13])
+    PS_CHACHA_QUARTER_ROUND(x[3], x[4], x[9], x[14])
+  }
+  for (int i = 0; i < 16; i++) {
+    uint32_t word = x[i] + input[i];
+    out[4 * i] = word & 0xFF;
+    out[4 * i + 1] = (word >> 8) & 0xFF;
+    out[4 * i + 2] = (word >> 16) & 0xFF;
+    out[4 * i + 3] = (word >> 24) & 0xFF;
+  }
+}
+
+static void
+getOsEntropy(uint8_t* out, size_t size)
+{
+  // getentropy() serves at most 256 bytes per call
+  while (size > 0) {
+    size_t chunk = std::min<size_t>(size, 256);
+    if (getentropy(out, chunk) != 0) {
+      throw std::runtime_error("cannot get entropy from the operating system");
+    }
+    out += chunk;
+    size -= chunk;
+  }
+}
+
+PSChaChaDrbg::PSChaChaDrbg()
+    : m_deterministic(false)
+{
+  getOsEntropy(reinterpret_cast<uint8_t*>(m_key), sizeof(m_key));
+}
+
+PSChaChaDrbg::PSChaChaDrbg(const std::string& seed)
+    : m_deterministic(true)
+{
+  uint8_t _digest[32];
+  cybozu::Sha256 digest_engine;
+  digest_engine.digest(_digest, sizeof(_digest), seed.data(), seed.size());
+  std::memcpy(m_key, _digest, sizeof(m_key));
+}
+
+void
+PSChaChaDrbg::generate(uint8_t* out, size_t size)
+{
+  while (size > 0) {
+    if (m_position == BUFFER_SIZE) {
+      refill();
+    }
+    size_t chunk = std::min(size, BUFFER_SIZE - m_position);
+    std::memcpy(out, m_buffer + m_position, chunk);
+    // served bytes are not kept around
+    std::memset(m_buffer + m_position, 0, chunk);
+    m_position += chunk;
+    out += chunk;
+    size -= chunk;
+  }
+}
+
+void
+PSChaChaDrbg::refill()
+{
+  if (!m_deterministic && m_since_reseed >= RESEED_INTERVAL) {
+    reseed();
+  }
+  for (size_t i = 0; i < BUFFER_SIZE; i += 64) {
+    chachaBlock(m_key, m_counter++, m_buffer + i);
+  }
+  // fast key erasure: the first block becomes the next key, so earlier output cannot be recomputed
+  std::memcpy(m_key, m_buffer, sizeof(m_key));
+  std::memset(m_buffer, 0, sizeof(m_key));
+  m_position = sizeof(m_key);
+  m_since_reseed += BUFFER_SIZE;
+}
+
+void
+PSChaChaDrbg::reseed()
+{
+  uint32_t _entropy[8];
+  getOsEntropy(reinterpret_cast<uint8_t*>(_entropy), sizeof(_entropy));
+  for (size_t i = 0; i < 8; i++) {
+    m_key[i] ^= _entropy[i];
+  }
+  m_since_reseed = 0;
+}
+
+static std::mutex s_seed_mutex;
+static std::string s_seed;                      // guarded by s_seed_mutex
+static std::atomic<uint64_t> s_generation{0};   // bumped by every PSRandom::setDeterministicSeed() and fork()
+static std::atomic<uint64_t> s_thread_index{0};  // order in which threads create their source
+
+// A forked child inherits the DRBG state of its parent, so without a new source both would draw the same
+// nonces. The child bumps the generation so that every thread replaces its source before the next draw.
+static int s_atfork = pthread_atfork(
+    [] { s_seed_mutex.lock(); },
+    [] { s_seed_mutex.unlock(); },
+    [] {
+      s_seed_mutex.unlock();
+      s_generation.fetch_add(1, std::memory_order_release);
+    });
+
+struct PSRandomThreadState {
+  std::shared_ptr<PSRandomSource> source;
+  uint64_t generation = 0;
+  bool custom = false;
+};
+
+static thread_local PSRandomThreadState t_state;
+
+static PSRandomSource&
+threadSource()
+{
+  uint64_t generation = s_generation.load(std::memory_order_acquire);
+  if (t_state.source == nullptr || (!t_state.custom && t_state.generation != generation)) {
+    std::string seed;
+    {
+      std::lock_guard<std::mutex> lock(s_seed_mutex);
+      seed = s_seed;
+    }
+    if (seed.empty()) {
+      t_state.source = std::make_shared<PSChaChaDrbg>();
+    }
+    else {
+      t_state.source = std::make_shared<PSChaChaDrbg>(seed + "/" + std::to_string(s_thread_index++));
+    }
+    t_state.generation = generation;
+    t_state.custom = false;
+  }
+  return *t_state.source;
+}
+
+void
+PSRandom::generateFr(Fr& f)
+{
+  // rejection sampling over the bit size of the group order, as Fr::setByCSPRNG() does
+  uint8_t _bytes[64];
+  size_t bit_size = Fr::getBitSize();
+  size_t byte_size = (bit_size + 7) / 8;
+  auto& source = threadSource();
+  bool ok = false;
+  while (!ok) {
+    source.generate(_bytes, byte_size);
+    if (bit_size % 8 != 0) {
+      _bytes[byte_size - 1] &= (1 << (bit_size % 8)) - 1;
+    }
+    f.setArray(&ok, _bytes, byte_size);
+  }
+}
+
+void
+PSRandom::generateFrs(Fr* fs, size_t n)
+{
+  for (size_t i = 0; i < n; i++) {
+    generateFr(fs[i]);
+  }
+}
+
+void
+PSRandom::generateBytes(uint8_t* out, size_t size)
+{
+  threadSource().generate(out, size);
+}
+
+void
+PSRandom::setThreadSource(std::shared_ptr<PSRandomSource> source)
+{
+  t_state.source = std::move(source);
+  t_state.custom = t_state.source != nullptr;
+}
+
+void
+PSRandom::setDeterministicSeed(const std::string& seed)
+{
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(s_seed_mutex);
+    s_seed = seed;
+    s_thread_index = 0;
+    generation = ++s_generation;
+  }
+  if (seed.empty()) {
+    t_state.source = std::make_shared<PSChaChaDrbg>();
+  }
+  else {
+    t_state.source = std::make_shared<PSChaChaDrbg>(seed);
+  }
+  t_state.generation = generation;
+  t_state.custom = false;
+}
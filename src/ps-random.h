@@ -0,0 +1,105 @@
+#ifndef PS_SRC_PS_RANDOM_H_
+#define PS_SRC_PS_RANDOM_H_
+
+#include "ps-curve.h"
+
+#include <memory>
+#include <string>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief A source of random bytes.
+ */
+class PSRandomSource {
+public:
+  virtual ~PSRandomSource() = default;
+
+  virtual void
+  generate(uint8_t* out, size_t size) = 0;
+};
+
+/**
+ * @brief ChaCha20 based deterministic random bit generator.
+ *
+ * Output is produced BUFFER_SIZE bytes at a time, so most requests are served from memory.
+ * A generator seeded from the operating system mixes in fresh OS entropy every RESEED_INTERVAL bytes.
+ * A generator seeded with a fixed seed never reseeds and always produces the same stream,
+ * which is only meant for reproducible benchmarks and tests.
+ */
+class PSChaChaDrbg : public PSRandomSource {
+public:
+  static constexpr size_t BUFFER_SIZE = 1024;
+  static constexpr uint64_t RESEED_INTERVAL = 1 << 20;
+
+public:
+  /**
+   * @brief Construct a generator seeded from the operating system.
+   *
+   * @throw std::runtime_error if the operating system provides no entropy.
+   */
+  PSChaChaDrbg();
+
+  /**
+   * @brief Construct a deterministic generator. Never use it for real keys or proofs.
+   */
+  explicit PSChaChaDrbg(const std::string& seed);
+
+  void
+  generate(uint8_t* out, size_t size) override;
+
+private:
+  void
+  refill();
+
+  void
+  reseed();
+
+private:
+  uint32_t m_key[8];
+  uint64_t m_counter = 0;
+  uint8_t m_buffer[BUFFER_SIZE];
+  size_t m_position = BUFFER_SIZE;
+  uint64_t m_since_reseed = 0;
+  bool m_deterministic;
+};
+
+/**
+ * @brief The randomness used by PSSigner, PSRequester and PSVerifier.
+ *
+ * Each thread draws from its own source, by default a PSChaChaDrbg seeded from the operating system,
+ * so hot paths neither take locks nor make system calls. After fork(), the default sources of the child
+ * are seeded anew; sources set with PSRandom::setThreadSource() are kept as they are.
+ */
+class PSRandom {
+public:
+  /**
+   * @brief Set a uniformly random scalar, drawn from the calling thread's source.
+   */
+  static void
+  generateFr(Fr& f);
+
+  static void
+  generateFrs(Fr* fs, size_t n);
+
+  static void
+  generateBytes(uint8_t* out, size_t size);
+
+  /**
+   * @brief Replace the calling thread's source. nullptr restores the default.
+   */
+  static void
+  setThreadSource(std::shared_ptr<PSRandomSource> source);
+
+  /**
+   * @brief Make every thread draw from a deterministic PSChaChaDrbg.
+   *
+   * The calling thread uses @p seed, and every other thread uses @p seed combined with the order in
+   * which it first draws randomness afterwards. An empty seed restores OS-seeded generators.
+   * Only meant for reproducible benchmarks and tests.
+   */
+  static void
+  setDeterministicSeed(const std::string& seed);
+};
+
+#endif  // PS_SRC_PS_RANDOM_H_
@@ -1,10 +1,17 @@
 #include "ps-requester.h"
+#include "ps-instrumentation.h"
+#include "ps-random.h"
+#include "ps-trace.h"
+#include "ps-transcript.h"
 
+#include <algorithm>
 #include <chrono>
-#include <cybozu/sha2.hpp>
 
 using namespace mcl::bls12;
 
+// below this many G2 terms per task, splitting a proof costs more than it saves
+static const size_t PS_MIN_TERMS_PER_TASK = 8;
+
 PSRequester::PSRequester(const PSPubKey& pk)
     : m_pk(pk)
 {
@@ -16,10 +23,72 @@ PSRequester::maxAllowedAttrNum() const
   return m_pk.Yi.size();
 }
 
+void
+PSRequester::precompute()
+{
+  m_tables = PSRequesterTables::build(m_pk);
+}
+
+void
+PSRequester::use_thread_pool(PSThreadPool* thread_pool)
+{
+  m_thread_pool = thread_pool;
+}
+
+void
+PSRequester::use_tables(const PSRequesterTables& tables)
+{
+  if (tables.YYi.size() != m_pk.YYi.size()) {
+    throw std::runtime_error("table size does not match");
+  }
+  m_tables = tables;
+}
+
+bool
+PSBlindingContext::empty() const
+{
+  return !m_ready;
+}
+
+// the views of the attributes, which must outlive them
+static std::vector<PSAttributeView>
+toAttributeViews(const std::vector<std::tuple<std::string, bool>>& attributes)
+{
+  std::vector<PSAttributeView> views;
+  views.reserve(attributes.size());
+  for (const auto& attribute : attributes) {
+    views.emplace_back(std::get<0>(attribute), std::get<1>(attribute));
+  }
+  return views;
+}
+
 PSCredRequest
 PSRequester::el_passo_request_id(const std::vector<std::tuple<std::string, bool>> attributes,  // string is the attribute, bool whether to hide
                                  const std::string& associated_data)
 {
+  PSBlindingContext context;
+  auto request = el_passo_request_id(attributes, associated_data, context);
+  m_t1 = context.m_t1;
+  return request;
+}
+
+PSCredRequest
+PSRequester::el_passo_request_id(const std::vector<std::tuple<std::string, bool>>& attributes,
+                                 const std::string& associated_data,
+                                 PSBlindingContext& context) const
+{
+  auto views = toAttributeViews(attributes);
+  PSCredRequest request;
+  el_passo_request_id(views.data(), views.size(), associated_data, context, request);
+  return request;
+}
+
+void
+PSRequester::el_passo_request_id(const PSAttributeView* attributes, size_t attribute_num,
+                                 std::string_view associated_data,
+                                 PSBlindingContext& context, PSCredRequest& request) const
+{
+  PS_SPAN("el_passo_request_id");
   /** NIZK Prove:
    * Public Value: A = g^t * PI{Yi^(attribute_i)}, will be sent
    * Public Random Value: V = g^random1 * PROD{Yi^(random2_i)}, will not be sent
@@ -28,38 +97,48 @@ PSRequester::el_passo_request_id(const std::vector<std::tuple<std::string, bool>
    */
   // calcuate the max number of attributes supported
   size_t maxAllowedAttrNum = m_pk.Yi.size();
-  if (attributes.size() != maxAllowedAttrNum) {
+  if (attribute_num != maxAllowedAttrNum) {
     throw std::runtime_error("attribute size does not match");
   }
-  // parameters to send:
-  PSCredRequest request;
-  request.rs.reserve(attributes.size() + 1);
   // Prepare for A
-  m_t1.setByCSPRNG();
-  G1::mul(request.A, m_pk.g, m_t1);
+  PSRandom::generateFr(context.m_t1);
+  context.m_ready = true;
+  {
+    PS_PHASE(REQUESTER, G1_MUL);
+    G1::mul(request.A, m_pk.g, context.m_t1);
+  }
   Fr _attribute_hash;
   G1 _Yi_hash, _Yi_randomness;
-  std::vector<Fr> _attribute_hashes;
-  _attribute_hashes.reserve(attributes.size());
+  // kept across calls so that steady state requests do not allocate
+  static thread_local std::vector<Fr> _attribute_hashes;
+  static thread_local std::vector<Fr> _randomnesses;
+  _attribute_hashes.clear();
+  _randomnesses.clear();
   // Parepare for randomness
-  std::vector<Fr> _randomnesses;
-  _randomnesses.reserve(attributes.size() + 1);
   Fr _temp_randomness;
-  _temp_randomness.setByCSPRNG();
+  PSRandom::generateFr(_temp_randomness);
   _randomnesses.push_back(_temp_randomness);  // the randomness for g^t
   // prepare for V
   G1 _V;
-  G1::mul(_V, m_pk.g, _temp_randomness);
-  for (size_t i = 0; i < attributes.size(); i++) {
+  {
+    PS_PHASE(REQUESTER, G1_MUL);
+    G1::mul(_V, m_pk.g, _temp_randomness);
+  }
+  for (size_t i = 0; i < attribute_num; i++) {
     if (std::get<1>(attributes[i])) {
       // this attribute needs to be commitmented
       // calculate A
-      _attribute_hash.setHashOf(std::get<0>(attributes[i]));
+      const auto& _attribute = std::get<0>(attributes[i]);
+      {
+        PS_PHASE(REQUESTER, HASH);
+        _attribute_hash.setHashOf(_attribute.data(), _attribute.size());
+      }
       _attribute_hashes.push_back(_attribute_hash);
+      PS_PHASE(REQUESTER, G1_MUL);
       G1::mul(_Yi_hash, m_pk.Yi[i], _attribute_hash);
       G1::add(request.A, request.A, _Yi_hash);
       // generate randomness
-      _temp_randomness.setByCSPRNG();
+      PSRandom::generateFr(_temp_randomness);
       _randomnesses.push_back(_temp_randomness);  // the randomness for message i
       // calculate V
       G1::mul(_Yi_randomness, m_pk.Yi[i], _temp_randomness);
@@ -67,17 +146,17 @@ PSRequester::el_passo_request_id(const std::vector<std::tuple<std::string, bool>
     }
   }
   // Calculate c
-  cybozu::Sha256 digest_engine;
-  digest_engine.update(request.A.serializeToHexStr());
-  digest_engine.update(_V.serializeToHexStr());
-  auto _c_str = digest_engine.digest(associated_data);
-  request.c.setHashOf(_c_str);
-  // std::cout << "parepare: A: " << request.A.serializeToHexStr() << std::endl;
-  // std::cout << "parepare: V: " << _V.serializeToHexStr() << std::endl;
-  // std::cout << "parepare: c: " << request.c.serializeToHexStr() << std::endl;
+  {
+    PS_PHASE(REQUESTER, TRANSCRIPT);
+    PSTranscript transcript;
+    transcript.append(request.A);
+    transcript.append(_V);
+    transcript.challenge(request.c, associated_data);
+  }
   // Calculate rs
+  request.rs.clear();
   Fr _r_temp;
-  Fr::mul(_r_temp, m_t1, request.c);
+  Fr::mul(_r_temp, context.m_t1, request.c);
   Fr::sub(_r_temp, _randomnesses[0], _r_temp);
   request.rs.push_back(_r_temp);
   for (size_t i = 0; i < _attribute_hashes.size(); i++) {
@@ -86,27 +165,42 @@ PSRequester::el_passo_request_id(const std::vector<std::tuple<std::string, bool>
     request.rs.push_back(_r_temp);
   }
   // plaintext attributes
-  request.attributes.reserve(attributes.size());
-  for (size_t i = 0; i < attributes.size(); i++) {
+  request.attributes.resize(attribute_num);
+  for (size_t i = 0; i < attribute_num; i++) {
     if (std::get<1>(attributes[i])) {
-      request.attributes.push_back("");
+      request.attributes[i].clear();
     }
     else {
-      request.attributes.push_back(std::get<0>(attributes[i]));
+      request.attributes[i].assign(std::get<0>(attributes[i]));
     }
   }
-  return request;
 }
 
 PSCredential
 PSRequester::unblind_credential(const PSCredential& sig) const
+{
+  return unblind(sig, m_t1);
+}
+
+PSCredential
+PSRequester::unblind_credential(const PSCredential& sig, const PSBlindingContext& context) const
+{
+  if (context.empty()) {
+    throw std::runtime_error("blinding context is empty");
+  }
+  return unblind(sig, context.m_t1);
+}
+
+PSCredential
+PSRequester::unblind(const PSCredential& sig, const Fr& t1)
 {
   // unblinded_sig <- (sig_1, sig_2 / sig_1^t)
   PSCredential newSig;
   newSig.sig1 = sig.sig1;
 
+  PS_PHASE(REQUESTER, G1_MUL);
   G1 _sig1_t;
-  G1::mul(_sig1_t, sig.sig1, m_t1);
+  G1::mul(_sig1_t, sig.sig1, t1);
   G1::sub(newSig.sig2, sig.sig2, _sig1_t);
 
   return newSig;
@@ -115,6 +209,7 @@ PSRequester::unblind_credential(const PSCredential& sig) const
 bool
 PSRequester::verify(const PSCredential& sig, const std::vector<std::string>& all_attributes) const
 {
+  PS_SPAN("verify");
   if (sig.sig1.isZero()) {
     return false;
   }
@@ -124,12 +219,17 @@ PSRequester::verify(const PSCredential& sig, const std::vector<std::string>& all
   int counter = 0;
   G2 _yyi_hash_product;
   for (const auto& attribute : all_attributes) {
-    _attribute_hash.setHashOf(attribute);
+    {
+      PS_PHASE(REQUESTER, HASH);
+      _attribute_hash.setHashOf(attribute);
+    }
+    PS_PHASE(REQUESTER, G2_MUL);
     G2::mul(_yyi_hash_product, m_pk.YYi[counter], _attribute_hash);
     G2::add(_yy_hash_sum, _yy_hash_sum, _yyi_hash_product);
     counter++;
   }
 
+  PS_PHASE(REQUESTER, PAIRING);
   GT _lhs, _rhs;
   pairing(_lhs, sig.sig1, _yy_hash_sum);
   pairing(_rhs, sig.sig2, m_pk.gg);
@@ -141,7 +241,8 @@ PSRequester::randomize_credential(const PSCredential& sig) const
 {
   PSCredential newSig;
   Fr t;
-  t.setByCSPRNG();
+  PSRandom::generateFr(t);
+  PS_PHASE(REQUESTER, G1_MUL);
   G1::mul(newSig.sig1, sig.sig1, t);
   G1::mul(newSig.sig2, sig.sig2, t);
   return newSig;
@@ -154,279 +255,539 @@ PSRequester::el_passo_prove_id(const PSCredential& sig,
                                const std::string& service_name,
                                const G1& authority_pk, const G1& g, const G1& h) const
 {
-  size_t maxAllowedAttrNum = m_pk.Yi.size();
-  if (attributes.size() != maxAllowedAttrNum) {
-    throw std::runtime_error("attribute size does not match");
-  }
+  auto views = toAttributeViews(attributes);
+  IdProof proof;
+  el_passo_prove_id(sig, views.data(), views.size(), associated_data, service_name,
+                    PSAuthorityContext(authority_pk, g, h), proof);
+  return proof;
+}
 
+IdProof
+PSRequester::el_passo_prove_id(const PSCredential& sig,
+                               const std::vector<std::tuple<std::string, bool>> attributes,
+                               const std::string& associated_data,
+                               const std::string& service_name,
+                               const PSAuthorityContext& authority) const
+{
+  auto views = toAttributeViews(attributes);
   IdProof proof;
-  // new_sig = sig1^r, (sig2 + sig1^t)^r
-  Fr _t, _r;
-  _t.setByCSPRNG();
-  _r.setByCSPRNG();
-  G1::mul(proof.sig1, sig.sig1, _r);
-  G1::mul(proof.sig2, sig.sig1, _t);
-  G1::add(proof.sig2, proof.sig2, sig.sig2);
-  G1::mul(proof.sig2, proof.sig2, _r);
-
-  // El Gamal Cipher E = g^epsilon, y^epsilon * h^gamma
-  G1 _E1, _E2, _h_gamma;
-  Fr _epsilon, _gamma;
-  _epsilon.setByCSPRNG();
-  _gamma.setHashOf(std::get<0>(attributes[1]));
-  G1::mul(_E1, g, _epsilon);
-  G1::mul(_E2, authority_pk, _epsilon);
-  G1::mul(_h_gamma, h, _gamma);
-  G1::add(_E2, _E2, _h_gamma);
-
-  // phi = hash(service_name)^gamma
+  el_passo_prove_id(sig, views.data(), views.size(), associated_data, service_name, authority, proof);
+  return proof;
+}
+
+IdProof  // sig1, sig2, k, phi, c, rs, attributes
+PSRequester::el_passo_prove_id_without_id_retrieval(const PSCredential& sig,
+                                                    const std::vector<std::tuple<std::string, bool>> attributes,
+                                                    const std::string& associated_data,
+                                                    const std::string& service_name) const
+{
+  auto views = toAttributeViews(attributes);
+  IdProof proof;
+  el_passo_prove_id_without_id_retrieval(sig, views.data(), views.size(), associated_data, service_name, proof);
+  return proof;
+}
+
+// prepared and consumed right away, so their storage is reused by the next proof on the same thread
+static thread_local PSAttributeCache s_cache;
+static thread_local PSPresentationContext s_context;
+
+// erases the secrets left in the thread-local scratch when a proof returns or throws
+struct PSScratchEraser {
+  ~PSScratchEraser()
+  {
+    s_cache.clear();
+    s_context.clear();
+  }
+};
+
+void
+PSRequester::el_passo_prove_id(const PSCredential& sig,
+                               const PSAttributeView* attributes, size_t attribute_num,
+                               std::string_view associated_data,
+                               std::string_view service_name,
+                               const G1& authority_pk, const G1& g, const G1& h,
+                               IdProof& proof) const
+{
+  el_passo_prove_id(sig, attributes, attribute_num, associated_data, service_name,
+                    PSAuthorityContext(authority_pk, g, h), proof);
+}
+
+void
+PSRequester::el_passo_prove_id(const PSCredential& sig,
+                               const PSAttributeView* attributes, size_t attribute_num,
+                               std::string_view associated_data,
+                               std::string_view service_name,
+                               const PSAuthorityContext& authority,
+                               IdProof& proof) const
+{
+  PS_SPAN("el_passo_prove_id");
+  PSScratchEraser _eraser;
+  cache_attributes(attributes, attribute_num, false, s_cache);
+  prepare_presentation(sig, s_cache, &authority, s_context);
   G1 _service_hash;
-  Fr _s;
-  hashAndMapToG1(_service_hash, service_name);
-  _s.setHashOf(std::get<0>(attributes[0]));
-  G1::mul(proof.phi, _service_hash, _s);
+  {
+    PS_PHASE(REQUESTER, HASH);
+    hashAndMapToG1(_service_hash, service_name.data(), service_name.size());
+  }
+  prove_online(s_context, associated_data, _service_hash, proof);
+}
 
-  // k = XX * PI{ YYj^mj } * gg^t
-  proof.k = m_pk.XX;
-  Fr _attribute_hash;
-  G2 _yy_hash;
-  std::vector<Fr> _attribute_hashes;
-  _attribute_hashes.reserve(attributes.size());
-  for (size_t i = 0; i < attributes.size(); i++) {
+void
+PSRequester::el_passo_prove_id_without_id_retrieval(const PSCredential& sig,
+                                                    const PSAttributeView* attributes, size_t attribute_num,
+                                                    std::string_view associated_data,
+                                                    std::string_view service_name,
+                                                    IdProof& proof) const
+{
+  PS_SPAN("el_passo_prove_id_without_id_retrieval");
+  PSScratchEraser _eraser;
+  cache_attributes(attributes, attribute_num, false, s_cache);
+  prepare_presentation(sig, s_cache, nullptr, s_context);
+  G1 _service_hash;
+  {
+    PS_PHASE(REQUESTER, HASH);
+    hashAndMapToG1(_service_hash, service_name.data(), service_name.size());
+  }
+  prove_online(s_context, associated_data, _service_hash, proof);
+}
+
+PSPresentationContext
+PSRequester::el_passo_prepare_prove_id(const PSCredential& sig,
+                                       const std::vector<std::tuple<std::string, bool>>& attributes,
+                                       const G1& authority_pk, const G1& g, const G1& h) const
+{
+  return el_passo_prepare_prove_id(sig, attributes, PSAuthorityContext(authority_pk, g, h));
+}
+
+PSPresentationContext
+PSRequester::el_passo_prepare_prove_id(const PSCredential& sig,
+                                       const std::vector<std::tuple<std::string, bool>>& attributes,
+                                       const PSAuthorityContext& authority) const
+{
+  PS_SPAN("el_passo_prepare_prove_id");
+  PSScratchEraser _eraser;
+  auto views = toAttributeViews(attributes);
+  cache_attributes(views.data(), views.size(), false, s_cache);
+  PSPresentationContext context;
+  prepare_presentation(sig, s_cache, &authority, context);
+  return context;
+}
+
+PSPresentationContext
+PSRequester::el_passo_prepare_prove_id_without_id_retrieval(const PSCredential& sig,
+                                                            const std::vector<std::tuple<std::string, bool>>& attributes) const
+{
+  PS_SPAN("el_passo_prepare_prove_id_without_id_retrieval");
+  PSScratchEraser _eraser;
+  auto views = toAttributeViews(attributes);
+  cache_attributes(views.data(), views.size(), false, s_cache);
+  PSPresentationContext context;
+  prepare_presentation(sig, s_cache, nullptr, context);
+  return context;
+}
+
+static void
+clearScalars(std::vector<Fr>& scalars)
+{
+  for (auto& scalar : scalars) {
+    scalar.clear();
+  }
+}
+
+bool
+PSAttributeCache::empty() const
+{
+  return !m_ready;
+}
+
+void
+PSAttributeCache::clear()
+{
+  m_ready = false;
+  clearScalars(m_attribute_hashes);
+  m_s.clear();
+  m_gamma.clear();
+}
+
+void
+PSRequester::cache_attributes(const PSAttributeView* attributes, size_t attribute_num, bool with_partial_k,
+                              PSAttributeCache& cache) const
+{
+  size_t maxAllowedAttrNum = m_pk.Yi.size();
+  if (attribute_num != maxAllowedAttrNum) {
+    throw std::runtime_error("attribute size does not match");
+  }
+
+  cache.m_ready = false;
+  cache.m_hidden_indices.clear();
+  cache.m_attribute_hashes.clear();
+  {
+    PS_PHASE(REQUESTER, HASH);
+    Fr _attribute_hash;
+    for (size_t i = 0; i < attribute_num; i++) {
+      if (std::get<1>(attributes[i])) {
+        const auto& _attribute = std::get<0>(attributes[i]);
+        _attribute_hash.setHashOf(_attribute.data(), _attribute.size());
+        cache.m_hidden_indices.push_back(i);
+        cache.m_attribute_hashes.push_back(_attribute_hash);
+      }
+    }
+    // s is used for phi, gamma for the identity retrieval token
+    cache.m_s.setHashOf(std::get<0>(attributes[0]).data(), std::get<0>(attributes[0]).size());
+    if (attribute_num > 1) {
+      cache.m_gamma.setHashOf(std::get<0>(attributes[1]).data(), std::get<0>(attributes[1]).size());
+    }
+    else {
+      // no gamma of the previous credential must remain in a reused cache
+      cache.m_gamma.clear();
+    }
+  }
+  // plaintext attributes
+  cache.m_attributes.resize(attribute_num);
+  for (size_t i = 0; i < attribute_num; i++) {
     if (std::get<1>(attributes[i])) {
-      _attribute_hash.setHashOf(std::get<0>(attributes[i]));
-      _attribute_hashes.push_back(_attribute_hash);
-      G2::mul(_yy_hash, m_pk.YYi[i], _attribute_hash);
-      G2::add(proof.k, proof.k, _yy_hash);
+      cache.m_attributes[i].clear();
+    }
+    else {
+      cache.m_attributes[i].assign(std::get<0>(attributes[i]));
     }
   }
-  G2::mul(_yy_hash, m_pk.gg, _t);
-  G2::add(proof.k, proof.k, _yy_hash);
+
+  // XX * PI{ YYj^mj }
+  cache.m_has_partial_k = with_partial_k;
+  if (with_partial_k) {
+    PS_PHASE(REQUESTER, G2_MUL);
+    if (cache.m_hidden_indices.empty()) {
+      cache.m_partial_k.clear();
+    }
+    else if (m_tables.empty()) {
+      std::vector<G2> _bases;
+      _bases.reserve(cache.m_hidden_indices.size());
+      for (size_t i : cache.m_hidden_indices) {
+        _bases.push_back(m_pk.YYi[i]);
+      }
+      G2::mulVec(cache.m_partial_k, _bases.data(), cache.m_attribute_hashes.data(), _bases.size());
+    }
+    else {
+      cache.m_partial_k.clear();
+      for (size_t j = 0; j < cache.m_hidden_indices.size(); j++) {
+        m_tables.YYi[cache.m_hidden_indices[j]].mulAdd(cache.m_partial_k, cache.m_attribute_hashes[j]);
+      }
+    }
+    G2::add(cache.m_partial_k, cache.m_partial_k, m_pk.XX);
+  }
+  cache.m_ready = true;
+}
+
+void
+PSRequester::prepare_presentation(const PSCredential& sig, const PSAttributeCache& cache,
+                                  const PSAuthorityContext* authority,
+                                  PSPresentationContext& context) const
+{
+  if (cache.empty()) {
+    throw std::runtime_error("attribute cache is empty");
+  }
+
+  context.m_ready = false;
+  context.m_randomnesses.clear();
+  context.m_bases.clear();
+  context.m_id_retrieval = authority != nullptr;
 
   /** NIZK Prove:
    * Public Value: will be sent
    * * k = XX * PI{ YY_j^attribute_j } * gg^t
    * * phi = hash(domain)^s
-   * * E1 = g^epsilon
-   * * E2 = y^epsilon * h^gamma
+   * * E1 = g^epsilon (with id retrieval)
+   * * E2 = y^epsilon * h^gamma (with id retrieval)
    *
    * Public Random Value: will not be sent
    * * V_k = XX * PI{ YYj^random1_j } * gg^random_2
    * * V_phi = hash(domain)^random1_s
-   * * V_E1 = g^random_3
-   * * V_E2 = y^random_3 * h^random1_gamma
+   * * V_E1 = g^random_3 (with id retrieval)
+   * * V_E2 = y^random_3 * h^random1_gamma (with id retrieval)
    *
-   * c: will be sent
-   * c = hash(k || phi || E1 || E2 || V_k || V_phi || V_E1 || V_E2 || associated_data )
-   *
-   * Rs: will be sent
-   * * random1_j - attribute_j * c
-   * * random2 - t * c
-   * * random3 - epsilon * c
+   * Everything but phi and V_phi is computed here.
    */
-  // V_k = XX * PI{ YYj^random1_j } * gg^random_2
-  G2 _V_k = m_pk.XX;
-  std::vector<Fr> _randomnesses;
-  Fr _temp_randomness;
-  G2 _yy_randomness;
-  _randomnesses.reserve(attributes.size() + 2);
-  for (size_t i = 0; i < attributes.size(); i++) {
-    if (std::get<1>(attributes[i])) {
-      _temp_randomness.setByCSPRNG();
-      _randomnesses.push_back(_temp_randomness);
-      G2::mul(_yy_randomness, m_pk.YYi[i], _temp_randomness);
-      G2::add(_V_k, _V_k, _yy_randomness);
-    }
+  // all randomness is drawn on the calling thread first, so the proof does not depend on the thread pool
+  Fr _r, _random3;
+  PSRandom::generateFr(context.m_t);
+  PSRandom::generateFr(_r);
+  size_t _hidden_num = cache.m_hidden_indices.size();
+  context.m_randomnesses.resize(_hidden_num + 1);  // random1_j..., random2
+  PSRandom::generateFrs(context.m_randomnesses.data(), _hidden_num + 1);
+  if (context.m_id_retrieval) {
+    PSRandom::generateFr(context.m_epsilon);
+    PSRandom::generateFr(_random3);
+    context.m_randomnesses.push_back(_random3);
   }
-  _temp_randomness.setByCSPRNG();
-  _randomnesses.push_back(_temp_randomness);  // random2
-  G2::mul(_yy_randomness, m_pk.gg, _temp_randomness);
-  G2::add(_V_k, _V_k, _yy_randomness);
 
-  // V_phi
-  G1 _V_phi;
-  G1::mul(_V_phi, _service_hash, _randomnesses[0]);  // random1_s
-
-  // V_E1 = g^random_3
-  G1 _V_E1;
-  _temp_randomness.setByCSPRNG();
-  _randomnesses.push_back(_temp_randomness);  // random 3
-  G1::mul(_V_E1, g, _temp_randomness);
-
-  // V_E2 = y^random_3 * h^random1_gamma
-  G1 _V_E2;
-  G1 _h_random;
-  G1::mul(_V_E2, authority_pk, _temp_randomness);
-  G1::mul(_h_random, h, _randomnesses[1]);  // random1_gamma
-  G1::add(_V_E2, _V_E2, _h_random);
-
-  // Calculate c = hash(k || phi || E1 || E2 || V_k || V_phi || V_E1 || V_E2 || associated_data )
-  cybozu::Sha256 digest_engine;
-  digest_engine.update(proof.k.serializeToHexStr());
-  digest_engine.update(proof.phi.serializeToHexStr());
-  digest_engine.update(_E1.serializeToHexStr());
-  digest_engine.update(_E2.serializeToHexStr());
-  digest_engine.update(_V_k.serializeToHexStr());
-  digest_engine.update(_V_phi.serializeToHexStr());
-  digest_engine.update(_V_E1.serializeToHexStr());
-  digest_engine.update(_V_E2.serializeToHexStr());
-  auto _c_str = digest_engine.digest(associated_data);
-  proof.c.setHashOf(_c_str);
-  // std::cout << "parepare: V k: " << _V_k.serializeToHexStr() << std::endl;
-  // std::cout << "parepare: V phi: " << _V_phi.serializeToHexStr() << std::endl;
-  // std::cout << "parepare: V E1: " << _V_E1.serializeToHexStr() << std::endl;
-  // std::cout << "parepare: V E2: " << _V_E2.serializeToHexStr() << std::endl;
-
-  // Calculate Rs
-  Fr _temp_r;
-  Fr _secret_c;
-  proof.rs.reserve(attributes.size() + 2);
-  for (size_t i = 0; i < _attribute_hashes.size(); i++) {
-    Fr::mul(_secret_c, _attribute_hashes[i], proof.c);
-    Fr::sub(_temp_r, _randomnesses[i], _secret_c);
-    proof.rs.push_back(_temp_r);
+  // phi = hash(service_name)^s is computed online
+  context.m_s = cache.m_s;
+
+  // k = XX * PI{ YYj^mj } * gg^t and V_k = XX * PI{ YYj^random1_j } * gg^random_2 share their bases,
+  // so they are computed together: in one pass over each table, or as two MSMs over one base array.
+  // With XX * PI{ YYj^mj } cached, only gg^t is left for k.
+  context.m_attribute_hashes = cache.m_attribute_hashes;
+  auto& _bases = context.m_bases;
+  for (size_t i : cache.m_hidden_indices) {
+    _bases.push_back(m_pk.YYi[i]);
+  }
+  // the exponents of gg go last
+  context.m_attribute_hashes.push_back(context.m_t);
+  _bases.push_back(m_pk.gg);
+
+  G1 _V_E1, _V_E2;
+  auto commit_g1 = [&] {
+    PS_PHASE(REQUESTER, G1_MUL);
+    // new_sig = sig1^r, (sig2 + sig1^t)^r
+    G1::mul(context.m_sig1, sig.sig1, _r);
+    G1::mul(context.m_sig2, sig.sig1, context.m_t);
+    G1::add(context.m_sig2, context.m_sig2, sig.sig2);
+    G1::mul(context.m_sig2, context.m_sig2, _r);
+    if (!context.m_id_retrieval) {
+      return;
+    }
+    // El Gamal Cipher E = g^epsilon, y^epsilon * h^gamma, with V_E1 = g^random_3 and
+    // V_E2 = y^random_3 * h^random1_gamma, each pair in one pass over the table of its base
+    context.m_E1.clear();
+    context.m_E2.clear();
+    _V_E1.clear();
+    _V_E2.clear();
+    authority->mulAdd2(PSAuthorityContext::G, context.m_E1, context.m_epsilon, _V_E1, _random3);
+    authority->mulAdd2(PSAuthorityContext::AUTHORITY_PK, context.m_E2, context.m_epsilon, _V_E2, _random3);
+    authority->mulAdd2(PSAuthorityContext::H, context.m_E2, cache.m_gamma,
+                       _V_E2, context.m_randomnesses[1]);  // random1_gamma
+  };
+
+  G2 _V_k;
+  size_t _term_num = _hidden_num + 1;
+  size_t _chunk_num = m_thread_pool == nullptr ? 1 : std::min(m_thread_pool->size(), _term_num / PS_MIN_TERMS_PER_TASK);
+  if (_chunk_num <= 1) {
+    commit_g1();
+    commit_range(cache, context, 0, _term_num, context.m_k, _V_k);
+  }
+  else {
+    // the G1 terms are one more task next to the ranges of G2 terms, all joined before the transcript
+    std::vector<G2> _k_parts(_chunk_num), _V_k_parts(_chunk_num);
+    m_thread_pool->parallelFor(_chunk_num + 1, [&](size_t begin, size_t end) {
+      for (size_t c = begin; c < end; c++) {
+        if (c == _chunk_num) {
+          commit_g1();
+        }
+        else {
+          commit_range(cache, context, _term_num * c / _chunk_num, _term_num * (c + 1) / _chunk_num,
+                       _k_parts[c], _V_k_parts[c]);
+        }
+      }
+    });
+    context.m_k = _k_parts[0];
+    _V_k = _V_k_parts[0];
+    for (size_t c = 1; c < _chunk_num; c++) {
+      G2::add(context.m_k, context.m_k, _k_parts[c]);
+      G2::add(_V_k, _V_k, _V_k_parts[c]);
+    }
+  }
+  context.m_attribute_hashes.pop_back();
+  G2::add(context.m_k, context.m_k, cache.m_has_partial_k ? cache.m_partial_k : m_pk.XX);
+  G2::add(_V_k, _V_k, m_pk.XX);
+
+  {
+    PS_PHASE(REQUESTER, TRANSCRIPT);
+    PSTranscript::toHex(context.m_k_hex, context.m_k);
+    PSTranscript::toHex(context.m_V_k_hex, _V_k);
+    if (context.m_id_retrieval) {
+      PSTranscript::toHex(context.m_E1_hex, context.m_E1);
+      PSTranscript::toHex(context.m_E2_hex, context.m_E2);
+      PSTranscript::toHex(context.m_V_E1_hex, _V_E1);
+      PSTranscript::toHex(context.m_V_E2_hex, _V_E2);
+    }
   }
-  Fr::mul(_secret_c, _t, proof.c);
-  Fr::sub(_temp_r, _randomnesses[_randomnesses.size() - 2], _secret_c);
-  proof.rs.push_back(_temp_r);
-  Fr::mul(_secret_c, _epsilon, proof.c);
-  Fr::sub(_temp_r, _randomnesses[_randomnesses.size() - 1], _secret_c);
-  proof.rs.push_back(_temp_r);
 
   // plaintext attributes
-  proof.attributes.reserve(attributes.size());
-  for (size_t i = 0; i < attributes.size(); i++) {
-    if (std::get<1>(attributes[i])) {
-      proof.attributes.push_back("");
+  context.m_attributes = cache.m_attributes;
+  context.m_ready = true;
+}
+
+void
+PSRequester::commit_range(const PSAttributeCache& cache, PSPresentationContext& context,
+                          size_t begin, size_t end, G2& k, G2& V_k) const
+{
+  PS_PHASE(REQUESTER, G2_MUL);
+  size_t _hidden_num = cache.m_hidden_indices.size();
+  // with XX * PI{ YYj^mj } cached, k only takes gg^t
+  size_t _k_begin = cache.m_has_partial_k ? std::max(begin, _hidden_num) : begin;
+  if (m_tables.empty()) {
+    if (_k_begin < end) {
+      G2::mulVec(k, &context.m_bases[_k_begin], &context.m_attribute_hashes[_k_begin], end - _k_begin);
     }
     else {
-      proof.attributes.push_back(std::get<0>(attributes[i]));
+      k.clear();
+    }
+    G2::mulVec(V_k, &context.m_bases[begin], &context.m_randomnesses[begin], end - begin);
+    return;
+  }
+  k.clear();
+  V_k.clear();
+  for (size_t j = begin; j < end; j++) {
+    const auto& _table = j < _hidden_num ? m_tables.YYi[cache.m_hidden_indices[j]] : m_tables.gg;
+    if (j >= _k_begin) {
+      _table.mulAdd2(k, context.m_attribute_hashes[j], V_k, context.m_randomnesses[j]);
+    }
+    else {
+      _table.mulAdd(V_k, context.m_randomnesses[j]);
     }
   }
-  // sig1, sig2, k, phi, E1, E2, c, rs, attributes
-  proof.E1 = _E1;
-  proof.E2 = _E2;
-  return proof;
 }
 
-IdProof  // sig1, sig2, k, phi, c, rs, attributes
-PSRequester::el_passo_prove_id_without_id_retrieval(const PSCredential& sig,
-                                                    const std::vector<std::tuple<std::string, bool>> attributes,
-                                                    const std::string& associated_data,
-                                                    const std::string& service_name) const
+IdProof
+PSRequester::el_passo_prove_id_online(PSPresentationContext&& context,
+                                      const std::string& associated_data,
+                                      const std::string& service_name) const
 {
-  size_t maxAllowedAttrNum = m_pk.Yi.size();
-  if (attributes.size() != maxAllowedAttrNum) {
-    throw std::runtime_error("attribute size does not match");
+  PS_SPAN("el_passo_prove_id_online");
+  if (context.empty()) {
+    throw std::runtime_error("presentation context is empty");
   }
+  // the context must not be used twice, even if this function throws
+  PSPresentationContext _context = std::move(context);
+  context = PSPresentationContext();
 
-  IdProof proof;
-  // new_sig = sig1^r, (sig2 + sig1^t)^r
-  Fr _t, _r;
-  _t.setByCSPRNG();
-  _r.setByCSPRNG();
-  G1::mul(proof.sig1, sig.sig1, _r);
-  G1::mul(proof.sig2, sig.sig1, _t);
-  G1::add(proof.sig2, proof.sig2, sig.sig2);
-  G1::mul(proof.sig2, proof.sig2, _r);
-
-  // phi = hash(service_name)^s
   G1 _service_hash;
-  Fr _s;
-  hashAndMapToG1(_service_hash, service_name);
-  _s.setHashOf(std::get<0>(attributes[0]));
-  G1::mul(proof.phi, _service_hash, _s);
+  {
+    PS_PHASE(REQUESTER, HASH);
+    hashAndMapToG1(_service_hash, service_name);
+  }
+  IdProof proof;
+  prove_online(_context, associated_data, _service_hash, proof);
+  return proof;
+}
 
-  // k = XX * PI{ YYj^mj } * gg^t
-  proof.k = m_pk.XX;
-  Fr _attribute_hash;
-  G2 _yy_hash;
-  std::vector<Fr> _attribute_hashes;
-  _attribute_hashes.reserve(attributes.size());
-  for (size_t i = 0; i < attributes.size(); i++) {
-    if (std::get<1>(attributes[i])) {
-      _attribute_hash.setHashOf(std::get<0>(attributes[i]));
-      _attribute_hashes.push_back(_attribute_hash);
-      G2::mul(_yy_hash, m_pk.YYi[i], _attribute_hash);
-      G2::add(proof.k, proof.k, _yy_hash);
+void
+PSRequester::prove_online(PSPresentationContext& context,
+                          std::string_view associated_data,
+                          const G1& service_hash,
+                          IdProof& proof) const
+{
+  context.m_ready = false;
+  proof.sig1 = context.m_sig1;
+  proof.sig2 = context.m_sig2;
+  proof.k = context.m_k;
+
+  // phi = hash(service_name)^s, V_phi = hash(domain)^random1_s
+  G1 _V_phi;
+  {
+    PS_PHASE(REQUESTER, G1_MUL);
+    G1::mul(proof.phi, service_hash, context.m_s);
+    G1::mul(_V_phi, service_hash, context.m_randomnesses[0]);  // random1_s
+  }
+
+  // Calculate c = hash(k || phi || E1 || E2 || V_k || V_phi || V_E1 || V_E2 || associated_data ) with id retrieval
+  // or c = hash(k || phi || V_k || V_phi || associated_data ) without
+  {
+    PS_PHASE(REQUESTER, TRANSCRIPT);
+    PSTranscript transcript;
+    transcript.append(context.m_k_hex);
+    transcript.append(proof.phi);
+    if (context.m_id_retrieval) {
+      transcript.append(context.m_E1_hex);
+      transcript.append(context.m_E2_hex);
+    }
+    transcript.append(context.m_V_k_hex);
+    transcript.append(_V_phi);
+    if (context.m_id_retrieval) {
+      transcript.append(context.m_V_E1_hex);
+      transcript.append(context.m_V_E2_hex);
     }
+    transcript.challenge(proof.c, associated_data);
   }
-  G2::mul(_yy_hash, m_pk.gg, _t);
-  G2::add(proof.k, proof.k, _yy_hash);
 
-  /** NIZK Prove:
-   * Public Value: will be sent
-   * * k = XX * PI{ YY_j^attribute_j } * gg^t
-   * * phi = hash(domain)^s
-   *
-   * Public Random Value: will not be sent
-   * * V_k = XX * PI{ YYj^random1_j } * gg^random_2
-   * * V_phi = hash(domain)^random1_s
-   *
-   * c: will be sent
-   * c = hash(k || phi || V_k || V_phi || associated_data )
-   *
-   * Rs: will be sent
+  /** Rs: will be sent
    * * random1_j - attribute_j * c
    * * random2 - t * c
+   * * random3 - epsilon * c (with id retrieval)
    */
-  // V_k = XX * PI{ YYj^random1_j } * gg^random_2
-  G2 _V_k = m_pk.XX;
-  std::vector<Fr> _randomnesses;
-  Fr _temp_randomness;
-  G2 _yy_randomness;
-  _randomnesses.reserve(attributes.size() + 1);
-  for (size_t i = 0; i < attributes.size(); i++) {
-    if (std::get<1>(attributes[i])) {
-      _temp_randomness.setByCSPRNG();
-      _randomnesses.push_back(_temp_randomness);
-      G2::mul(_yy_randomness, m_pk.YYi[i], _temp_randomness);
-      G2::add(_V_k, _V_k, _yy_randomness);
-    }
-  }
-  _temp_randomness.setByCSPRNG();
-  _randomnesses.push_back(_temp_randomness);  // random2
-  G2::mul(_yy_randomness, m_pk.gg, _temp_randomness);
-  G2::add(_V_k, _V_k, _yy_randomness);
-
-  // V_phi = hash(domain)^random1_s
-  G1 _V_phi;
-  G1::mul(_V_phi, _service_hash, _randomnesses[0]);  // random1_s
-
-  // Calculate c = hash(k || phi || V_k || V_phi || associated_data )
-  cybozu::Sha256 digest_engine;
-  digest_engine.update(proof.k.serializeToHexStr());
-  digest_engine.update(proof.phi.serializeToHexStr());
-  digest_engine.update(_V_k.serializeToHexStr());
-  digest_engine.update(_V_phi.serializeToHexStr());
-  auto _c_str = digest_engine.digest(associated_data);
-  proof.c.setHashOf(_c_str);
-  // std::cout << "parepare: V k: " << _V_k.serializeToHexStr() << std::endl;
-  // std::cout << "parepare: V phi: " << _V_phi.serializeToHexStr() << std::endl;
-
-  // Calculate Rs
   Fr _temp_r;
   Fr _secret_c;
-  proof.rs.reserve(attributes.size() + 1);
-  for (size_t i = 0; i < _attribute_hashes.size(); i++) {
-    Fr::mul(_secret_c, _attribute_hashes[i], proof.c);
+  const auto& _randomnesses = context.m_randomnesses;
+  proof.rs.clear();
+  for (size_t i = 0; i < context.m_attribute_hashes.size(); i++) {
+    Fr::mul(_secret_c, context.m_attribute_hashes[i], proof.c);
     Fr::sub(_temp_r, _randomnesses[i], _secret_c);
     proof.rs.push_back(_temp_r);
   }
-  Fr::mul(_secret_c, _t, proof.c);
-  Fr::sub(_temp_r, _randomnesses[_randomnesses.size() - 1], _secret_c);
+  size_t _random2_index = context.m_attribute_hashes.size();
+  Fr::mul(_secret_c, context.m_t, proof.c);
+  Fr::sub(_temp_r, _randomnesses[_random2_index], _secret_c);
   proof.rs.push_back(_temp_r);
-
-  // plaintext attributes
-  proof.attributes.reserve(attributes.size());
-  for (size_t i = 0; i < attributes.size(); i++) {
-    if (std::get<1>(attributes[i])) {
-      proof.attributes.push_back("");
-    }
-    else {
-      proof.attributes.push_back(std::get<0>(attributes[i]));
-    }
+  if (context.m_id_retrieval) {
+    Fr::mul(_secret_c, context.m_epsilon, proof.c);
+    Fr::sub(_temp_r, _randomnesses[_random2_index + 1], _secret_c);
+    proof.rs.push_back(_temp_r);
+    proof.E1 = context.m_E1;
+    proof.E2 = context.m_E2;
   }
-  // sig1, sig2, k, phi, c, rs, attributes
-  return proof;
-}
\ No newline at end of file
+  else {
+    proof.E1.reset();
+    proof.E2.reset();
+  }
+  // the context gets the strings of the old proof, whose storage the next prepare_presentation() reuses
+  proof.attributes.swap(context.m_attributes);
+  // sig1, sig2, k, phi, (E1, E2,) c, rs, attributes
+}
+
+PSPresentationContext::PSPresentationContext(PSPresentationContext&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+PSPresentationContext&
+PSPresentationContext::operator=(PSPresentationContext&& other) noexcept
+{
+  m_ready = other.m_ready;
+  m_id_retrieval = other.m_id_retrieval;
+  m_sig1 = other.m_sig1;
+  m_sig2 = other.m_sig2;
+  m_k = other.m_k;
+  m_t = other.m_t;
+  m_s = other.m_s;
+  m_epsilon = other.m_epsilon;
+  m_E1 = other.m_E1;
+  m_E2 = other.m_E2;
+  m_attribute_hashes = std::move(other.m_attribute_hashes);
+  m_randomnesses = std::move(other.m_randomnesses);
+  m_attributes = std::move(other.m_attributes);
+  m_k_hex = std::move(other.m_k_hex);
+  m_E1_hex = std::move(other.m_E1_hex);
+  m_E2_hex = std::move(other.m_E2_hex);
+  m_V_k_hex = std::move(other.m_V_k_hex);
+  m_V_E1_hex = std::move(other.m_V_E1_hex);
+  m_V_E2_hex = std::move(other.m_V_E2_hex);
+  m_bases = std::move(other.m_bases);
+  // the moved-from context must not prove with the same randomness
+  other.clear();
+  return *this;
+}
+
+PSPresentationContext::~PSPresentationContext()
+{
+  clear();
+  // the stores of clear() must not be dropped as dead because the object ends here
+  asm volatile("" : : "r"(this) : "memory");
+}
+
+bool
+PSPresentationContext::empty() const
+{
+  return !m_ready;
+}
+
+void
+PSPresentationContext::clear()
+{
+  m_ready = false;
+  clearScalars(m_attribute_hashes);
+  clearScalars(m_randomnesses);
+  m_t.clear();
+  m_s.clear();
+  m_epsilon.clear();
+}
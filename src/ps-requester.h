@@ -1,10 +1,143 @@
 #ifndef PS_SRC_PS_REQUESTER_H_
 #define PS_SRC_PS_REQUESTER_H_
 
+#include "ps-authority.h"
 #include "ps-encoding.h"
+#include "ps-precompute.h"
+#include "ps-thread-pool.h"
+
+#include <string_view>
 
 using namespace mcl::bls12;
 
+class PSRequester;
+
+/**
+ * @brief An attribute and whether it is committed, viewed without copying the attribute.
+ */
+using PSAttributeView = std::tuple<std::string_view, bool>;
+
+/**
+ * @brief The blinding factor of one credential request, needed to unblind the credential issued for it.
+ *
+ * Keeping it outside of PSRequester lets one requester have any number of requests in flight,
+ * e.g., from several threads.
+ */
+class PSBlindingContext {
+public:
+  /**
+   * @brief Whether the context holds no blinding factor, e.g., because no request has been made with it.
+   */
+  bool
+  empty() const;
+
+private:
+  friend class PSRequester;
+
+  bool m_ready = false;
+  Fr m_t1;
+};
+
+/**
+ * @brief What EL PASSO ProveID derives from the attributes alone: the hashes of the committed attributes,
+ *        s, gamma, the plaintext attributes and, optionally, XX * PI{ YYj^mj }.
+ *
+ * PSWallet keeps one per credential so that repeated sign ons skip this work.
+ */
+class PSAttributeCache {
+public:
+  /**
+   * @brief Whether the cache holds nothing.
+   */
+  bool
+  empty() const;
+
+  /**
+   * @brief Erase the attribute hashes, s and gamma, and leave the cache empty. Storage is kept for reuse.
+   */
+  void
+  clear();
+
+private:
+  friend class PSRequester;
+
+  bool m_ready = false;
+  bool m_has_partial_k = false;
+  std::vector<size_t> m_hidden_indices;   // indices of the committed attributes
+  std::vector<Fr> m_attribute_hashes;     // hashes of the committed attributes
+  Fr m_s;                                 // hash of the first attribute
+  Fr m_gamma;                             // hash of the second attribute
+  std::vector<std::string> m_attributes;  // plaintext attributes, "" for committed ones
+  G2 m_partial_k;                         // XX * PI{ YYj^mj }, if m_has_partial_k
+};
+
+/**
+ * @brief The part of an EL PASSO ProveID that does not depend on the RP: the randomized signature,
+ *        k, V_k, the identity retrieval token (E1, E2) and its commitments V_E1 and V_E2.
+ *
+ * A context is single use. Proving twice with the same randomness would reveal the committed attributes,
+ * so PSRequester::el_passo_prove_id_online() consumes it, and a context can be moved but not copied.
+ */
+class PSPresentationContext {
+public:
+  PSPresentationContext() = default;
+
+  PSPresentationContext(const PSPresentationContext&) = delete;
+
+  PSPresentationContext&
+  operator=(const PSPresentationContext&) = delete;
+
+  /**
+   * @brief Take over the material of @p other, which is left empty.
+   */
+  PSPresentationContext(PSPresentationContext&& other) noexcept;
+
+  PSPresentationContext&
+  operator=(PSPresentationContext&& other) noexcept;
+
+  /**
+   * @brief Erase the secrets, however the context goes away.
+   */
+  ~PSPresentationContext();
+
+  /**
+   * @brief Whether the context holds no material, e.g., because it has been consumed.
+   */
+  bool
+  empty() const;
+
+  /**
+   * @brief Erase the secrets (attribute hashes, t, s, epsilon and the randomnesses) and leave the context
+   *        empty, e.g., to discard a context that will not be used. Storage is kept for reuse.
+   */
+  void
+  clear();
+
+private:
+  friend class PSRequester;
+
+  bool m_ready = false;
+  bool m_id_retrieval = false;
+  G1 m_sig1;
+  G1 m_sig2;
+  G2 m_k;
+  Fr m_t;
+  Fr m_s;
+  Fr m_epsilon;
+  G1 m_E1;
+  G1 m_E2;
+  std::vector<Fr> m_attribute_hashes;  // committed attributes
+  std::vector<Fr> m_randomnesses;      // random1_j..., random2, random3 (with id retrieval)
+  std::vector<std::string> m_attributes;  // plaintext attributes, "" for committed ones
+  std::string m_k_hex;
+  std::string m_E1_hex;
+  std::string m_E2_hex;
+  std::string m_V_k_hex;
+  std::string m_V_E1_hex;
+  std::string m_V_E2_hex;
+  std::vector<G2> m_bases;  // YYj of the committed attributes, then gg
+};
+
 /**
  * The requester who wants to get a PS credential from the signer.
  */
@@ -20,6 +153,36 @@ public:
   size_t
   maxAllowedAttrNum() const;
 
+  /**
+   * @brief Build fixed-base tables for gg and every YYi, used by all later ProveID operations.
+   *
+   * Each table takes PSFixedBaseTable<G2>::BYTE_SIZE bytes, which pays off for users proving repeatedly.
+   */
+  void
+  precompute();
+
+  /**
+   * @brief Use tables built elsewhere.
+   *
+   * @param tables input Tables built from this requester's public key.
+   * @throw std::runtime_error if the tables do not match the attribute number.
+   */
+  void
+  use_tables(const PSRequesterTables& tables);
+
+  /**
+   * @brief Split each ProveID of many committed attributes across @p thread_pool.
+   *
+   * The G2 terms of k and V_k are split into ranges, and the G1 terms (the randomized signature and
+   * the identity retrieval token) run as one more task. All of them are joined before the transcript
+   * hash, and the proof is the same as without the pool. Proofs of a few attributes stay on the calling thread.
+   *
+   * @param thread_pool input The pool, which must outlive its use, or nullptr to stop using one.
+   *        Proofs must not be made from tasks running on the same pool.
+   */
+  void
+  use_thread_pool(PSThreadPool* thread_pool);
+
   /**
    * @brief Generate a request along with a NIZK proof for the PSSigner to sign over requester's
    *        blinded attributes and plaintext attributes.
@@ -39,6 +202,36 @@ public:
   el_passo_request_id(const std::vector<std::tuple<std::string, bool>> attributes,  // string is the attribute, bool whether to hide
                       const std::string& associated_data);
 
+  /**
+   * @brief Same as above, but the blinding factor goes to @p context instead of this requester.
+   *
+   * @param attributes input As above.
+   * @param associated_data input As above.
+   * @param context output The blinding factor, to be passed to PSRequester::unblind_credential().
+   * @return PSCredRequest as above.
+   */
+  PSCredRequest
+  el_passo_request_id(const std::vector<std::tuple<std::string, bool>>& attributes,
+                      const std::string& associated_data,
+                      PSBlindingContext& context) const;
+
+  /**
+   * @brief Same as above, without copying the attributes and into a caller-owned request.
+   *
+   * The vectors of @p request keep their capacity, so requests made repeatedly into the same
+   * PSCredRequest do not allocate.
+   *
+   * @param attributes input An array of @p attribute_num attributes.
+   * @param attribute_num input The number of attributes.
+   * @param associated_data input As above.
+   * @param context output As above.
+   * @param request output The request, overwritten.
+   */
+  void
+  el_passo_request_id(const PSAttributeView* attributes, size_t attribute_num,
+                      std::string_view associated_data,
+                      PSBlindingContext& context, PSCredRequest& request) const;
+
   /**
    * Unblind the signature after the PSSigner signs requester's attribtues.
    *
@@ -50,6 +243,17 @@ public:
   PSCredential
   unblind_credential(const PSCredential& sig) const;
 
+  /**
+   * @brief Unblind the signature issued for the request made with @p context.
+   *
+   * @param sig input The PS signature returned by the PSSigner.
+   * @param context input The context filled by PSRequester::el_passo_request_id().
+   * @return PSCredential as above.
+   * @throw std::runtime_error if @p context is empty.
+   */
+  PSCredential
+  unblind_credential(const PSCredential& sig, const PSBlindingContext& context) const;
+
   /**
    * Verify the signature over the given attributes (all in plaintext).
    *
@@ -110,21 +314,146 @@ public:
                     const std::string& service_name,
                     const G1& authority_pk, const G1& g, const G1& h) const;
 
+  /**
+   * @brief EL PASSO ProveID with the authority points of @p authority, whose tables (if precomputed)
+   *        compute E1, E2 and their commitments.
+   */
+  IdProof
+  el_passo_prove_id(const PSCredential& sig,
+                    const std::vector<std::tuple<std::string, bool>> attributes,
+                    const std::string& associated_data,
+                    const std::string& service_name,
+                    const PSAuthorityContext& authority) const;
+
   IdProof
   el_passo_prove_id_without_id_retrieval(const PSCredential& sig,
                                          const std::vector<std::tuple<std::string, bool>> attributes,
                                          const std::string& associated_data,
                                          const std::string& service_name) const;
 
+  /**
+   * @brief EL PASSO ProveID without copying the attributes and into a caller-owned proof.
+   *
+   * The intermediate values live in per-thread storage and the vectors of @p proof keep their capacity,
+   * so proofs made repeatedly into the same IdProof do not allocate.
+   *
+   * @param sig input The original PS signature.
+   * @param attributes input An array of @p attribute_num attributes.
+   * @param attribute_num input The number of attributes.
+   * @param associated_data input As in PSRequester::el_passo_prove_id().
+   * @param service_name input As in PSRequester::el_passo_prove_id().
+   * @param authority_pk input As in PSRequester::el_passo_prove_id().
+   * @param g input As in PSRequester::el_passo_prove_id().
+   * @param h input As in PSRequester::el_passo_prove_id().
+   * @param proof output The proof, overwritten.
+   */
+  void
+  el_passo_prove_id(const PSCredential& sig,
+                    const PSAttributeView* attributes, size_t attribute_num,
+                    std::string_view associated_data,
+                    std::string_view service_name,
+                    const G1& authority_pk, const G1& g, const G1& h,
+                    IdProof& proof) const;
+
+  void
+  el_passo_prove_id(const PSCredential& sig,
+                    const PSAttributeView* attributes, size_t attribute_num,
+                    std::string_view associated_data,
+                    std::string_view service_name,
+                    const PSAuthorityContext& authority,
+                    IdProof& proof) const;
+
+  void
+  el_passo_prove_id_without_id_retrieval(const PSCredential& sig,
+                                         const PSAttributeView* attributes, size_t attribute_num,
+                                         std::string_view associated_data,
+                                         std::string_view service_name,
+                                         IdProof& proof) const;
+
+  /**
+   * @brief The offline half of EL PASSO ProveID, which can run before the RP is known.
+   *
+   * PSRequester::el_passo_prove_id() is PSRequester::el_passo_prepare_prove_id() followed by
+   * PSRequester::el_passo_prove_id_online(). See PSPresentationPool for contexts prepared in the background.
+   *
+   * @param sig input The original PS signature.
+   * @param attributes input As in PSRequester::el_passo_prove_id().
+   * @param authority_pk input As in PSRequester::el_passo_prove_id().
+   * @param g input As in PSRequester::el_passo_prove_id().
+   * @param h input As in PSRequester::el_passo_prove_id().
+   * @return a context for a single PSRequester::el_passo_prove_id_online().
+   */
+  PSPresentationContext
+  el_passo_prepare_prove_id(const PSCredential& sig,
+                            const std::vector<std::tuple<std::string, bool>>& attributes,
+                            const G1& authority_pk, const G1& g, const G1& h) const;
+
+  PSPresentationContext
+  el_passo_prepare_prove_id(const PSCredential& sig,
+                            const std::vector<std::tuple<std::string, bool>>& attributes,
+                            const PSAuthorityContext& authority) const;
+
+  PSPresentationContext
+  el_passo_prepare_prove_id_without_id_retrieval(const PSCredential& sig,
+                                                 const std::vector<std::tuple<std::string, bool>>& attributes) const;
+
+  /**
+   * @brief The online half of EL PASSO ProveID: phi, V_phi, the transcript hash and the responses.
+   *
+   * @param context input A context prepared by this requester, which is consumed.
+   * @param associated_data input As in PSRequester::el_passo_prove_id().
+   * @param service_name input As in PSRequester::el_passo_prove_id().
+   * @return IdProof as PSRequester::el_passo_prove_id() or
+   *         PSRequester::el_passo_prove_id_without_id_retrieval(), depending on how @p context was prepared.
+   * @throw std::runtime_error if @p context is empty.
+   */
+  IdProof
+  el_passo_prove_id_online(PSPresentationContext&& context,
+                           const std::string& associated_data,
+                           const std::string& service_name) const;
+
 private:
+  friend class PSWallet;
+
+  // hashes the attributes and, if with_partial_k, computes XX * PI{ YYj^mj }, overwrites cache
+  void
+  cache_attributes(const PSAttributeView* attributes, size_t attribute_num, bool with_partial_k,
+                   PSAttributeCache& cache) const;
+
+  // shared by both el_passo_prepare_prove_id() variants, without id retrieval if authority is nullptr,
+  // overwrites context
+  void
+  prepare_presentation(const PSCredential& sig, const PSAttributeCache& cache,
+                       const PSAuthorityContext* authority,
+                       PSPresentationContext& context) const;
+
+  // k = PI{ base_j^exponent_j } and V_k = PI{ base_j^random_j } over terms [begin, end) of context,
+  // where term j < hidden num is the j-th committed attribute and the last one is gg
+  void
+  commit_range(const PSAttributeCache& cache, PSPresentationContext& context,
+               size_t begin, size_t end, G2& k, G2& V_k) const;
+
+  // el_passo_prove_id_online() on a context that the caller empties, overwrites proof
+  void
+  prove_online(PSPresentationContext& context,
+               std::string_view associated_data,
+               const G1& service_hash,
+               IdProof& proof) const;
+
   G2
   prepare_hybrid_verification(const G2& k, const std::vector<std::string>& attributes) const;
 
+  // shared by both unblind_credential() variants, with the blinding factor t1 of the request
+  static PSCredential
+  unblind(const PSCredential& sig, const Fr& t1);
+
 private:
   PSPubKey m_pk;  // public key
   Fr m_sk_x;      // private key, x
   G1 m_sk_X;      // private key, X
-  Fr m_t1;        // used for commiting attributes
+  Fr m_t1;        // used for commiting attributes, by the requests made without a PSBlindingContext
+  PSRequesterTables m_tables;  // empty if not precomputed
+  PSThreadPool* m_thread_pool = nullptr;  // splits single proofs if set
 };
 
 #endif  // PS_SRC_PS_REQUESTER_H_
\ No newline at end of file
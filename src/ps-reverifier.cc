@@ -0,0 +1,215 @@
+#include "ps-reverifier.h"
+#include "ps-thread-pool.h"
+#include "ps-verifier.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+static const char RESULTS_MAGIC[8] = {'P', 'S', 'V', 'E', 'R', 'D', 'C', 'T'};
+
+// what the proofs of a batch are verified with
+struct PSReverifyKeys {
+  std::shared_ptr<const PSVerifier> verifier;  // nullptr before the first PUBKEY record
+  std::optional<PSAuthorityContext> authority;  // empty before the first AUTHORITY record
+};
+
+struct PSReverifyBatch {
+  size_t seq = 0;
+  std::shared_ptr<const PSReverifyKeys> keys;
+  std::vector<PSCorpusRecord> records;
+};
+
+// the verdicts of finished batches, written in archive order
+struct PSReverifyState {
+  std::mutex mutex;
+  std::condition_variable cv;
+  size_t in_flight = 0;
+  size_t next_seq = 0;  // the next batch to be written
+  std::map<size_t, std::vector<uint8_t>> done;
+  std::exception_ptr error;
+  PSReverifyReport report;
+};
+
+// decode every proof of the batch, then check them with one batched pairing check per verification kind
+static std::vector<uint8_t>
+verifyBatch(const PSReverifyBatch& batch)
+{
+  std::vector<uint8_t> verdicts(batch.records.size(), static_cast<uint8_t>(PSVerdict::MALFORMED));
+  const auto& keys = *batch.keys;
+  if (keys.verifier == nullptr) {
+    return verdicts;
+  }
+  // [0] with identity retrieval, [1] without
+  std::vector<IdProof> proofs[2];
+  std::vector<std::string> associated_data[2], service_names[2];
+  std::vector<size_t> indices[2];
+  for (size_t i = 0; i < batch.records.size(); i++) {
+    const auto& record = batch.records[i];
+    size_t group = record.kind == PSCorpusKind::PROOF ? 0 : 1;
+    if (record.context.size() != 2 || (group == 0 && !keys.authority.has_value())) {
+      continue;
+    }
+    try {
+      proofs[group].push_back(IdProof::fromBufferString(record.object));
+    }
+    catch (const std::exception&) {
+      continue;
+    }
+    associated_data[group].push_back(record.context[0]);
+    service_names[group].push_back(record.context[1]);
+    indices[group].push_back(i);
+  }
+
+  std::vector<bool> results;
+  for (size_t group = 0; group < 2; group++) {
+    if (proofs[group].empty()) {
+      continue;
+    }
+    if (group == 0) {
+      keys.verifier->el_passo_verify_id_batch(proofs[0], associated_data[0], service_names[0],
+                                              keys.authority.value(), results);
+    }
+    else {
+      keys.verifier->el_passo_verify_id_batch_without_id_retrieval(proofs[1], associated_data[1], service_names[1],
+                                                                   results);
+    }
+    for (size_t j = 0; j < indices[group].size(); j++) {
+      verdicts[indices[group][j]] = static_cast<uint8_t>(results[j] ? PSVerdict::VALID : PSVerdict::INVALID);
+    }
+  }
+  return verdicts;
+}
+
+PSReverifyReport
+PSReverifier::run(const std::string& archive_path, std::ostream& results, const PSReverifyOptions& options)
+{
+  auto begin = std::chrono::steady_clock::now();
+  size_t thread_num = options.thread_num;
+  if (thread_num == 0) {
+    thread_num = std::max(1u, std::thread::hardware_concurrency());
+  }
+  size_t batch_size = std::max<size_t>(1, options.batch_size);
+  size_t batches_in_flight = options.batches_in_flight == 0 ? 2 * thread_num : options.batches_in_flight;
+
+  PSCorpusReader reader(archive_path);
+  std::string header(RESULTS_MAGIC, sizeof(RESULTS_MAGIC));
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    header.push_back(static_cast<char>((VERSION >> shift) & 0xFF));
+  }
+  results.write(header.data(), header.size());
+
+  PSReverifyState state;
+  {
+    auto finish = [&state, &results](const PSReverifyBatch& batch, std::vector<uint8_t> verdicts,
+                                     std::exception_ptr error) {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      if (error && !state.error) {
+        state.error = error;
+      }
+      for (size_t i = 0; i < verdicts.size(); i++) {
+        auto verdict = static_cast<PSVerdict>(verdicts[i]);
+        state.report.proof_num++;
+        state.report.valid_num += verdict == PSVerdict::VALID;
+        state.report.invalid_num += verdict == PSVerdict::INVALID;
+        state.report.malformed_num += verdict == PSVerdict::MALFORMED;
+        state.report.mislabeled_num += (verdict == PSVerdict::VALID) != batch.records[i].expectedValid();
+      }
+      state.done.emplace(batch.seq, std::move(verdicts));
+      for (auto it = state.done.begin(); it != state.done.end() && it->first == state.next_seq;
+           it = state.done.erase(it)) {
+        results.write(reinterpret_cast<const char*>(it->second.data()), it->second.size());
+        state.next_seq++;
+        state.in_flight--;
+      }
+      state.cv.notify_all();
+    };
+
+    // the calling thread only reads, so every pool thread verifies; the pool finishes the queued
+    // batches before it goes away, also when reading throws
+    PSThreadPool pool(thread_num + 1);
+
+    auto batch = std::make_shared<PSReverifyBatch>();
+    auto keys = std::make_shared<PSReverifyKeys>();
+    batch->keys = keys;
+    size_t seq = 0;
+    auto submit = [&] {
+      if (batch->records.empty()) {
+        return;
+      }
+      {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.cv.wait(lock, [&] { return state.in_flight < batches_in_flight; });
+        state.in_flight++;
+      }
+      batch->seq = seq++;
+      pool.post([batch, &finish] {
+        std::vector<uint8_t> verdicts;
+        std::exception_ptr error;
+        try {
+          verdicts = verifyBatch(*batch);
+        }
+        catch (...) {
+          error = std::current_exception();
+          verdicts.assign(batch->records.size(), static_cast<uint8_t>(PSVerdict::MALFORMED));
+        }
+        finish(*batch, std::move(verdicts), error);
+      });
+      batch = std::make_shared<PSReverifyBatch>();
+      batch->keys = keys;
+    };
+
+    PSCorpusRecord record;
+    while (reader.next(record)) {
+      if (record.kind == PSCorpusKind::PUBKEY || record.kind == PSCorpusKind::AUTHORITY) {
+        // a batch is verified with one set of keys
+        submit();
+        keys = std::make_shared<PSReverifyKeys>(*keys);
+        if (record.kind == PSCorpusKind::PUBKEY) {
+          auto verifier = std::make_shared<PSVerifier>(PSPubKey::fromBufferString(record.object));
+          if (options.precompute) {
+            verifier->precompute();
+          }
+          keys->verifier = verifier;
+        }
+        else {
+          G1 authority_pk, g, h;
+          size_t offset = record.object.parseG1Element(0, authority_pk);
+          offset += record.object.parseG1Element(offset, g);
+          record.object.parseG1Element(offset, h);
+          keys->authority.emplace(authority_pk, g, h);
+          if (options.precompute) {
+            keys->authority->precompute();
+          }
+        }
+        batch->keys = keys;
+      }
+      else if (record.kind == PSCorpusKind::PROOF || record.kind == PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL) {
+        batch->records.push_back(std::move(record));
+        if (batch->records.size() == batch_size) {
+          submit();
+        }
+      }
+    }
+    submit();
+    std::unique_lock<std::mutex> lock(state.mutex);
+    state.cv.wait(lock, [&] { return state.in_flight == 0; });
+  }
+
+  if (state.error) {
+    std::rethrow_exception(state.error);
+  }
+  if (!results) {
+    throw std::runtime_error("cannot write verdicts");
+  }
+  state.report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  return state.report;
+}
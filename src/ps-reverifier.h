@@ -0,0 +1,62 @@
+#ifndef PS_SRC_PS_REVERIFIER_H_
+#define PS_SRC_PS_REVERIFIER_H_
+
+#include "ps-corpus.h"
+
+#include <ostream>
+#include <string>
+
+/**
+ * @brief The verdict on one archived proof.
+ */
+enum class PSVerdict : uint8_t {
+  INVALID,
+  VALID,
+  MALFORMED,  // the proof does not decode, or came before any public key
+};
+
+struct PSReverifyOptions {
+  size_t thread_num = 0;         // verifying threads, 0 for one per hardware thread
+  size_t batch_size = 64;        // proofs per batched pairing check
+  size_t batches_in_flight = 0;  // batches read ahead and not yet written, 0 for two per thread
+  bool precompute = true;        // build the tables of each public key and authority
+};
+
+struct PSReverifyReport {
+  size_t proof_num = 0;
+  size_t valid_num = 0;
+  size_t invalid_num = 0;
+  size_t malformed_num = 0;
+  size_t mislabeled_num = 0;  // proofs whose verdict differs from their corpus label
+  double seconds = 0;
+};
+
+/**
+ * @brief Re-verifies an archive of IdProofs, e.g., months of stored sign-on proofs for an audit.
+ *
+ * The archive is a corpus file (see PSCorpusWriter): PROOF and PROOF_WITHOUT_ID_RETRIEVAL records with
+ * the associated data and service name as context, each verified with the latest PUBKEY record and, for
+ * PROOF records, the latest AUTHORITY record before it. Other records are skipped.
+ *
+ * The calling thread reads the memory-mapped archive and cuts it into batches, worker threads decode and
+ * verify each batch with a single batched pairing check, and the verdicts are written in archive order.
+ * At most PSReverifyOptions::batches_in_flight batches are held at a time, so memory use does not grow
+ * with the archive.
+ */
+class PSReverifier {
+public:
+  static constexpr uint32_t VERSION = 1;
+
+public:
+  /**
+   * @brief Verify every proof in the archive at @p archive_path.
+   *
+   * @param results output The magic "PSVERDCT" and a 4-byte big-endian version, then one PSVerdict byte
+   *        per proof, in archive order.
+   * @throw std::runtime_error if the archive cannot be read or the results cannot be written.
+   */
+  static PSReverifyReport
+  run(const std::string& archive_path, std::ostream& results, const PSReverifyOptions& options = {});
+};
+
+#endif  // PS_SRC_PS_REVERIFIER_H_
@@ -0,0 +1,191 @@
+#include "ps-shared-tables.h"
+
+#include <cstring>
+#include <cybozu/sha2.hpp>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace mcl::bls12;
+
+static const char SHARED_TABLES_MAGIC[8] = {'P', 'S', 'T', 'A', 'B', 'L', 'E', 0};
+static const uint32_t SHARED_TABLES_VERSION = 1;
+static const size_t SHARED_TABLES_ALIGNMENT = 64;
+
+struct PSSharedTablesHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t ready;  // set to 1 by the publisher after all tables are written
+  uint32_t g1_size;
+  uint32_t g2_size;
+  uint32_t fp6_size;
+  uint32_t reserved;
+  uint64_t attribute_num;
+  uint64_t coeff_num;
+  uint8_t pk_digest[32];     // SHA-256 of the encoded public key
+  uint64_t signer_offset;    // tables of g, Y1, ..., Yn
+  uint64_t verifier_offset;  // tables of gg, XX, YY1, ..., YYn
+  uint64_t lines_offset;     // Miller lines of gg
+  uint64_t size;
+};
+
+static size_t
+alignUp(size_t offset)
+{
+  return (offset + SHARED_TABLES_ALIGNMENT - 1) / SHARED_TABLES_ALIGNMENT * SHARED_TABLES_ALIGNMENT;
+}
+
+static void
+digestPubKey(const PSPubKey& pk, uint8_t* digest)
+{
+  PSPubKey _pk = pk;
+  auto encoded = _pk.toBufferString();
+  cybozu::Sha256 digest_engine;
+  digest_engine.digest(digest, 32, encoded.data(), encoded.size());
+}
+
+static PSSharedTablesHeader
+makeHeader(const PSPubKey& pk)
+{
+  PSSharedTablesHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, SHARED_TABLES_MAGIC, sizeof(SHARED_TABLES_MAGIC));
+  header.version = SHARED_TABLES_VERSION;
+  header.g1_size = sizeof(G1);
+  header.g2_size = sizeof(G2);
+  header.fp6_size = sizeof(Fp6);
+  header.attribute_num = pk.Yi.size();
+  header.coeff_num = PSPairingTable::coeffNum();
+  digestPubKey(pk, header.pk_digest);
+  header.signer_offset = alignUp(sizeof(header));
+  header.verifier_offset = alignUp(header.signer_offset +
+                                   (header.attribute_num + 1) * PSFixedBaseTable<G1>::BYTE_SIZE);
+  header.lines_offset = alignUp(header.verifier_offset +
+                                (header.attribute_num + 2) * PSFixedBaseTable<G2>::BYTE_SIZE);
+  header.size = header.lines_offset + header.coeff_num * sizeof(Fp6);
+  return header;
+}
+
+PSSharedTables
+PSSharedTables::publish(const std::string& name, const PSPubKey& pk)
+{
+  auto header = makeHeader(pk);
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("cannot create shared memory " + name);
+  }
+  if (ftruncate(fd, header.size) != 0) {
+    close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error("cannot size shared memory " + name);
+  }
+  void* addr = mmap(nullptr, header.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    throw std::runtime_error("cannot map shared memory " + name);
+  }
+
+  uint8_t* base = static_cast<uint8_t*>(addr);
+  std::memcpy(base, &header, sizeof(header));
+  auto g1_tables = reinterpret_cast<G1*>(base + header.signer_offset);
+  PSFixedBaseTable<G1>::build(g1_tables, pk.g);
+  for (size_t i = 0; i < header.attribute_num; i++) {
+    PSFixedBaseTable<G1>::build(g1_tables + (i + 1) * PSFixedBaseTable<G1>::POINT_NUM, pk.Yi[i]);
+  }
+  auto g2_tables = reinterpret_cast<G2*>(base + header.verifier_offset);
+  PSFixedBaseTable<G2>::build(g2_tables, pk.gg);
+  PSFixedBaseTable<G2>::build(g2_tables + PSFixedBaseTable<G2>::POINT_NUM, pk.XX);
+  for (size_t i = 0; i < header.attribute_num; i++) {
+    PSFixedBaseTable<G2>::build(g2_tables + (i + 2) * PSFixedBaseTable<G2>::POINT_NUM, pk.YYi[i]);
+  }
+  PSPairingTable::build(reinterpret_cast<Fp6*>(base + header.lines_offset), pk.gg);
+
+  // workers attaching from now on see complete tables
+  auto published = reinterpret_cast<PSSharedTablesHeader*>(base);
+  __atomic_store_n(&published->ready, 1, __ATOMIC_RELEASE);
+  mprotect(addr, header.size, PROT_READ);
+  return fromRegion(std::make_shared<PSMappedRegion>(base, header.size));
+}
+
+PSSharedTables
+PSSharedTables::attach(const std::string& name, const PSPubKey& pk)
+{
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    throw std::runtime_error("cannot open shared memory " + name);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(PSSharedTablesHeader)) {
+    close(fd);
+    throw std::runtime_error("shared memory " + name + " is not ready");
+  }
+  void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error("cannot map shared memory " + name);
+  }
+  auto region = std::make_shared<PSMappedRegion>(static_cast<const uint8_t*>(addr), st.st_size);
+
+  auto published = reinterpret_cast<const PSSharedTablesHeader*>(region->data());
+  if (__atomic_load_n(&published->ready, __ATOMIC_ACQUIRE) != 1) {
+    throw std::runtime_error("shared memory " + name + " is not ready");
+  }
+  auto expected = makeHeader(pk);
+  if (std::memcmp(published->magic, expected.magic, sizeof(expected.magic)) != 0 ||
+      published->version != expected.version ||
+      published->g1_size != expected.g1_size ||
+      published->g2_size != expected.g2_size ||
+      published->fp6_size != expected.fp6_size ||
+      published->coeff_num != expected.coeff_num ||
+      published->size != region->size()) {
+    throw std::runtime_error("shared memory " + name + " was published by an incompatible build");
+  }
+  if (published->attribute_num != expected.attribute_num ||
+      std::memcmp(published->pk_digest, expected.pk_digest, sizeof(expected.pk_digest)) != 0) {
+    throw std::runtime_error("shared memory " + name + " was built from another public key");
+  }
+  return fromRegion(region);
+}
+
+void
+PSSharedTables::remove(const std::string& name)
+{
+  shm_unlink(name.c_str());
+}
+
+const PSSignerTables&
+PSSharedTables::signerTables() const
+{
+  return m_signer_tables;
+}
+
+const PSVerifierTables&
+PSSharedTables::verifierTables() const
+{
+  return m_verifier_tables;
+}
+
+PSSharedTables
+PSSharedTables::fromRegion(std::shared_ptr<PSMappedRegion> region)
+{
+  auto header = reinterpret_cast<const PSSharedTablesHeader*>(region->data());
+  PSSharedTables tables;
+  auto g1_tables = reinterpret_cast<const G1*>(region->data() + header->signer_offset);
+  tables.m_signer_tables.g = PSFixedBaseTable<G1>(g1_tables, region);
+  tables.m_signer_tables.Yi.reserve(header->attribute_num);
+  for (size_t i = 0; i < header->attribute_num; i++) {
+    tables.m_signer_tables.Yi.emplace_back(g1_tables + (i + 1) * PSFixedBaseTable<G1>::POINT_NUM, region);
+  }
+  auto g2_tables = reinterpret_cast<const G2*>(region->data() + header->verifier_offset);
+  tables.m_verifier_tables.gg = PSFixedBaseTable<G2>(g2_tables, region);
+  tables.m_verifier_tables.XX = PSFixedBaseTable<G2>(g2_tables + PSFixedBaseTable<G2>::POINT_NUM, region);
+  tables.m_verifier_tables.YYi.reserve(header->attribute_num);
+  for (size_t i = 0; i < header->attribute_num; i++) {
+    tables.m_verifier_tables.YYi.emplace_back(g2_tables + (i + 2) * PSFixedBaseTable<G2>::POINT_NUM, region);
+  }
+  tables.m_verifier_tables.gg_lines =
+      PSPairingTable(reinterpret_cast<const Fp6*>(region->data() + header->lines_offset), region);
+  return tables;
+}
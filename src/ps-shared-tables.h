@@ -0,0 +1,69 @@
+#ifndef PS_SRC_PS_SHARED_TABLES_H_
+#define PS_SRC_PS_SHARED_TABLES_H_
+
+#include "ps-precompute.h"
+
+using namespace mcl::bls12;
+
+/**
+ * @brief Precomputed tables of one public key, published once per host in a read-only POSIX shared
+ *        memory segment and attached zero-copy by every PSSigner and PSVerifier worker process.
+ *
+ * Typical use in a pre-forked server:
+ * @code
+ *   PSSharedTables::publish("/idp-tables", pk);  // parent, once
+ *   ...fork workers...
+ *   auto tables = PSSharedTables::attach("/idp-tables", pk);  // each worker
+ *   signer.use_tables(tables.signerTables());
+ * @endcode
+ *
+ * The segment holds raw points in the in-memory representation of this build, so every process must
+ * run the same build. The segment stays in /dev/shm until PSSharedTables::remove() is called.
+ */
+class PSSharedTables {
+public:
+  /**
+   * @brief Build the signer and verifier tables of @p pk into a new shared memory segment.
+   *
+   * The segment is marked ready only after all tables are written, and is read-only afterwards.
+   *
+   * @param name input The POSIX shared memory name, e.g., "/ps-tables".
+   * @param pk input The public key.
+   * @throw std::runtime_error if the segment already exists or cannot be created.
+   */
+  static PSSharedTables
+  publish(const std::string& name, const PSPubKey& pk);
+
+  /**
+   * @brief Attach to a segment published by PSSharedTables::publish().
+   *
+   * @param name input The POSIX shared memory name.
+   * @param pk input The public key the tables must have been built from.
+   * @throw std::runtime_error if the segment does not exist, is not ready yet, was built from another
+   *        public key, or was published by an incompatible build.
+   */
+  static PSSharedTables
+  attach(const std::string& name, const PSPubKey& pk);
+
+  /**
+   * @brief Remove the segment name. Processes still attached keep their mapping.
+   */
+  static void
+  remove(const std::string& name);
+
+  const PSSignerTables&
+  signerTables() const;
+
+  const PSVerifierTables&
+  verifierTables() const;
+
+private:
+  static PSSharedTables
+  fromRegion(std::shared_ptr<PSMappedRegion> region);
+
+private:
+  PSSignerTables m_signer_tables;
+  PSVerifierTables m_verifier_tables;
+};
+
+#endif  // PS_SRC_PS_SHARED_TABLES_H_
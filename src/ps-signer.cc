@@ -1,19 +1,53 @@
 #include "ps-signer.h"
+#include "ps-instrumentation.h"
+#include "ps-random.h"
+#include "ps-trace.h"
+#include "ps-transcript.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
-#include <cybozu/sha2.hpp>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace mcl::bls12;
 
+static const char KEY_FILE_MAGIC[8] = {'P', 'S', 'K', 'E', 'Y', 0, 0, 0};
+static const uint32_t KEY_FILE_VERSION = 1;
+static const size_t KEY_FILE_ALIGNMENT = 64;
+static const size_t KEY_GEN_STREAM_BLOCK_SIZE = 256;  // attributes generated and written at once
+
+struct PSKeyFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t g1_size;         // sizeof(G1) of the writer
+  uint32_t g2_size;         // sizeof(G2) of the writer
+  uint32_t g_encoded_size;  // size of g_encoded
+  uint8_t g_encoded[128];   // g in the portable encoding, used to detect an incompatible writer
+  uint64_t attribute_num;
+  uint64_t point_offset;    // X, g, gg, XX, Yi..., YYi...
+  uint64_t table_offset;    // tables of g, Y1, ..., Yn, 0 if not precomputed
+  uint64_t file_size;
+};
+
+static size_t
+alignUp(size_t offset)
+{
+  return (offset + KEY_FILE_ALIGNMENT - 1) / KEY_FILE_ALIGNMENT * KEY_FILE_ALIGNMENT;
+}
+
 PSSigner::PSSigner(size_t attribute_num)
     : m_attribute_num(attribute_num)
 {
   m_pk.Yi.reserve(m_attribute_num);
   m_pk.YYi.reserve(m_attribute_num);
   Fr temp;
-  temp.setByCSPRNG();
+  PSRandom::generateFr(temp);
   hashAndMapToG1(m_pk.g, temp.serializeToHexStr());
-  temp.setByCSPRNG();
+  PSRandom::generateFr(temp);
   hashAndMapToG2(m_pk.gg, temp.serializeToHexStr());
 }
 
@@ -26,13 +60,220 @@ PSSigner::PSSigner(size_t attribute_num, const G1& g, const G2& gg)
   m_pk.YYi.reserve(m_attribute_num);
 }
 
+PSSigner::PSSigner(const std::string& key_file_path)
+{
+  auto region = PSMappedRegion::mapFile(key_file_path);
+  if (region->size() < sizeof(PSKeyFileHeader)) {
+    throw std::runtime_error("key file is truncated");
+  }
+  PSKeyFileHeader header;
+  std::memcpy(&header, region->data(), sizeof(header));
+  if (std::memcmp(header.magic, KEY_FILE_MAGIC, sizeof(KEY_FILE_MAGIC)) != 0) {
+    throw std::runtime_error("not a key file");
+  }
+  if (header.version != KEY_FILE_VERSION) {
+    throw std::runtime_error("unsupported key file version");
+  }
+  if (header.g1_size != sizeof(G1) || header.g2_size != sizeof(G2)) {
+    throw std::runtime_error("key file was written by an incompatible build");
+  }
+  // the header is untrusted: bound the attribute number by the file before computing any size from it,
+  // and compare offsets by subtraction so that no sum can wrap around
+  size_t file_size = region->size();
+  if (header.file_size != file_size || header.attribute_num > file_size / (sizeof(G1) + sizeof(G2))) {
+    throw std::runtime_error("key file is truncated");
+  }
+  m_attribute_num = header.attribute_num;
+  size_t point_size = 2 * sizeof(G1) + 2 * sizeof(G2) + m_attribute_num * (sizeof(G1) + sizeof(G2));
+  if (header.point_offset > file_size || point_size > file_size - header.point_offset) {
+    throw std::runtime_error("key file is truncated");
+  }
+  if (header.table_offset != 0) {
+    if (m_attribute_num + 1 > file_size / PSFixedBaseTable<G1>::BYTE_SIZE) {
+      throw std::runtime_error("key file is truncated");
+    }
+    size_t table_size = (m_attribute_num + 1) * PSFixedBaseTable<G1>::BYTE_SIZE;
+    if (header.table_offset > file_size || table_size > file_size - header.table_offset ||
+        header.table_offset % alignof(G1) != 0) {
+      throw std::runtime_error("key file is truncated");
+    }
+  }
+
+  // points
+  const uint8_t* cursor = region->data() + header.point_offset;
+  std::memcpy(&m_sk_X, cursor, sizeof(G1));
+  cursor += sizeof(G1);
+  std::memcpy(&m_pk.g, cursor, sizeof(G1));
+  cursor += sizeof(G1);
+  std::memcpy(&m_pk.gg, cursor, sizeof(G2));
+  cursor += sizeof(G2);
+  std::memcpy(&m_pk.XX, cursor, sizeof(G2));
+  cursor += sizeof(G2);
+  m_pk.Yi.resize(m_attribute_num);
+  std::memcpy(m_pk.Yi.data(), cursor, m_attribute_num * sizeof(G1));
+  cursor += m_attribute_num * sizeof(G1);
+  m_pk.YYi.resize(m_attribute_num);
+  std::memcpy(m_pk.YYi.data(), cursor, m_attribute_num * sizeof(G2));
+
+  // the raw points are only meaningful if this build represents points the same way as the writer
+  G1 _g;
+  if (header.g_encoded_size > sizeof(header.g_encoded) ||
+      _g.deserialize(header.g_encoded, header.g_encoded_size) == 0 || _g != m_pk.g) {
+    throw std::runtime_error("key file was written by an incompatible build");
+  }
+
+  // tables are used in place
+  if (header.table_offset != 0) {
+    auto tables = reinterpret_cast<const G1*>(region->data() + header.table_offset);
+    m_tables.g = PSFixedBaseTable<G1>(tables, region);
+    m_tables.Yi.reserve(m_attribute_num);
+    for (size_t i = 0; i < m_attribute_num; i++) {
+      tables += PSFixedBaseTable<G1>::POINT_NUM;
+      m_tables.Yi.emplace_back(tables, region);
+    }
+  }
+}
+
 PSPubKey  // g, gg, XX, Yi, YYi
 PSSigner::key_gen()
 {
+  PSThreadPool pool(1);
+  return generate_key(pool, nullptr);
+}
+
+PSPubKey
+PSSigner::key_gen(PSThreadPool& pool)
+{
+  return generate_key(pool, nullptr);
+}
+
+PSPubKey
+PSSigner::key_gen(PSThreadPool& pool, std::ostream& pk_stream)
+{
+  return generate_key(pool, &pk_stream);
+}
+
+PSPubKey
+PSSigner::get_pub_key() const
+{
+  return m_pk;
+}
+
+void
+PSSigner::precompute()
+{
+  m_tables = PSSignerTables::build(m_pk);
+}
+
+void
+PSSigner::use_tables(const PSSignerTables& tables)
+{
+  if (tables.Yi.size() != m_attribute_num) {
+    throw std::runtime_error("table size does not match");
+  }
+  m_tables = tables;
+}
+
+void
+PSSigner::save_key(const std::string& key_file_path) const
+{
+  PSKeyFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, KEY_FILE_MAGIC, sizeof(KEY_FILE_MAGIC));
+  header.version = KEY_FILE_VERSION;
+  header.g1_size = sizeof(G1);
+  header.g2_size = sizeof(G2);
+  header.g_encoded_size = m_pk.g.serialize(header.g_encoded, sizeof(header.g_encoded));
+  header.attribute_num = m_attribute_num;
+  header.point_offset = alignUp(sizeof(header));
+  size_t point_size = 2 * sizeof(G1) + 2 * sizeof(G2) + m_attribute_num * (sizeof(G1) + sizeof(G2));
+  size_t table_size = 0;
+  if (!m_tables.empty()) {
+    header.table_offset = alignUp(header.point_offset + point_size);
+    table_size = (m_attribute_num + 1) * PSFixedBaseTable<G1>::BYTE_SIZE;
+  }
+  header.file_size = header.table_offset != 0 ? header.table_offset + table_size
+                                              : header.point_offset + point_size;
+
+  std::vector<uint8_t> file(header.file_size, 0);
+  std::memcpy(file.data(), &header, sizeof(header));
+  uint8_t* cursor = file.data() + header.point_offset;
+  std::memcpy(cursor, &m_sk_X, sizeof(G1));
+  cursor += sizeof(G1);
+  std::memcpy(cursor, &m_pk.g, sizeof(G1));
+  cursor += sizeof(G1);
+  std::memcpy(cursor, &m_pk.gg, sizeof(G2));
+  cursor += sizeof(G2);
+  std::memcpy(cursor, &m_pk.XX, sizeof(G2));
+  cursor += sizeof(G2);
+  std::memcpy(cursor, m_pk.Yi.data(), m_attribute_num * sizeof(G1));
+  cursor += m_attribute_num * sizeof(G1);
+  std::memcpy(cursor, m_pk.YYi.data(), m_attribute_num * sizeof(G2));
+  if (header.table_offset != 0) {
+    cursor = file.data() + header.table_offset;
+    std::memcpy(cursor, m_tables.g.data(), PSFixedBaseTable<G1>::BYTE_SIZE);
+    for (const auto& table : m_tables.Yi) {
+      cursor += PSFixedBaseTable<G1>::BYTE_SIZE;
+      std::memcpy(cursor, table.data(), PSFixedBaseTable<G1>::BYTE_SIZE);
+    }
+  }
+
+  // the key is written next to the target and renamed over it, so a crash never leaves a truncated key
+  // and a process that has the old file mapped keeps it intact
+  std::string temp_path = key_file_path + ".tmp";
+  std::string error;
+  int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0 || fchmod(fd, 0600) != 0) {
+    error = "cannot open " + temp_path;
+  }
+  size_t written = 0;
+  while (error.empty() && written < file.size()) {
+    ssize_t ret = write(fd, file.data() + written, file.size() - written);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      error = "cannot write " + temp_path;
+      break;
+    }
+    written += ret;
+  }
+  if (error.empty() && fsync(fd) != 0) {
+    error = "cannot sync " + temp_path;
+  }
+  if (fd >= 0 && close(fd) != 0 && error.empty()) {
+    error = "cannot write " + temp_path;
+  }
+  // the buffer holds X
+  explicit_bzero(file.data(), file.size());
+  if (error.empty() && rename(temp_path.c_str(), key_file_path.c_str()) != 0) {
+    error = "cannot rename " + temp_path + " to " + key_file_path;
+  }
+  if (!error.empty()) {
+    unlink(temp_path.c_str());
+    throw std::runtime_error(error);
+  }
+
+  // make the rename itself durable
+  size_t slash = key_file_path.rfind('/');
+  std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : key_file_path.substr(0, slash));
+  int directory_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (directory_fd >= 0) {
+    fsync(directory_fd);
+    close(directory_fd);
+  }
+}
+
+PSPubKey
+PSSigner::generate_key(PSThreadPool& pool, std::ostream* pk_stream)
+{
+  // tables of the previous key are no longer valid
+  m_tables = PSSignerTables();
+
   // generate private key
   // m_x
   Fr _sk_x;
-  _sk_x.setByCSPRNG();
+  PSRandom::generateFr(_sk_x);
   // m_X
   G1::mul(m_sk_X, m_pk.g, _sk_x);
 
@@ -41,22 +282,67 @@ PSSigner::key_gen()
   G2::mul(m_pk.XX, m_pk.gg, _sk_x);
 
   // public key: Y and YY for each attribute
-  Fr y_item;
-  G1 Y_item;
-  G2 YY_item;
-  for (size_t i = 0; i < m_attribute_num; i++) {
-    y_item.setByCSPRNG();
-    G1::mul(Y_item, m_pk.g, y_item);
-    m_pk.Yi.push_back(Y_item);
-    G2::mul(YY_item, m_pk.gg, y_item);
-    m_pk.YYi.push_back(YY_item);
-  }
-  return m_pk;
-}
+  // randomness is drawn on this thread, only the scalar multiplications are split across the pool
+  std::vector<Fr> _ys(m_attribute_num);
+  PSRandom::generateFrs(_ys.data(), _ys.size());
+  m_pk.Yi.resize(m_attribute_num);
+  m_pk.YYi.resize(m_attribute_num);
 
-PSPubKey
-PSSigner::get_pub_key() const
-{
+  // the encoding lists all Yi before all YYi, so Yi are generated first
+  PSBuffer _chunk;
+  auto flush = [&] {
+    pk_stream->write(reinterpret_cast<const char*>(_chunk.data()), _chunk.size());
+    _chunk.clear();
+  };
+  size_t block_size = m_attribute_num;
+  if (pk_stream != nullptr) {
+    if (m_attribute_num > 0xFFFF) {
+      throw std::runtime_error("attribute size too large to encode");
+    }
+    block_size = KEY_GEN_STREAM_BLOCK_SIZE;
+    _chunk.appendG1Element(m_pk.g);
+    _chunk.appendG2Element(m_pk.gg);
+    _chunk.appendG2Element(m_pk.XX);
+    _chunk.appendType(PSEncodingType::G1List);
+    _chunk.appendVar(m_attribute_num);
+    flush();
+  }
+  for (size_t block = 0; block < m_attribute_num; block += block_size) {
+    size_t block_end = std::min(m_attribute_num, block + block_size);
+    pool.parallelFor(block_end - block, [&](size_t begin, size_t end) {
+      for (size_t i = block + begin; i < block + end; i++) {
+        G1::mul(m_pk.Yi[i], m_pk.g, _ys[i]);
+      }
+    });
+    if (pk_stream != nullptr) {
+      for (size_t i = block; i < block_end; i++) {
+        _chunk.appendG1Element(m_pk.Yi[i], false);
+      }
+      flush();
+    }
+  }
+  if (pk_stream != nullptr) {
+    _chunk.appendType(PSEncodingType::G2List);
+    _chunk.appendVar(m_attribute_num);
+    flush();
+  }
+  for (size_t block = 0; block < m_attribute_num; block += block_size) {
+    size_t block_end = std::min(m_attribute_num, block + block_size);
+    pool.parallelFor(block_end - block, [&](size_t begin, size_t end) {
+      for (size_t i = block + begin; i < block + end; i++) {
+        G2::mul(m_pk.YYi[i], m_pk.gg, _ys[i]);
+      }
+    });
+    if (pk_stream != nullptr) {
+      for (size_t i = block; i < block_end; i++) {
+        _chunk.appendG2Element(m_pk.YYi[i], false);
+      }
+      flush();
+    }
+  }
+  if (pk_stream != nullptr && !*pk_stream) {
+    throw std::runtime_error("cannot write public key");
+  }
   return m_pk;
 }
 
@@ -64,48 +350,112 @@ bool
 PSSigner::el_passo_provide_id(const PSCredRequest& request,
                               const std::string& associated_data, PSCredential& sig) const
 {
-  if (!el_passo_nizk_verify_request(request, associated_data)) {
+  PS_SPAN("el_passo_provide_id");
+  G1 _commitment;
+  if (!el_passo_verify_request(request, associated_data, _commitment)) {
     return false;
   }
-  sig = sign_hybrid(request.A, request.attributes);
+  sig = sign_commitment(_commitment);
   return true;
 }
 
 bool
-PSSigner::el_passo_nizk_verify_request(const PSCredRequest& request,
-                                       const std::string& associated_data) const
+PSSigner::el_passo_verify_request(const PSCredRequest& request,
+                                  const std::string& associated_data, G1& commitment) const
 {
   // NIZK proof
   // V: A^c * g^r0 * Yi^ri
   // true if hash( A || V || associated_data ) = c
+  // commitment: A * PI{ Yi^hash(attribute_i) } over plaintext attributes
+  // a single pass over the attributes splits them into the terms of V and the terms of the commitment
+  if (request.attributes.size() > m_attribute_num) {
+    return false;
+  }
+  std::vector<size_t> _hidden, _plain;
+  std::vector<Fr> _plain_hashes;
+  _hidden.reserve(request.attributes.size());
+  _plain.reserve(request.attributes.size());
+  _plain_hashes.reserve(request.attributes.size());
+  {
+    PS_PHASE(SIGNER, HASH);
+    for (size_t i = 0; i < request.attributes.size(); i++) {
+      if (request.attributes[i] == "") {
+        _hidden.push_back(i);
+      }
+      else {
+        _plain.push_back(i);
+        _plain_hashes.emplace_back();
+        _plain_hashes.back().setHashOf(request.attributes[i]);
+      }
+    }
+  }
+  if (request.rs.size() != _hidden.size() + 1) {
+    return false;
+  }
+
   // prepare V
   G1 _V;
-  G1::mul(_V, request.A, request.c);
-  G1 _temp;
-  G1::mul(_temp, m_pk.g, request.rs[0]);
-  G1::add(_V, _V, _temp);
-  int j = 1;
-  for (size_t i = 0; i < request.attributes.size(); i++) {
-    if (request.attributes[i] == "") {
-      G1::mul(_temp, m_pk.Yi[i], request.rs[j]);
-      j++;
-      G1::add(_V, _V, _temp);
+  if (m_tables.empty()) {
+    PS_PHASE(SIGNER, G1_MUL);
+    // one multi-scalar multiplication over A, g, and the Yi of hidden attributes
+    std::vector<G1> _bases;
+    std::vector<Fr> _scalars;
+    _bases.reserve(_hidden.size() + 2);
+    _scalars.reserve(_hidden.size() + 2);
+    _bases.push_back(request.A);
+    _scalars.push_back(request.c);
+    _bases.push_back(m_pk.g);
+    _scalars.push_back(request.rs[0]);
+    for (size_t j = 0; j < _hidden.size(); j++) {
+      _bases.push_back(m_pk.Yi[_hidden[j]]);
+      _scalars.push_back(request.rs[j + 1]);
+    }
+    G1::mulVec(_V, _bases.data(), _scalars.data(), _bases.size());
+  }
+  else {
+    PS_PHASE(SIGNER, G1_MUL);
+    G1::mul(_V, request.A, request.c);
+    m_tables.g.mulAdd(_V, request.rs[0]);
+    for (size_t j = 0; j < _hidden.size(); j++) {
+      m_tables.Yi[_hidden[j]].mulAdd(_V, request.rs[j + 1]);
     }
   }
   // prepare c
   Fr _m_c;
-  cybozu::Sha256 digest_engine;
-  digest_engine.update(request.A.serializeToHexStr());
-  digest_engine.update(_V.serializeToHexStr());
-  auto _c_str = digest_engine.digest(associated_data);
-  _m_c.setHashOf(_c_str);
-  // std::cout << "sign: A: " << request.A.serializeToHexStr() << std::endl;
-  // std::cout << "sign: V: " << _V.serializeToHexStr() << std::endl;
-  // std::cout << "sign: c: " << _m_c.serializeToHexStr() << std::endl;
+  {
+    PS_PHASE(SIGNER, TRANSCRIPT);
+    PSTranscript transcript;
+    transcript.append(request.A);
+    transcript.append(_V);
+    transcript.challenge(_m_c, associated_data);
+  }
   // check if NIZK verification is successful
   if (_m_c != request.c) {
     return false;
   }
+
+  // prepare the commitment to all attributes
+  commitment = request.A;
+  if (_plain.empty()) {
+    return true;
+  }
+  PS_PHASE(SIGNER, G1_MUL);
+  G1 _plain_sum;
+  if (m_tables.empty()) {
+    std::vector<G1> _bases;
+    _bases.reserve(_plain.size());
+    for (size_t i : _plain) {
+      _bases.push_back(m_pk.Yi[i]);
+    }
+    G1::mulVec(_plain_sum, _bases.data(), _plain_hashes.data(), _bases.size());
+  }
+  else {
+    _plain_sum.clear();
+    for (size_t j = 0; j < _plain.size(); j++) {
+      m_tables.Yi[_plain[j]].mulAdd(_plain_sum, _plain_hashes[j]);
+    }
+  }
+  G1::add(commitment, commitment, _plain_sum);
   return true;
 }
 
@@ -116,15 +466,17 @@ PSSigner::sign_hybrid(const G1& commitment, const std::vector<std::string>& attr
     return this->sign_commitment(commitment);
   }
   G1 _final_A = commitment;
-  G1 _temp_yi_hash;
   Fr _temp_hash;
   for (size_t i = 0; i < attributes.size(); i++) {
     if (attributes[i] == "") {
       continue;
     }
-    _temp_hash.setHashOf(attributes[i]);
-    G1::mul(_temp_yi_hash, m_pk.Yi[i], _temp_hash);
-    G1::add(_final_A, _final_A, _temp_yi_hash);
+    {
+      PS_PHASE(SIGNER, HASH);
+      _temp_hash.setHashOf(attributes[i]);
+    }
+    PS_PHASE(SIGNER, G1_MUL);
+    mul_add_Yi(_final_A, i, _temp_hash);
   }
   return this->sign_commitment(_final_A);
 }
@@ -133,14 +485,39 @@ PSCredential
 PSSigner::sign_commitment(const G1& commitment) const
 {
   Fr u;
-  u.setByCSPRNG();
+  PSRandom::generateFr(u);
 
+  PS_PHASE(SIGNER, G1_MUL);
   PSCredential sig;
   // sig 1
-  G1::mul(sig.sig1, m_pk.g, u);
+  mul_g(sig.sig1, u);
   // sig 2
   G1::add(sig.sig2, m_sk_X, commitment);
   G1::mul(sig.sig2, sig.sig2, u);
 
   return sig;
+}
+
+void
+PSSigner::mul_g(G1& z, const Fr& s) const
+{
+  if (m_tables.empty()) {
+    G1::mul(z, m_pk.g, s);
+  }
+  else {
+    m_tables.g.mul(z, s);
+  }
+}
+
+void
+PSSigner::mul_add_Yi(G1& z, size_t i, const Fr& s) const
+{
+  if (m_tables.empty()) {
+    G1 _temp;
+    G1::mul(_temp, m_pk.Yi[i], s);
+    G1::add(z, z, _temp);
+  }
+  else {
+    m_tables.Yi[i].mulAdd(z, s);
+  }
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define PS_SRC_PS_SIGNER_H_
 
 #include "ps-encoding.h"
+#include "ps-precompute.h"
+#include "ps-thread-pool.h"
 
 using namespace mcl::bls12;
 
@@ -28,6 +30,17 @@ public:
    */
   PSSigner(size_t attribute_num, const G1& g, const G2& gg);
 
+  /**
+   * @brief Construct a new PSSigner object from a key file written by PSSigner::save_key().
+   *
+   * The file is mapped read-only. If it carries precomputed tables, they are used in place
+   * without being rebuilt.
+   *
+   * @param key_file_path input The path of the key file.
+   * @throw std::runtime_error if the file cannot be read or was written by an incompatible build.
+   */
+  explicit PSSigner(const std::string& key_file_path);
+
   /**
    * @brief Generate PS private key and public key.
    *
@@ -38,12 +51,77 @@ public:
   PSPubKey
   key_gen();
 
+  /**
+   * @brief Generate PS private key and public key, splitting the per-attribute work across @p pool.
+   *
+   * Caution: This function will overwrite the existing private key!
+   *
+   * @param pool input The thread pool doing the scalar multiplications.
+   * @return the public key.
+   */
+  PSPubKey
+  key_gen(PSThreadPool& pool);
+
+  /**
+   * @brief Generate PS private key and public key, and write the encoded public key to @p pk_stream
+   *        while it is being generated.
+   *
+   * The bytes written are the same as PSPubKey::toBufferString(). Yi and YYi are generated and written
+   * in blocks, so the encoding is never held in memory as a whole.
+   *
+   * Caution: This function will overwrite the existing private key!
+   *
+   * @param pool input The thread pool doing the scalar multiplications.
+   * @param pk_stream output The stream receiving the encoded public key.
+   * @return the public key.
+   * @throw std::runtime_error if writing to @p pk_stream fails.
+   */
+  PSPubKey
+  key_gen(PSThreadPool& pool, std::ostream& pk_stream);
+
   /**
    * @brief Get the public key.
    */
   PSPubKey
   get_pub_key() const;
 
+  /**
+   * @brief Build fixed-base tables for g and every Yi, used by all later signing operations.
+   *
+   * Must be called after PSSigner::key_gen(). Each table takes PSFixedBaseTable<G1>::BYTE_SIZE bytes.
+   * Worker processes sharing a key should attach to a PSSharedTables segment instead.
+   */
+  void
+  precompute();
+
+  /**
+   * @brief Use tables built elsewhere, e.g., attached from a PSSharedTables segment.
+   *
+   * @param tables input Tables built from this signer's public key.
+   * @throw std::runtime_error if the tables do not match the attribute number.
+   */
+  void
+  use_tables(const PSSignerTables& tables);
+
+  /**
+   * @brief Write the private key, the public key, and the precomputed tables (if any) to a key file.
+   *
+   * Version 1 layout, every section aligned to 64 bytes so the file can be mapped and used in place:
+   *  - PSKeyFileHeader
+   *  - raw points: X, g, gg, XX, Yi..., YYi...
+   *  - raw tables: g, Y1, ..., Yn (only if PSSigner::precompute() was called)
+   *
+   * Points are stored in the in-memory representation of this build, so a key file can only be
+   * loaded by a build using the same curve and the same MCL configuration.
+   * The file is written to key_file_path + ".tmp" with mode 0600, synced, and renamed over
+   * @p key_file_path, so an existing key file is replaced atomically.
+   *
+   * @param key_file_path input The path of the key file.
+   * @throw std::runtime_error if the file cannot be written.
+   */
+  void
+  save_key(const std::string& key_file_path) const;
+
   /**
    * @brief EL PASSO ProvideID.
    *
@@ -57,6 +135,25 @@ public:
   el_passo_provide_id(const PSCredRequest& request,
                       const std::string& associated_data, PSCredential& sig) const;
 
+  /**
+   * @brief The first half of EL PASSO ProvideID: verify the NIZK proof of @p request and compute
+   *        the commitment to all of its attributes.
+   *
+   * Hidden and plaintext attribute slots are told apart in a single pass. V is computed with one
+   * multi-scalar multiplication over A, g and the Yi of hidden slots, and the plaintext terms with
+   * another one over the Yi of plaintext slots (fixed-base tables replace both when precomputed).
+   * The plaintext terms are only added when the proof is valid.
+   *
+   * @param request input The ID request generated by the PSRequester.
+   * @param associated_data input Associated data used for NIZK Schnorr verification.
+   * @param commitment output The commitment to pass to PSSigner::sign_commitment().
+   * @return true If the NIZK verification succeeds.
+   * @return false Otherwise, including malformed requests. @p commitment will not be generated.
+   */
+  bool
+  el_passo_verify_request(const PSCredRequest& request,
+                          const std::string& associated_data, G1& commitment) const;
+
   /**
    * @brief Use PS key to sign over a committed message.
    *
@@ -85,14 +182,23 @@ public:
   sign_hybrid(const G1& commitment, const std::vector<std::string>& attributes) const;
 
 private:
-  bool
-  el_passo_nizk_verify_request(const PSCredRequest& request,
-                               const std::string& associated_data) const;
+  template<size_t N>
+  friend class PSSignerN;
+
+  PSPubKey
+  generate_key(PSThreadPool& pool, std::ostream* pk_stream);
+
+  void
+  mul_g(G1& z, const Fr& s) const;
+
+  void
+  mul_add_Yi(G1& z, size_t i, const Fr& s) const;
 
 private:
   size_t m_attribute_num;  // maximum supported number of attributes
   G1 m_sk_X;               // private key, X
   PSPubKey m_pk;           // public key
+  PSSignerTables m_tables;  // empty if not precomputed
 };
 
 #endif  // PS_SRC_PS_SIGNER_H_
\ No newline at end of file
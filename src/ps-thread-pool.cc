@@ -0,0 +1,108 @@
+#include "ps-thread-pool.h"
+
+#include <algorithm>
+#include <exception>
+
+PSThreadPool::PSThreadPool(size_t thread_num)
+{
+  if (thread_num == 0) {
+    thread_num = std::max(1u, std::thread::hardware_concurrency());
+  }
+  m_workers.reserve(thread_num - 1);
+  for (size_t i = 1; i < thread_num; i++) {
+    m_workers.emplace_back(&PSThreadPool::run, this);
+  }
+}
+
+PSThreadPool::~PSThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+  m_cv.notify_all();
+  for (auto& worker : m_workers) {
+    worker.join();
+  }
+}
+
+size_t
+PSThreadPool::size() const
+{
+  return m_workers.size() + 1;
+}
+
+void
+PSThreadPool::parallelFor(size_t n, const std::function<void(size_t begin, size_t end)>& fn)
+{
+  size_t range_num = std::min(n, size());
+  if (range_num <= 1) {
+    if (n > 0) {
+      fn(0, n);
+    }
+    return;
+  }
+
+  std::mutex done_mutex;
+  std::condition_variable done_cv;
+  size_t pending = range_num - 1;
+  std::exception_ptr error;
+  auto run_range = [&](size_t r) {
+    try {
+      fn(n * r / range_num, n * (r + 1) / range_num);
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  };
+  for (size_t r = 1; r < range_num; r++) {
+    post([&, r] {
+      run_range(r);
+      std::lock_guard<std::mutex> lock(done_mutex);
+      if (--pending == 0) {
+        done_cv.notify_one();
+      }
+    });
+  }
+  run_range(0);
+  std::unique_lock<std::mutex> lock(done_mutex);
+  done_cv.wait(lock, [&] { return pending == 0; });
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void
+PSThreadPool::post(std::function<void()> task)
+{
+  if (m_workers.empty()) {
+    task();
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(task));
+  }
+  m_cv.notify_one();
+}
+
+void
+PSThreadPool::run()
+{
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cv.wait(lock, [this] { return m_stopped || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return;
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
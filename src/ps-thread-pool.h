@@ -0,0 +1,68 @@
+#ifndef PS_SRC_PS_THREAD_POOL_H_
+#define PS_SRC_PS_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed-size pool of worker threads.
+ *
+ * A pool of size 1 has no worker thread and runs everything on the calling thread, which keeps
+ * builds without thread support (e.g., WebAssembly) working with the same code paths.
+ */
+class PSThreadPool {
+public:
+  /**
+   * @brief Construct a new PSThreadPool object
+   *
+   * @param thread_num input The number of threads doing work, including the calling thread of
+   *        PSThreadPool::parallelFor(). 0 means one per hardware thread.
+   */
+  explicit PSThreadPool(size_t thread_num = 0);
+
+  ~PSThreadPool();
+
+  PSThreadPool(const PSThreadPool&) = delete;
+
+  PSThreadPool&
+  operator=(const PSThreadPool&) = delete;
+
+  /**
+   * @brief The number of threads doing work, including the calling thread.
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief Split [0, @p n) into at most size() contiguous ranges and run @p fn on each of them,
+   *        one range on the calling thread. Returns after all ranges are done.
+   *
+   * If @p fn throws, the first exception is rethrown on the calling thread after all ranges are done.
+   * Must not be called from a task running on the same pool.
+   */
+  void
+  parallelFor(size_t n, const std::function<void(size_t begin, size_t end)>& fn);
+
+  /**
+   * @brief Run @p task on a worker thread, or on the calling thread if the pool has no worker.
+   */
+  void
+  post(std::function<void()> task);
+
+private:
+  void
+  run();
+
+private:
+  std::vector<std::thread> m_workers;
+  std::deque<std::function<void()>> m_tasks;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stopped = false;
+};
+
+#endif  // PS_SRC_PS_THREAD_POOL_H_
@@ -0,0 +1,182 @@
+#include "ps-trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct PSTraceEvent {
+  const char* category;
+  const char* name;
+  std::chrono::steady_clock::time_point begin;
+  std::chrono::steady_clock::time_point end;
+  uint32_t tid;
+};
+
+// the state of the run the calling thread is in
+struct PSThreadTrace {
+  size_t depth = 0;      // number of open PS_SPANs
+  bool sampled = false;  // whether the current run is recorded
+  uint32_t tid = 0;      // 0 until the first sampled run
+  uint64_t rng = 0;      // 0 until the first run
+  std::vector<PSTraceEvent> events;
+};
+
+// the events of finished runs
+struct PSTraceStore {
+  std::mutex mutex;
+  std::vector<PSTraceEvent> events;
+};
+
+static std::atomic<uint64_t> s_threshold(0);  // a run is sampled if a uniform 64-bit number is below it
+static std::atomic<double> s_rate(0);
+static std::atomic<uint32_t> s_next_tid(1);
+static thread_local PSThreadTrace t_trace;
+
+static PSTraceStore&
+getStore()
+{
+  // never destroyed, so runs finishing on threads that outlive main() can still be stored
+  static PSTraceStore* store = new PSTraceStore();
+  return *store;
+}
+
+// splitmix64, seeded per thread; sampling needs no cryptographic randomness
+static uint64_t
+nextRandom(PSThreadTrace& trace)
+{
+  if (trace.rng == 0) {
+    trace.rng = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                std::chrono::steady_clock::now().time_since_epoch().count();
+  }
+  uint64_t z = (trace.rng += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+// microseconds since the steady clock epoch, with nanosecond digits
+static void
+writeMicroseconds(std::ostream& os, std::chrono::steady_clock::duration duration)
+{
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  os << ns / 1000 << "." << std::setw(3) << std::setfill('0') << ns % 1000;
+}
+
+void
+PSTracer::setSampleRate(double rate)
+{
+  rate = std::min(1.0, std::max(0.0, rate));
+  s_rate.store(rate, std::memory_order_relaxed);
+  s_threshold.store(rate >= 1 ? UINT64_MAX : static_cast<uint64_t>(rate * 18446744073709551616.0),
+                    std::memory_order_relaxed);
+}
+
+double
+PSTracer::getSampleRate()
+{
+  return s_rate.load(std::memory_order_relaxed);
+}
+
+size_t
+PSTracer::eventNum()
+{
+  auto& store = getStore();
+  std::lock_guard<std::mutex> lock(store.mutex);
+  return store.events.size();
+}
+
+std::string
+PSTracer::toChromeJson()
+{
+  auto& store = getStore();
+  std::lock_guard<std::mutex> lock(store.mutex);
+  std::ostringstream os;
+  int pid = getpid();
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (size_t i = 0; i < store.events.size(); i++) {
+    const auto& event = store.events[i];
+    os << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+       << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << event.tid << ",\"ts\":";
+    writeMicroseconds(os, event.begin.time_since_epoch());
+    os << ",\"dur\":";
+    writeMicroseconds(os, event.end - event.begin);
+    os << "}";
+  }
+  os << "\n]}\n";
+  return os.str();
+}
+
+void
+PSTracer::writeChromeJson(const std::string& path)
+{
+  std::ofstream file(path);
+  file << toChromeJson();
+  if (!file) {
+    throw std::runtime_error("cannot write " + path);
+  }
+  clear();
+}
+
+void
+PSTracer::clear()
+{
+  auto& store = getStore();
+  std::lock_guard<std::mutex> lock(store.mutex);
+  store.events.clear();
+}
+
+void
+PSTracer::addSpan(const char* category, const char* name, std::chrono::steady_clock::time_point begin,
+                  std::chrono::steady_clock::time_point end)
+{
+  auto& trace = t_trace;
+  if (trace.sampled && trace.events.size() < PSTracer::MAX_EVENT_NUM) {
+    trace.events.push_back({category, name, begin, end, trace.tid});
+  }
+}
+
+PSTraceSpan::PSTraceSpan(const char* name)
+    : m_name(name)
+{
+  auto& trace = t_trace;
+  if (trace.depth++ == 0) {
+    uint64_t threshold = s_threshold.load(std::memory_order_relaxed);
+    trace.sampled = threshold != 0 && nextRandom(trace) < threshold;
+    if (trace.sampled && trace.tid == 0) {
+      trace.tid = s_next_tid.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  m_sampled = trace.sampled;
+  if (m_sampled) {
+    m_begin = std::chrono::steady_clock::now();
+  }
+}
+
+PSTraceSpan::~PSTraceSpan()
+{
+  auto& trace = t_trace;
+  if (m_sampled) {
+    trace.events.push_back({"el_passo", m_name, m_begin, std::chrono::steady_clock::now(), trace.tid});
+  }
+  if (--trace.depth != 0 || !trace.sampled) {
+    return;
+  }
+  // the run is over, a run that does not fit anymore is dropped as a whole
+  trace.sampled = false;
+  auto& store = getStore();
+  {
+    std::lock_guard<std::mutex> lock(store.mutex);
+    if (store.events.size() + trace.events.size() <= PSTracer::MAX_EVENT_NUM) {
+      store.events.insert(store.events.end(), trace.events.begin(), trace.events.end());
+    }
+  }
+  trace.events.clear();
+}
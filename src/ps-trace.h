@@ -0,0 +1,99 @@
+#ifndef PS_SRC_PS_TRACE_H_
+#define PS_SRC_PS_TRACE_H_
+
+#include "ps-instrumentation.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Samples protocol runs and records their nested phases as Chrome trace events.
+ *
+ * A run is the outermost PS_SPAN on a thread, e.g., one el_passo_verify_id call. A sampled run records
+ * itself and every PS_SPAN and PS_PHASE nested in it on the same thread; phases that a PSThreadPool runs
+ * on its workers are not part of the run. An unsampled run costs one thread-local random number.
+ * Like PS_PHASE, PS_SPAN only does anything in builds with PS_ENABLE_INSTRUMENTATION.
+ *
+ * The events of finished runs are kept in memory, up to MAX_EVENT_NUM, until they are written out with
+ * writeChromeJson() and loaded in chrome://tracing or https://ui.perfetto.dev.
+ */
+class PSTracer {
+public:
+  static constexpr size_t MAX_EVENT_NUM = 1 << 20;
+
+public:
+  /**
+   * @brief Sample @p rate (0 to 1) of the runs that start from now on, e.g., 0.01. 0, the default, traces
+   *        nothing.
+   */
+  static void
+  setSampleRate(double rate);
+
+  static double
+  getSampleRate();
+
+  /**
+   * @brief The number of events of finished runs kept in memory.
+   */
+  static size_t
+  eventNum();
+
+  /**
+   * @brief The kept events as a trace-event JSON object.
+   */
+  static std::string
+  toChromeJson();
+
+  /**
+   * @brief Write the kept events to @p path as trace-event JSON and drop them.
+   * @throw std::runtime_error if the file cannot be written.
+   */
+  static void
+  writeChromeJson(const std::string& path);
+
+  /**
+   * @brief Drop the kept events.
+   */
+  static void
+  clear();
+
+  /**
+   * @brief Add a span to the run the calling thread is in, if it is sampled.
+   */
+  static void
+  addSpan(const char* category, const char* name, std::chrono::steady_clock::time_point begin,
+          std::chrono::steady_clock::time_point end);
+};
+
+/**
+ * @brief Traces its own lifetime as a span named @p name, starting a run if it is the outermost one.
+ */
+class PSTraceSpan {
+public:
+  explicit PSTraceSpan(const char* name);
+
+  ~PSTraceSpan();
+
+  PSTraceSpan(const PSTraceSpan&) = delete;
+
+  PSTraceSpan&
+  operator=(const PSTraceSpan&) = delete;
+
+private:
+  const char* m_name;
+  bool m_sampled;
+  std::chrono::steady_clock::time_point m_begin;
+};
+
+/**
+ * @brief Trace the rest of the enclosing scope as a span named @p name, e.g., PS_SPAN("el_passo_verify_id").
+ *        Nothing at all without PS_ENABLE_INSTRUMENTATION.
+ */
+#ifdef PS_ENABLE_INSTRUMENTATION
+#define PS_SPAN(name) PSTraceSpan PS_PHASE_CONCAT(_ps_trace_span_, __LINE__)(name)
+#else
+#define PS_SPAN(name)
+#endif
+
+#endif  // PS_SRC_PS_TRACE_H_
@@ -0,0 +1,61 @@
+#include "ps-transcript.h"
+
+#include <stdexcept>
+
+using namespace mcl::bls12;
+
+// large enough for the hex serialization of a G2 point
+static const size_t PS_HEX_BUFFER_SIZE = 512;
+
+template<class T>
+static size_t
+serializeHex(char* buf, const T& point)
+{
+  size_t size = point.serialize(buf, PS_HEX_BUFFER_SIZE, mcl::IoSerializeHexStr);
+  if (size == 0) {
+    throw std::runtime_error("cannot serialize point");
+  }
+  return size;
+}
+
+void
+PSTranscript::append(const G1& point)
+{
+  char buf[PS_HEX_BUFFER_SIZE];
+  m_digest_engine.update(buf, serializeHex(buf, point));
+}
+
+void
+PSTranscript::append(const G2& point)
+{
+  char buf[PS_HEX_BUFFER_SIZE];
+  m_digest_engine.update(buf, serializeHex(buf, point));
+}
+
+void
+PSTranscript::append(std::string_view hex)
+{
+  m_digest_engine.update(hex.data(), hex.size());
+}
+
+void
+PSTranscript::challenge(Fr& c, std::string_view associated_data)
+{
+  uint8_t md[32];
+  m_digest_engine.digest(md, sizeof(md), associated_data.data(), associated_data.size());
+  c.setHashOf(md, sizeof(md));
+}
+
+template<class T>
+void
+PSTranscript::toHex(std::string& out, const T& point)
+{
+  char buf[PS_HEX_BUFFER_SIZE];
+  out.assign(buf, serializeHex(buf, point));
+}
+
+template void
+PSTranscript::toHex<G1>(std::string& out, const G1& point);
+
+template void
+PSTranscript::toHex<G2>(std::string& out, const G2& point);
@@ -0,0 +1,51 @@
+#ifndef PS_SRC_PS_TRANSCRIPT_H_
+#define PS_SRC_PS_TRANSCRIPT_H_
+
+#include "ps-curve.h"
+
+#include <cybozu/sha2.hpp>
+#include <string_view>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief The Fiat-Shamir transcript of the EL PASSO NIZK proofs.
+ *
+ * c = hash( hex(P_1) || ... || hex(P_n) || associated_data ), the same as hashing the
+ * serializeToHexStr() strings, but points are serialized into a stack buffer so nothing is allocated.
+ */
+class PSTranscript {
+public:
+  void
+  append(const G1& point);
+
+  void
+  append(const G2& point);
+
+  /**
+   * @brief Append an already serialized point, e.g., one cached by PSPresentationContext.
+   */
+  void
+  append(std::string_view hex);
+
+  /**
+   * @brief Finish the transcript with @p associated_data and derive the challenge.
+   *
+   * @param c output The challenge.
+   * @param associated_data input The associated data bound with the proof.
+   */
+  void
+  challenge(Fr& c, std::string_view associated_data);
+
+  /**
+   * @brief Write the hex serialization of @p point to @p out, reusing its capacity.
+   */
+  template<class T>
+  static void
+  toHex(std::string& out, const T& point);
+
+private:
+  cybozu::Sha256 m_digest_engine;
+};
+
+#endif  // PS_SRC_PS_TRANSCRIPT_H_
@@ -1,18 +1,60 @@
 #include "ps-verifier.h"
+#include "ps-instrumentation.h"
+#include "ps-random.h"
+#include "ps-trace.h"
+#include "ps-transcript.h"
 
+#include <algorithm>
 #include <chrono>
-#include <cybozu/sha2.hpp>
 
 using namespace mcl::bls12;
 
+// below this many G2 terms per task, splitting a verification costs more than it saves
+static const size_t PS_MIN_TERMS_PER_TASK = 8;
+
+// the number of committed attribute slots
+static size_t
+getHiddenNum(const IdProof& proof)
+{
+  size_t hidden_num = 0;
+  for (const auto& attribute : proof.attributes) {
+    if (attribute == "") {
+      hidden_num++;
+    }
+  }
+  return hidden_num;
+}
+
 PSVerifier::PSVerifier(const PSPubKey& pk)
     : m_pk(pk)
 {
 }
 
+void
+PSVerifier::precompute()
+{
+  m_tables = PSVerifierTables::build(m_pk);
+}
+
+void
+PSVerifier::use_thread_pool(PSThreadPool* thread_pool)
+{
+  m_thread_pool = thread_pool;
+}
+
+void
+PSVerifier::use_tables(const PSVerifierTables& tables)
+{
+  if (tables.YYi.size() != m_pk.YYi.size()) {
+    throw std::runtime_error("table size does not match");
+  }
+  m_tables = tables;
+}
+
 bool
 PSVerifier::verify(const PSCredential& sig, const std::vector<std::string>& all_attributes) const
 {
+  PS_SPAN("verify");
   if (sig.sig1.isZero()) {
     return false;
   }
@@ -20,18 +62,15 @@ PSVerifier::verify(const PSCredential& sig, const std::vector<std::string>& all_
   Fr _attribute_hash;
   G2 _yy_hash_sum = m_pk.XX;
   int counter = 0;
-  G2 _yyi_hash_product;
   for (const auto& attribute : all_attributes) {
-    _attribute_hash.setHashOf(attribute);
-    G2::mul(_yyi_hash_product, m_pk.YYi[counter], _attribute_hash);
-    G2::add(_yy_hash_sum, _yy_hash_sum, _yyi_hash_product);
+    {
+      PS_PHASE(VERIFIER, HASH);
+      _attribute_hash.setHashOf(attribute);
+    }
+    mul_add_YYi(_yy_hash_sum, counter, _attribute_hash);
     counter++;
   }
-
-  GT _lhs, _rhs;
-  pairing(_lhs, sig.sig1, _yy_hash_sum);
-  pairing(_rhs, sig.sig2, m_pk.gg);
-  return _lhs == _rhs;
+  return check_pairing(sig.sig1, _yy_hash_sum, sig.sig2);
 }
 
 bool
@@ -39,6 +78,90 @@ PSVerifier::el_passo_verify_id(const IdProof& proof,
                                const std::string& associated_data,
                                const std::string& service_name,
                                const G1& authority_pk, const G1& g, const G1& h) const
+{
+  return el_passo_verify_id(proof, associated_data, service_name, PSAuthorityContext(authority_pk, g, h));
+}
+
+bool
+PSVerifier::el_passo_verify_id(const IdProof& proof,
+                               const std::string& associated_data,
+                               const std::string& service_name,
+                               const PSAuthorityContext& authority) const
+{
+  PS_SPAN("el_passo_verify_id");
+  if (!check_id_nizk(proof, associated_data, service_name, authority)) {
+    return false;
+  }
+  // signature verification, e(sigma’_1, k) ?= e(sigma’_2, gg)
+  G2 _final_k = prepare_hybrid_verification(proof.k, proof.attributes);
+  return check_pairing(proof.sig1, _final_k, proof.sig2);
+}
+
+bool
+PSVerifier::el_passo_verify_id_without_id_retrieval(const IdProof& proof,
+                                                    const std::string& associated_data,
+                                                    const std::string& service_name) const
+{
+  PS_SPAN("el_passo_verify_id_without_id_retrieval");
+  if (!check_id_nizk_without_id_retrieval(proof, associated_data, service_name)) {
+    return false;
+  }
+  // signature verification, e(sigma’_1, k) ?= e(sigma’_2, gg)
+  G2 _final_k = prepare_hybrid_verification(proof.k, proof.attributes);
+  return check_pairing(proof.sig1, _final_k, proof.sig2);
+}
+
+bool
+PSVerifier::el_passo_verify_id_batch(const std::vector<IdProof>& proofs,
+                                     const std::vector<std::string>& associated_data,
+                                     const std::vector<std::string>& service_names,
+                                     const G1& authority_pk, const G1& g, const G1& h,
+                                     std::vector<bool>& verdicts) const
+{
+  return el_passo_verify_id_batch(proofs, associated_data, service_names, PSAuthorityContext(authority_pk, g, h),
+                                  verdicts);
+}
+
+bool
+PSVerifier::el_passo_verify_id_batch(const std::vector<IdProof>& proofs,
+                                     const std::vector<std::string>& associated_data,
+                                     const std::vector<std::string>& service_names,
+                                     const PSAuthorityContext& authority,
+                                     std::vector<bool>& verdicts) const
+{
+  PS_SPAN("el_passo_verify_id_batch");
+  if (associated_data.size() != proofs.size() || service_names.size() != proofs.size()) {
+    throw std::runtime_error("batch input sizes do not match");
+  }
+  verdicts.assign(proofs.size(), false);
+  for (size_t i = 0; i < proofs.size(); i++) {
+    verdicts[i] = check_id_nizk(proofs[i], associated_data[i], service_names[i], authority);
+  }
+  return check_id_signatures(proofs, verdicts);
+}
+
+bool
+PSVerifier::el_passo_verify_id_batch_without_id_retrieval(const std::vector<IdProof>& proofs,
+                                                          const std::vector<std::string>& associated_data,
+                                                          const std::vector<std::string>& service_names,
+                                                          std::vector<bool>& verdicts) const
+{
+  PS_SPAN("el_passo_verify_id_batch_without_id_retrieval");
+  if (associated_data.size() != proofs.size() || service_names.size() != proofs.size()) {
+    throw std::runtime_error("batch input sizes do not match");
+  }
+  verdicts.assign(proofs.size(), false);
+  for (size_t i = 0; i < proofs.size(); i++) {
+    verdicts[i] = check_id_nizk_without_id_retrieval(proofs[i], associated_data[i], service_names[i]);
+  }
+  return check_id_signatures(proofs, verdicts);
+}
+
+bool
+PSVerifier::check_id_nizk(const IdProof& proof,
+                          const std::string& associated_data,
+                          const std::string& service_name,
+                          const PSAuthorityContext& authority) const
 {
   /** NIZK Verify:
    * Public Value:
@@ -68,79 +191,81 @@ PSVerifier::el_passo_verify_id(const IdProof& proof,
   if (!proof.E1.has_value() || !proof.E2.has_value()) {
     return false;
   }
+  // rs holds one response per committed attribute (s and gamma first), then r2 and r3
+  size_t hidden_num = getHiddenNum(proof);
+  if (proof.attributes.size() > m_pk.YYi.size() || hidden_num < 2 || proof.rs.size() != hidden_num + 2) {
+    return false;
+  }
+  // V_phi, V_E1 and V_E2 may run next to the G2 terms of V_k
+  G1 _V_phi, _V_E1, _V_E2;
+  auto check_g1 = [&] {
+    G1 _temp;
+    {
+      PS_PHASE(VERIFIER, HASH);
+      hashAndMapToG1(_temp, service_name);
+    }
+    PS_PHASE(VERIFIER, G1_MUL);
+    // V_phi = phi^c * hash(domain)^r1_s
+    G1::mul(_V_phi, proof.phi, proof.c);
+    G1::mul(_temp, _temp, proof.rs[0]);
+    G1::add(_V_phi, _V_phi, _temp);
+
+    // V_E1 = E1^c * g^r3
+    G1::mul(_V_E1, proof.E1.value(), proof.c);
+    authority.mulAdd(PSAuthorityContext::G, _V_E1, proof.rs[proof.rs.size() - 1]);
+
+    // V_E2 = E2^c * y^r3 * h^r1_gamma
+    G1::mul(_V_E2, proof.E2.value(), proof.c);
+    authority.mulAdd(PSAuthorityContext::AUTHORITY_PK, _V_E2, proof.rs[proof.rs.size() - 1]);
+    authority.mulAdd(PSAuthorityContext::H, _V_E2, proof.rs[1]);
+  };
+
   // V_k = k^c * XX^(1-c) * PI{ YYj^r1_j } * gg^r2
   G2 _V_k;
-  G2::mul(_V_k, proof.k, proof.c);
-  int counter = 0;
-  G2 _base_r;
+  {
+    PS_PHASE(VERIFIER, G2_MUL);
+    G2::mul(_V_k, proof.k, proof.c);
+  }
+  std::vector<std::pair<size_t, Fr>> _terms;
+  _terms.reserve(hidden_num);
   for (size_t i = 0; i < proof.attributes.size(); i++) {
     if (proof.attributes[i] == "") {
-      G2::mul(_base_r, m_pk.YYi[i], proof.rs[counter]);
-      counter++;
-      G2::add(_V_k, _V_k, _base_r);
+      _terms.emplace_back(i, proof.rs[_terms.size()]);
     }
   }
-  G2::mul(_base_r, m_pk.gg, proof.rs[proof.rs.size() - 2]);
-  G2::add(_V_k, _V_k, _base_r);
+  mul_add_YYi_terms(_V_k, _terms, check_g1);
+  mul_add(_V_k, m_pk.gg, m_tables.gg, proof.rs[proof.rs.size() - 2]);
   Fr _1_c = Fr::one();
   Fr::sub(_1_c, _1_c, proof.c);
-  G2::mul(_base_r, m_pk.XX, _1_c);
-  G2::add(_V_k, _V_k, _base_r);
-
-  // V_phi = phi^c * hash(domain)^r1_s
-  G1 _V_phi, _V_E1, _V_E2;
-  G1::mul(_V_phi, proof.phi, proof.c);
-  G1 _temp;
-  hashAndMapToG1(_temp, service_name);
-  G1::mul(_temp, _temp, proof.rs[0]);
-  G1::add(_V_phi, _V_phi, _temp);
-
-  // V_E1 = E1^c * g^r3
-  G1::mul(_V_E1, proof.E1.value(), proof.c);
-  G1::mul(_temp, g, proof.rs[proof.rs.size() - 1]);
-  G1::add(_V_E1, _V_E1, _temp);
-
-  // V_E2 = E2^c * y^r3 * h^r1_gamma
-  G1::mul(_V_E2, proof.E2.value(), proof.c);
-  G1::mul(_temp, authority_pk, proof.rs[proof.rs.size() - 1]);
-  G1::add(_V_E2, _V_E2, _temp);
-  G1::mul(_temp, h, proof.rs[1]);
-  G1::add(_V_E2, _V_E2, _temp);
+  mul_add(_V_k, m_pk.XX, m_tables.XX, _1_c);
 
   // Calculate c = hash(k || phi || E1 || E2 || V_k || V_phi || V_E1 || V_E2 || associated_data )
   Fr _local_c;
-  cybozu::Sha256 digest_engine;
-  digest_engine.update(proof.k.serializeToHexStr());
-  digest_engine.update(proof.phi.serializeToHexStr());
-  digest_engine.update(proof.E1.value().serializeToHexStr());
-  digest_engine.update(proof.E2.value().serializeToHexStr());
-  digest_engine.update(_V_k.serializeToHexStr());
-  digest_engine.update(_V_phi.serializeToHexStr());
-  digest_engine.update(_V_E1.serializeToHexStr());
-  digest_engine.update(_V_E2.serializeToHexStr());
-  auto _c_str = digest_engine.digest(associated_data);
-  _local_c.setHashOf(_c_str);
+  {
+    PS_PHASE(VERIFIER, TRANSCRIPT);
+    PSTranscript transcript;
+    transcript.append(proof.k);
+    transcript.append(proof.phi);
+    transcript.append(proof.E1.value());
+    transcript.append(proof.E2.value());
+    transcript.append(_V_k);
+    transcript.append(_V_phi);
+    transcript.append(_V_E1);
+    transcript.append(_V_E2);
+    transcript.challenge(_local_c, associated_data);
+  }
   // std::cout << "parepare: V k: " << _V_k.serializeToHexStr() << std::endl;
   // std::cout << "parepare: V phi: " << _V_phi.serializeToHexStr() << std::endl;
   // std::cout << "parepare: V E1: " << _V_E1.serializeToHexStr() << std::endl;
   // std::cout << "parepare: V E2: " << _V_E2.serializeToHexStr() << std::endl;
 
-  if (proof.c != _local_c) {
-    return false;
-  }
-
-  // signature verification, e(sigma’_1, k) ?= e(sigma’_2, gg)
-  G2 _final_k = prepare_hybrid_verification(proof.k, proof.attributes);
-  GT lhs, rhs;
-  pairing(lhs, proof.sig1, _final_k);
-  pairing(rhs, proof.sig2, m_pk.gg);
-  return lhs == rhs;
+  return proof.c == _local_c;
 }
 
 bool
-PSVerifier::el_passo_verify_id_without_id_retrieval(const IdProof& proof,
-                                                    const std::string& associated_data,
-                                                    const std::string& service_name) const
+PSVerifier::check_id_nizk_without_id_retrieval(const IdProof& proof,
+                                               const std::string& associated_data,
+                                               const std::string& service_name) const
 {
   /** NIZK Verify:
    * Public Value:
@@ -160,76 +285,234 @@ PSVerifier::el_passo_verify_id_without_id_retrieval(const IdProof& proof,
    * * r1_j: random1_j - attribute_j * c
    * * r2: random2 - t * c
    */
+  // rs holds one response per committed attribute (s first), then r2
+  size_t hidden_num = getHiddenNum(proof);
+  if (proof.attributes.size() > m_pk.YYi.size() || hidden_num < 1 || proof.rs.size() != hidden_num + 1) {
+    return false;
+  }
+  // V_phi = phi^c * hash(domain)^r1_s, which may run next to the G2 terms of V_k
+  G1 _V_phi;
+  auto check_g1 = [&] {
+    G1 _temp;
+    {
+      PS_PHASE(VERIFIER, HASH);
+      hashAndMapToG1(_temp, service_name);
+    }
+    PS_PHASE(VERIFIER, G1_MUL);
+    G1::mul(_V_phi, proof.phi, proof.c);
+    G1::mul(_temp, _temp, proof.rs[0]);
+    G1::add(_V_phi, _V_phi, _temp);
+  };
+
   // V_k = k^c * XX^(1-c) * PI{ YYj^r1_j } * gg^r2
   G2 _V_k;
-  G2::mul(_V_k, proof.k, proof.c);
-  int counter = 0;
-  G2 _base_r;
+  {
+    PS_PHASE(VERIFIER, G2_MUL);
+    G2::mul(_V_k, proof.k, proof.c);
+  }
+  std::vector<std::pair<size_t, Fr>> _terms;
+  _terms.reserve(hidden_num);
   for (size_t i = 0; i < proof.attributes.size(); i++) {
     if (proof.attributes[i] == "") {
-      G2::mul(_base_r, m_pk.YYi[i], proof.rs[counter]);
-      counter++;
-      G2::add(_V_k, _V_k, _base_r);
+      _terms.emplace_back(i, proof.rs[_terms.size()]);
     }
   }
-  G2::mul(_base_r, m_pk.gg, proof.rs[proof.rs.size() - 1]);
-  G2::add(_V_k, _V_k, _base_r);
+  mul_add_YYi_terms(_V_k, _terms, check_g1);
+  mul_add(_V_k, m_pk.gg, m_tables.gg, proof.rs[proof.rs.size() - 1]);
   Fr _1_c = Fr::one();
   Fr::sub(_1_c, _1_c, proof.c);
-  G2::mul(_base_r, m_pk.XX, _1_c);
-  G2::add(_V_k, _V_k, _base_r);
-
-  // V_phi = phi^c * hash(domain)^r1_s
-  G1 _V_phi;
-  G1::mul(_V_phi, proof.phi, proof.c);
-  G1 _temp;
-  hashAndMapToG1(_temp, service_name);
-  G1::mul(_temp, _temp, proof.rs[0]);
-  G1::add(_V_phi, _V_phi, _temp);
+  mul_add(_V_k, m_pk.XX, m_tables.XX, _1_c);
 
   // Calculate c = hash(k || phi || V_k || V_phi || associated_data )
   Fr _local_c;
-  cybozu::Sha256 digest_engine;
-  digest_engine.update(proof.k.serializeToHexStr());
-  digest_engine.update(proof.phi.serializeToHexStr());
-  digest_engine.update(_V_k.serializeToHexStr());
-  digest_engine.update(_V_phi.serializeToHexStr());
-  auto _c_str = digest_engine.digest(associated_data);
-  _local_c.setHashOf(_c_str);
+  {
+    PS_PHASE(VERIFIER, TRANSCRIPT);
+    PSTranscript transcript;
+    transcript.append(proof.k);
+    transcript.append(proof.phi);
+    transcript.append(_V_k);
+    transcript.append(_V_phi);
+    transcript.challenge(_local_c, associated_data);
+  }
   // std::cout << "parepare: V k: " << _V_k.serializeToHexStr() << std::endl;
   // std::cout << "parepare: V phi: " << _V_phi.serializeToHexStr() << std::endl;
 
-  if (proof.c != _local_c) {
-    return false;
+  return proof.c == _local_c;
+}
+
+bool
+PSVerifier::check_id_signatures(const std::vector<IdProof>& proofs, std::vector<bool>& verdicts) const
+{
+  std::vector<size_t> _candidates;
+  for (size_t i = 0; i < proofs.size(); i++) {
+    if (verdicts[i]) {
+      _candidates.push_back(i);
+    }
+  }
+  if (_candidates.empty()) {
+    return proofs.empty();
+  }
+  std::vector<G2> _final_ks(_candidates.size());
+  for (size_t j = 0; j < _candidates.size(); j++) {
+    const auto& proof = proofs[_candidates[j]];
+    _final_ks[j] = prepare_hybrid_verification(proof.k, proof.attributes);
+  }
+  if (_candidates.size() == 1) {
+    const auto& proof = proofs[_candidates[0]];
+    verdicts[_candidates[0]] = check_pairing(proof.sig1, _final_ks[0], proof.sig2);
+    return verdicts[_candidates[0]] && proofs.size() == 1;
   }
 
-  // signature verification, e(sigma’_1, k) ?= e(sigma’_2, gg)
-  G2 _final_k = prepare_hybrid_verification(proof.k, proof.attributes);
-  GT lhs, rhs;
-  pairing(lhs, proof.sig1, _final_k);
-  pairing(rhs, proof.sig2, m_pk.gg);
-  return lhs == rhs;
+  // PI{ e(sig1_i^rho_i, k_i) } * e(-SUM{ sig2_i^rho_i }, gg) == 1
+  // the random rho_i keep one invalid signature from being cancelled out by another
+  size_t n = _candidates.size();
+  std::vector<Fr> _rhos(n);
+  PSRandom::generateFrs(_rhos.data(), n);
+  std::vector<G1> _ps(n + 1), _sig2s(n);
+  std::vector<G2> _qs(n + 1);
+  {
+    PS_PHASE(VERIFIER, G1_MUL);
+    for (size_t j = 0; j < n; j++) {
+      const auto& proof = proofs[_candidates[j]];
+      G1::mul(_ps[j], proof.sig1, _rhos[j]);
+      _sig2s[j] = proof.sig2;
+      _qs[j] = _final_ks[j];
+    }
+    G1::mulVec(_ps[n], _sig2s.data(), _rhos.data(), n);
+    G1::neg(_ps[n], _ps[n]);
+  }
+  GT _f;
+  {
+    PS_PHASE(VERIFIER, PAIRING);
+    if (m_tables.empty()) {
+      _qs[n] = m_pk.gg;
+      millerLoopVec(_f, _ps.data(), _qs.data(), n + 1);
+    }
+    else {
+      GT _f_gg;
+      millerLoopVec(_f, _ps.data(), _qs.data(), n);
+      precomputedMillerLoop(_f_gg, _ps[n], m_tables.gg_lines.data());
+      GT::mul(_f, _f, _f_gg);
+    }
+    finalExp(_f, _f);
+  }
+  if (_f.isOne()) {
+    return n == proofs.size();
+  }
+
+  // some signature is invalid, find out which
+  bool _all_valid = n == proofs.size();
+  for (size_t j = 0; j < n; j++) {
+    const auto& proof = proofs[_candidates[j]];
+    verdicts[_candidates[j]] = check_pairing(proof.sig1, _final_ks[j], proof.sig2);
+    _all_valid = _all_valid && verdicts[_candidates[j]];
+  }
+  return _all_valid;
 }
 
 G2
 PSVerifier::prepare_hybrid_verification(const G2& k, const std::vector<std::string>& attributes) const
 {
   G2 _final_k = k;
-  G2 _temp_yyi_hash;
-  Fr _temp_hash;
-  for (size_t i = 0; i < attributes.size(); i++) {
-    if (attributes[i] == "") {
-      continue;
+  std::vector<std::pair<size_t, Fr>> _terms;
+  _terms.reserve(attributes.size());
+  {
+    PS_PHASE(VERIFIER, HASH);
+    for (size_t i = 0; i < attributes.size(); i++) {
+      if (attributes[i] == "") {
+        continue;
+      }
+      _terms.emplace_back(i, Fr());
+      _terms.back().second.setHashOf(attributes[i]);
     }
-    _temp_hash.setHashOf(attributes[i]);
-    G2::mul(_temp_yyi_hash, m_pk.YYi[i], _temp_hash);
-    G2::add(_final_k, _final_k, _temp_yyi_hash);
   }
+  mul_add_YYi_terms(_final_k, _terms, nullptr);
   return _final_k;
 }
 
+bool
+PSVerifier::check_pairing(const G1& sig1, const G2& k, const G1& sig2) const
+{
+  PS_PHASE(VERIFIER, PAIRING);
+  if (m_tables.empty()) {
+    GT lhs, rhs;
+    pairing(lhs, sig1, k);
+    pairing(rhs, sig2, m_pk.gg);
+    return lhs == rhs;
+  }
+  // e(sig1, k) * e(-sig2, gg) == 1, sharing one final exponentiation
+  G1 _neg_sig2;
+  G1::neg(_neg_sig2, sig2);
+  GT _f;
+  precomputedMillerLoop2mixed(_f, sig1, k, _neg_sig2, m_tables.gg_lines.data());
+  finalExp(_f, _f);
+  return _f.isOne();
+}
+
+void
+PSVerifier::mul_add(G2& z, const G2& base, const PSFixedBaseTable<G2>& table, const Fr& s) const
+{
+  PS_PHASE(VERIFIER, G2_MUL);
+  if (table.empty()) {
+    G2 _temp;
+    G2::mul(_temp, base, s);
+    G2::add(z, z, _temp);
+  }
+  else {
+    table.mulAdd(z, s);
+  }
+}
+
+void
+PSVerifier::mul_add_YYi(G2& z, size_t i, const Fr& s) const
+{
+  PS_PHASE(VERIFIER, G2_MUL);
+  if (m_tables.empty()) {
+    G2 _temp;
+    G2::mul(_temp, m_pk.YYi[i], s);
+    G2::add(z, z, _temp);
+  }
+  else {
+    m_tables.YYi[i].mulAdd(z, s);
+  }
+}
+
 std::string
 PSVerifier::get_user_name_from_signon_request(const IdProof& proof)
 {
   return proof.phi.getStr();
-}
\ No newline at end of file
+}
+
+void
+PSVerifier::mul_add_YYi_terms(G2& z, const std::vector<std::pair<size_t, Fr>>& terms,
+                              const std::function<void()>& side_task) const
+{
+  size_t _chunk_num = m_thread_pool == nullptr ? 1 : std::min(m_thread_pool->size(), terms.size() / PS_MIN_TERMS_PER_TASK);
+  if (_chunk_num <= 1) {
+    if (side_task) {
+      side_task();
+    }
+    for (const auto& term : terms) {
+      mul_add_YYi(z, term.first, term.second);
+    }
+    return;
+  }
+  // the side task is one more task next to the ranges of terms
+  std::vector<G2> _parts(_chunk_num);
+  size_t _task_num = side_task ? _chunk_num + 1 : _chunk_num;
+  m_thread_pool->parallelFor(_task_num, [&](size_t begin, size_t end) {
+    for (size_t c = begin; c < end; c++) {
+      if (c == _chunk_num) {
+        side_task();
+        continue;
+      }
+      _parts[c].clear();
+      for (size_t j = terms.size() * c / _chunk_num; j < terms.size() * (c + 1) / _chunk_num; j++) {
+        mul_add_YYi(_parts[c], terms[j].first, terms[j].second);
+      }
+    }
+  });
+  for (const auto& part : _parts) {
+    G2::add(z, z, part);
+  }
+}
@@ -1,7 +1,12 @@
 #ifndef PS_SRC_PS_VERIFIER_H_
 #define PS_SRC_PS_VERIFIER_H_
 
+#include "ps-authority.h"
 #include "ps-encoding.h"
+#include "ps-precompute.h"
+#include "ps-thread-pool.h"
+
+#include <functional>
 
 using namespace mcl::bls12;
 
@@ -17,6 +22,38 @@ public:
    */
   PSVerifier(const PSPubKey& pk);
 
+  /**
+   * @brief Build fixed-base tables for gg, XX and every YYi, and the Miller lines of gg,
+   *        used by all later verifications.
+   *
+   * Each G2 table takes PSFixedBaseTable<G2>::BYTE_SIZE bytes. Worker processes sharing a public key
+   * should attach to a PSSharedTables segment instead.
+   */
+  void
+  precompute();
+
+  /**
+   * @brief Use tables built elsewhere, e.g., attached from a PSSharedTables segment.
+   *
+   * @param tables input Tables built from this verifier's public key.
+   * @throw std::runtime_error if the tables do not match the attribute number.
+   */
+  void
+  use_tables(const PSVerifierTables& tables);
+
+  /**
+   * @brief Split each verification of many attributes across @p thread_pool.
+   *
+   * The YYi terms of V_k and of the plaintext attributes are split into ranges, and V_phi, V_E1 and V_E2
+   * run as one more task, joined before the transcript hash. Verifications of a few attributes stay on
+   * the calling thread.
+   *
+   * @param thread_pool input The pool, which must outlive its use, or nullptr to stop using one.
+   *        Verifications must not run from tasks on the same pool.
+   */
+  void
+  use_thread_pool(PSThreadPool* thread_pool);
+
   /**
    * @brief Verify the signature over the given attributes (all in plaintext).
    *
@@ -48,11 +85,60 @@ public:
                      const std::string& service_name,
                      const G1& authority_pk, const G1& g, const G1& h) const;
 
+  /**
+   * @brief EL PASSO VerifyID with the authority points of @p authority, whose tables (if precomputed)
+   *        compute V_E1 and V_E2.
+   */
+  bool
+  el_passo_verify_id(const IdProof& proof,
+                     const std::string& associated_data,
+                     const std::string& service_name,
+                     const PSAuthorityContext& authority) const;
+
   bool
   el_passo_verify_id_without_id_retrieval(const IdProof& proof,
                                           const std::string& associated_data,
                                           const std::string& service_name) const;
 
+  /**
+   * @brief EL PASSO VerifyID over a batch of proofs.
+   *
+   * The NIZK proof of every proof is checked on its own. The signature checks of the proofs passing it
+   * are combined with random exponents rho_i into
+   *   PI{ e(sig1_i^rho_i, k_i) } * e(-SUM{ sig2_i^rho_i }, gg) == 1,
+   * a single multi-Miller loop and final exponentiation. If the combined check fails, every signature
+   * is checked on its own to find the invalid ones.
+   *
+   * @param proofs input The ProveID messages.
+   * @param associated_data input The associated data of each proof.
+   * @param service_names input The service name of each proof.
+   * @param authority_pk input The EL Gamal public key of the accountability authority.
+   * @param g input As in PSVerifier::el_passo_verify_id().
+   * @param h input As in PSVerifier::el_passo_verify_id().
+   * @param verdicts output Whether each proof is valid.
+   * @return true if all proofs are valid.
+   * @throw std::runtime_error if the input sizes do not match.
+   */
+  bool
+  el_passo_verify_id_batch(const std::vector<IdProof>& proofs,
+                           const std::vector<std::string>& associated_data,
+                           const std::vector<std::string>& service_names,
+                           const G1& authority_pk, const G1& g, const G1& h,
+                           std::vector<bool>& verdicts) const;
+
+  bool
+  el_passo_verify_id_batch(const std::vector<IdProof>& proofs,
+                           const std::vector<std::string>& associated_data,
+                           const std::vector<std::string>& service_names,
+                           const PSAuthorityContext& authority,
+                           std::vector<bool>& verdicts) const;
+
+  bool
+  el_passo_verify_id_batch_without_id_retrieval(const std::vector<IdProof>& proofs,
+                                                const std::vector<std::string>& associated_data,
+                                                const std::vector<std::string>& service_names,
+                                                std::vector<bool>& verdicts) const;
+
   /**
    * @brief Get the user name from signon request object.
    *
@@ -63,11 +149,44 @@ public:
   get_user_name_from_signon_request(const IdProof& proof);
 
 private:
+  // the NIZK half of el_passo_verify_id()
+  bool
+  check_id_nizk(const IdProof& proof, const std::string& associated_data, const std::string& service_name,
+                const PSAuthorityContext& authority) const;
+
+  // the NIZK half of el_passo_verify_id_without_id_retrieval()
+  bool
+  check_id_nizk_without_id_retrieval(const IdProof& proof, const std::string& associated_data,
+                                     const std::string& service_name) const;
+
+  // signature checks of the proofs whose verdict is true, which is cleared for the invalid ones
+  bool
+  check_id_signatures(const std::vector<IdProof>& proofs, std::vector<bool>& verdicts) const;
+
   G2
   prepare_hybrid_verification(const G2& k, const std::vector<std::string>& attributes) const;
 
+  // e(sig1, k) == e(sig2, gg)
+  bool
+  check_pairing(const G1& sig1, const G2& k, const G1& sig2) const;
+
+  // z = z * base^s, through the table of base when precomputed
+  void
+  mul_add(G2& z, const G2& base, const PSFixedBaseTable<G2>& table, const Fr& s) const;
+
+  void
+  mul_add_YYi(G2& z, size_t i, const Fr& s) const;
+
+  // z = z * PI{ YYi^s } over the (i, s) terms, split across m_thread_pool if set, with side_task
+  // (if any) running as one more task
+  void
+  mul_add_YYi_terms(G2& z, const std::vector<std::pair<size_t, Fr>>& terms,
+                    const std::function<void()>& side_task) const;
+
 private:
-  PSPubKey m_pk;  // public key
+  PSPubKey m_pk;              // public key
+  PSVerifierTables m_tables;  // empty if not precomputed
+  PSThreadPool* m_thread_pool = nullptr;  // splits single verifications if set
 };
 
 #endif  // PS_SRC_PS_VERIFIER_H_
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "ps-wallet.h"
+
+#include <cstdint>
+
+using namespace mcl::bls12;
+
+PSWallet::PSWallet(const PSRequester& requester)
+    : m_requester(requester)
+{
+}
+
+size_t
+PSWallet::addCredential(const PSCredential& sig, const std::vector<std::tuple<std::string, bool>>& attributes)
+{
+  std::vector<PSAttributeView> views;
+  views.reserve(attributes.size());
+  for (const auto& attribute : attributes) {
+    views.emplace_back(std::get<0>(attribute), std::get<1>(attribute));
+  }
+  Credential credential;
+  credential.sig = sig;
+  m_requester.cache_attributes(views.data(), views.size(), true, credential.cache);
+  m_credentials.push_back(std::move(credential));
+  return m_credentials.size() - 1;
+}
+
+size_t
+PSWallet::size() const
+{
+  return m_credentials.size();
+}
+
+IdProof
+PSWallet::prove(size_t index, const std::string& associated_data, const std::string& service_name,
+                const G1& authority_pk, const G1& g, const G1& h)
+{
+  PSAuthorityContext authority(authority_pk, g, h);
+  return prove(index, associated_data, service_name, &authority);
+}
+
+IdProof
+PSWallet::prove(size_t index, const std::string& associated_data, const std::string& service_name,
+                const PSAuthorityContext& authority)
+{
+  return prove(index, associated_data, service_name, &authority);
+}
+
+IdProof
+PSWallet::prove(size_t index, const std::string& associated_data, const std::string& service_name)
+{
+  return prove(index, associated_data, service_name, nullptr);
+}
+
+IdProof
+PSWallet::prove(size_t index, const std::string& associated_data, const std::string& service_name,
+                const PSAuthorityContext* authority)
+{
+  if (index >= m_credentials.size()) {
+    throw std::runtime_error("no such credential");
+  }
+  const auto& credential = m_credentials[index];
+  PSPresentationContext context;
+  m_requester.prepare_presentation(credential.sig, credential.cache, authority, context);
+  IdProof proof;
+  m_requester.prove_online(context, associated_data, serviceHash(service_name), proof);
+  return proof;
+}
+
+std::vector<IdProof>
+PSWallet::proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+                    const G1& authority_pk, const G1& g, const G1& h, PSThreadPool& thread_pool)
+{
+  PSAuthorityContext authority(authority_pk, g, h);
+  return proveBulk(index, requests, &authority, thread_pool);
+}
+
+std::vector<IdProof>
+PSWallet::proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+                    const PSAuthorityContext& authority, PSThreadPool& thread_pool)
+{
+  return proveBulk(index, requests, &authority, thread_pool);
+}
+
+std::vector<IdProof>
+PSWallet::proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+                    PSThreadPool& thread_pool)
+{
+  return proveBulk(index, requests, nullptr, thread_pool);
+}
+
+std::vector<IdProof>
+PSWallet::proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+                    const PSAuthorityContext* authority, PSThreadPool& thread_pool)
+{
+  if (index >= m_credentials.size()) {
+    throw std::runtime_error("no such credential");
+  }
+  const auto& credential = m_credentials[index];
+  auto service_hashes = serviceHashes(requests, thread_pool);
+  std::vector<IdProof> proofs(requests.size());
+  thread_pool.parallelFor(requests.size(), [&](size_t begin, size_t end) {
+    // each proof draws its own randomness from the thread's source
+    PSPresentationContext context;
+    for (size_t i = begin; i < end; i++) {
+      m_requester.prepare_presentation(credential.sig, credential.cache, authority, context);
+      m_requester.prove_online(context, std::get<1>(requests[i]), service_hashes[i], proofs[i]);
+    }
+  });
+  return proofs;
+}
+
+G1
+PSWallet::serviceHash(const std::string& service_name)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (const G1* cached = findServiceHash(service_name)) {
+      return *cached;
+    }
+  }
+  G1 service_hash;
+  hashAndMapToG1(service_hash, service_name);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  cacheServiceHash(service_name, service_hash);
+  return service_hash;
+}
+
+std::vector<G1>
+PSWallet::serviceHashes(const std::vector<std::pair<std::string, std::string>>& requests, PSThreadPool& thread_pool)
+{
+  // cached hashes are copied out first, as caching the missing ones may evict them
+  std::vector<G1> service_hashes(requests.size());
+  std::vector<std::string> missing;
+  std::vector<size_t> missing_indices(requests.size(), SIZE_MAX);  // into missing, for uncached requests
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unordered_map<std::string, size_t> seen;
+    for (size_t i = 0; i < requests.size(); i++) {
+      const auto& service_name = std::get<0>(requests[i]);
+      if (const G1* cached = findServiceHash(service_name)) {
+        service_hashes[i] = *cached;
+        continue;
+      }
+      auto it = seen.emplace(service_name, missing.size()).first;
+      if (it->second == missing.size()) {
+        missing.push_back(service_name);
+      }
+      missing_indices[i] = it->second;
+    }
+  }
+  std::vector<G1> missing_hashes(missing.size());
+  thread_pool.parallelFor(missing.size(), [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      hashAndMapToG1(missing_hashes[i], missing[i]);
+    }
+  });
+
+  for (size_t i = 0; i < requests.size(); i++) {
+    if (missing_indices[i] != SIZE_MAX) {
+      service_hashes[i] = missing_hashes[missing_indices[i]];
+    }
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < missing.size(); i++) {
+    cacheServiceHash(missing[i], missing_hashes[i]);
+  }
+  return service_hashes;
+}
+
+const G1*
+PSWallet::findServiceHash(const std::string& service_name)
+{
+  auto it = m_service_hashes.find(service_name);
+  if (it == m_service_hashes.end()) {
+    return nullptr;
+  }
+  m_service_order.splice(m_service_order.begin(), m_service_order, it->second);
+  return &it->second->second;
+}
+
+void
+PSWallet::cacheServiceHash(const std::string& service_name, const G1& service_hash)
+{
+  // another thread may have cached it meanwhile
+  if (findServiceHash(service_name) != nullptr) {
+    return;
+  }
+  if (m_service_order.size() == SERVICE_HASH_CAPACITY) {
+    m_service_hashes.erase(m_service_order.back().first);
+    m_service_order.pop_back();
+  }
+  m_service_order.emplace_front(service_name, service_hash);
+  m_service_hashes.emplace(service_name, m_service_order.begin());
+}
@@ -0,0 +1,134 @@
+#ifndef PS_SRC_PS_WALLET_H_
+#define PS_SRC_PS_WALLET_H_
+
+#include "ps-requester.h"
+#include "ps-thread-pool.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+using namespace mcl::bls12;
+
+/**
+ * @brief A user's credentials, kept with what EL PASSO ProveID derives from them alone.
+ *
+ * Adding a credential hashes its attributes and computes XX * PI{ YYj^mj } once. The hash points of
+ * the SERVICE_HASH_CAPACITY most recently used service names are cached. A sign on then only does the
+ * work that depends on its randomness: randomizing the signature, gg^t, V_k, the identity retrieval
+ * token and the responses.
+ *
+ * The requester must outlive the PSWallet. PSWallet::prove() may run on several threads at once,
+ * but not concurrently with PSWallet::addCredential().
+ */
+class PSWallet {
+public:
+  static constexpr size_t SERVICE_HASH_CAPACITY = 1024;
+
+public:
+  /**
+   * @brief Construct an empty wallet.
+   *
+   * @param requester input The owner of the credentials, precomputed or not.
+   */
+  PSWallet(const PSRequester& requester);
+
+  /**
+   * @brief Add an unblinded credential.
+   *
+   * @param sig input The unblinded PS signature.
+   * @param attributes input As in PSRequester::el_passo_prove_id().
+   * @return the index of the credential.
+   * @throw std::runtime_error if the attribute number does not match the public key.
+   */
+  size_t
+  addCredential(const PSCredential& sig, const std::vector<std::tuple<std::string, bool>>& attributes);
+
+  /**
+   * @brief The number of credentials.
+   */
+  size_t
+  size() const;
+
+  /**
+   * @brief PSRequester::el_passo_prove_id() with credential @p index.
+   */
+  IdProof
+  prove(size_t index, const std::string& associated_data, const std::string& service_name,
+        const G1& authority_pk, const G1& g, const G1& h);
+
+  IdProof
+  prove(size_t index, const std::string& associated_data, const std::string& service_name,
+        const PSAuthorityContext& authority);
+
+  /**
+   * @brief PSRequester::el_passo_prove_id_without_id_retrieval() with credential @p index.
+   */
+  IdProof
+  prove(size_t index, const std::string& associated_data, const std::string& service_name);
+
+  /**
+   * @brief Prove the ownership of credential @p index to many RPs at once on @p thread_pool.
+   *
+   * The service names not cached yet are hashed in parallel first. Every proof is randomized on its own,
+   * exactly as with PSWallet::prove(), so the proofs cannot be linked to each other.
+   *
+   * @param index input The credential.
+   * @param requests input Pairs of service_name and associated_data, one per proof.
+   * @param authority_pk input As in PSRequester::el_passo_prove_id().
+   * @param g input As in PSRequester::el_passo_prove_id().
+   * @param h input As in PSRequester::el_passo_prove_id().
+   * @param thread_pool input The threads generating the proofs.
+   * @return the proofs, in the order of @p requests.
+   */
+  std::vector<IdProof>
+  proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+            const G1& authority_pk, const G1& g, const G1& h, PSThreadPool& thread_pool);
+
+  std::vector<IdProof>
+  proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+            const PSAuthorityContext& authority, PSThreadPool& thread_pool);
+
+  std::vector<IdProof>
+  proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+            PSThreadPool& thread_pool);
+
+private:
+  std::vector<IdProof>
+  proveBulk(size_t index, const std::vector<std::pair<std::string, std::string>>& requests,
+            const PSAuthorityContext* authority, PSThreadPool& thread_pool);
+
+  IdProof
+  prove(size_t index, const std::string& associated_data, const std::string& service_name,
+        const PSAuthorityContext* authority);
+
+  // hash(service_name), cached
+  G1
+  serviceHash(const std::string& service_name);
+
+  // hash(service_name) of every request, the missing ones computed in parallel and cached
+  std::vector<G1>
+  serviceHashes(const std::vector<std::pair<std::string, std::string>>& requests, PSThreadPool& thread_pool);
+
+  // looks up and marks as most recently used, m_mutex must be held
+  const G1*
+  findServiceHash(const std::string& service_name);
+
+  // caches, evicting the least recently used hash beyond SERVICE_HASH_CAPACITY, m_mutex must be held
+  void
+  cacheServiceHash(const std::string& service_name, const G1& service_hash);
+
+private:
+  struct Credential {
+    PSCredential sig;
+    PSAttributeCache cache;
+  };
+
+  const PSRequester& m_requester;
+  std::vector<Credential> m_credentials;
+  std::mutex m_mutex;  // guards m_service_hashes and m_service_order
+  std::list<std::pair<std::string, G1>> m_service_order;  // most recently used first
+  std::unordered_map<std::string, std::list<std::pair<std::string, G1>>::iterator> m_service_hashes;
+};
+
+#endif  // PS_SRC_PS_WALLET_H_
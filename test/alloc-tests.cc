@@ -0,0 +1,412 @@
+#include <ps-encoding.h>
+#include <ps-requester.h>
+#include <ps-signer.h>
+#include <ps-verifier.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+
+using namespace mcl::bls12;
+
+/**
+ * alloc-tests: heap allocations and bytes per call of the public APIs of PSSigner, PSRequester, PSVerifier
+ * and PSBuffer, checked against the budgets recorded in test/alloc-budgets.txt.
+ *
+ * Every call is warmed up first, so that scratch space kept across calls and caller-owned outputs are
+ * not counted. A call over its budget fails the test; a call under it is fine, and the budgets can be
+ * lowered with "make alloc-budgets" afterwards. Allocation counts do not depend on the sizes of points
+ * and are checked on every build. Byte budgets only apply to the build they were recorded with, so on
+ * another curve or mcl build they are not checked and the test fails until the budgets are recorded.
+ *
+ * Usage:
+ *   alloc-tests [--budgets test/alloc-budgets.txt] [--record]
+ */
+
+// every heap allocation of the process goes through these
+static std::atomic<size_t> s_allocation_num{0};
+static std::atomic<size_t> s_allocated_bytes{0};
+
+void*
+operator new(size_t size)
+{
+  s_allocation_num++;
+  s_allocated_bytes += size;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void*
+operator new(size_t size, std::align_val_t alignment)
+{
+  s_allocation_num++;
+  s_allocated_bytes += size;
+  size_t align = static_cast<size_t>(alignment);
+  if (void* p = std::aligned_alloc(align, (std::max<size_t>(size, 1) + align - 1) / align * align)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, size_t) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+void
+operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+struct PSAllocationCount {
+  size_t allocations;
+  size_t bytes;
+};
+
+class PSAllocationBudgets {
+public:
+  // the sizes that allocations depend on besides the code
+  static std::string
+  currentBuild()
+  {
+    std::ostringstream os;
+    os << PSCurve::NAME << " g1=" << sizeof(G1) << " g2=" << sizeof(G2) << " fr=" << sizeof(Fr);
+    return os.str();
+  }
+
+  static std::string
+  keyOf(const std::string& operation, size_t attribute_num)
+  {
+    return operation + " " + std::to_string(attribute_num);
+  }
+
+  bool
+  load(const std::string& path)
+  {
+    std::ifstream file(path);
+    if (!file) {
+      return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+      if (line.compare(0, 8, "# build ") == 0) {
+        m_build = line.substr(8);
+        continue;
+      }
+      if (line.empty() || line[0] == '#') {
+        continue;
+      }
+      std::istringstream fields(line);
+      std::string operation;
+      size_t attribute_num;
+      PSAllocationCount count;
+      if (fields >> operation >> attribute_num >> count.allocations >> count.bytes) {
+        m_budgets.emplace_back(keyOf(operation, attribute_num), count);
+      }
+    }
+    return true;
+  }
+
+  void
+  save(const std::string& path, const std::vector<std::pair<std::string, PSAllocationCount>>& counts) const
+  {
+    std::ofstream file(path);
+    file << "# heap allocations and bytes per call, recorded with \"make alloc-budgets\"\n"
+         << "# build " << currentBuild() << "\n"
+         << "# operation attributes allocations bytes\n";
+    for (const auto& count : counts) {
+      file << count.first << " " << count.second.allocations << " " << count.second.bytes << "\n";
+    }
+    if (!file) {
+      throw std::runtime_error("cannot write " + path);
+    }
+  }
+
+  const std::string&
+  build() const
+  {
+    return m_build;
+  }
+
+  const PSAllocationCount*
+  find(const std::string& key) const
+  {
+    for (const auto& budget : m_budgets) {
+      if (budget.first == key) {
+        return &budget.second;
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  std::string m_build;
+  std::vector<std::pair<std::string, PSAllocationCount>> m_budgets;
+};
+
+class PSAllocationHarness {
+public:
+  // counts per call of f, rounded up, after warming up
+  template<class F>
+  void
+  measure(const std::string& operation, size_t attribute_num, F f)
+  {
+    const size_t warmup_num = 4, call_num = 20;
+    for (size_t i = 0; i < warmup_num; i++) {
+      f();
+    }
+    size_t allocations = s_allocation_num;
+    size_t bytes = s_allocated_bytes;
+    for (size_t i = 0; i < call_num; i++) {
+      f();
+    }
+    PSAllocationCount count;
+    count.allocations = (s_allocation_num - allocations + call_num - 1) / call_num;
+    count.bytes = (s_allocated_bytes - bytes + call_num - 1) / call_num;
+    m_counts.emplace_back(PSAllocationBudgets::keyOf(operation, attribute_num), count);
+  }
+
+  const std::vector<std::pair<std::string, PSAllocationCount>>&
+  counts() const
+  {
+    return m_counts;
+  }
+
+private:
+  std::vector<std::pair<std::string, PSAllocationCount>> m_counts;
+};
+
+static void
+check(bool result, const std::string& operation)
+{
+  if (!result) {
+    std::cerr << operation << " failed" << std::endl;
+    exit(1);
+  }
+}
+
+// every public API over @p attribute_num attributes, s and gamma committed and the others in plaintext
+static void
+measureAll(PSAllocationHarness& harness, size_t attribute_num)
+{
+  G1 g, authority_pk, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  std::vector<std::tuple<std::string, bool>> attributes;
+  std::vector<PSAttributeView> views;
+  std::vector<std::string> all_attributes;
+  for (size_t i = 0; i < attribute_num; i++) {
+    // longer than the small string buffer, so copies allocate
+    all_attributes.push_back("attribute-value-" + std::to_string(i) + "-0123456789");
+    attributes.emplace_back(all_attributes.back(), i < 2);
+  }
+  for (const auto& attribute : attributes) {
+    views.emplace_back(std::get<0>(attribute), std::get<1>(attribute));
+  }
+  bool result = true;
+
+  // PSSigner
+  PSSigner idp(attribute_num, g, gg);
+  PSPubKey pk;
+  harness.measure("signer.key_gen", attribute_num, [&] { pk = idp.key_gen(); });
+  harness.measure("signer.get_pub_key", attribute_num, [&] { pk = idp.get_pub_key(); });
+  PSRequester user(pk);
+  PSVerifier rp(pk);
+  PSBlindingContext context;
+  PSCredRequest request;
+  user.el_passo_request_id(views.data(), views.size(), "alloc", context, request);
+  G1 commitment;
+  harness.measure("signer.el_passo_verify_request", attribute_num, [&] {
+    result &= idp.el_passo_verify_request(request, "alloc", commitment);
+  });
+  check(result, "signer.el_passo_verify_request");
+  PSCredential sig;
+  harness.measure("signer.el_passo_provide_id", attribute_num, [&] {
+    result &= idp.el_passo_provide_id(request, "alloc", sig);
+  });
+  check(result, "signer.el_passo_provide_id");
+  harness.measure("signer.sign_commitment", attribute_num, [&] { sig = idp.sign_commitment(commitment); });
+  harness.measure("signer.sign_hybrid", attribute_num, [&] { sig = idp.sign_hybrid(request.A, request.attributes); });
+
+  // PSRequester
+  harness.measure("requester.el_passo_request_id", attribute_num, [&] {
+    request = user.el_passo_request_id(attributes, "alloc", context);
+  });
+  harness.measure("requester.el_passo_request_id_view", attribute_num, [&] {
+    user.el_passo_request_id(views.data(), views.size(), "alloc", context, request);
+  });
+  idp.el_passo_provide_id(request, "alloc", sig);
+  PSCredential ubld_sig;
+  harness.measure("requester.unblind_credential", attribute_num, [&] {
+    ubld_sig = user.unblind_credential(sig, context);
+  });
+  harness.measure("requester.verify", attribute_num, [&] { result &= user.verify(ubld_sig, all_attributes); });
+  check(result, "requester.verify");
+  PSCredential rnd_sig;
+  harness.measure("requester.randomize_credential", attribute_num, [&] {
+    rnd_sig = user.randomize_credential(ubld_sig);
+  });
+  IdProof proof, proof2;
+  harness.measure("requester.el_passo_prove_id", attribute_num, [&] {
+    proof = user.el_passo_prove_id(ubld_sig, attributes, "alloc", "service", authority_pk, g, h);
+  });
+  harness.measure("requester.el_passo_prove_id_view", attribute_num, [&] {
+    user.el_passo_prove_id(ubld_sig, views.data(), views.size(), "alloc", "service", authority_pk, g, h, proof);
+  });
+  harness.measure("requester.el_passo_prove_id_without_id_retrieval", attribute_num, [&] {
+    proof2 = user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, "alloc", "service");
+  });
+  harness.measure("requester.el_passo_prove_id_without_id_retrieval_view", attribute_num, [&] {
+    user.el_passo_prove_id_without_id_retrieval(ubld_sig, views.data(), views.size(), "alloc", "service", proof2);
+  });
+  PSPresentationContext presentation;
+  harness.measure("requester.el_passo_prepare_prove_id", attribute_num, [&] {
+    presentation = user.el_passo_prepare_prove_id(ubld_sig, attributes, authority_pk, g, h);
+  });
+  IdProof online_proof;
+  harness.measure("requester.el_passo_prove_id_online", attribute_num, [&] {
+    if (presentation.empty()) {
+      // preparing is measured above, only the online part counts here
+      size_t allocations = s_allocation_num, bytes = s_allocated_bytes;
+      presentation = user.el_passo_prepare_prove_id(ubld_sig, attributes, authority_pk, g, h);
+      s_allocation_num = allocations;
+      s_allocated_bytes = bytes;
+    }
+    online_proof = user.el_passo_prove_id_online(std::move(presentation), "alloc", "service");
+  });
+
+  // PSVerifier
+  harness.measure("verifier.verify", attribute_num, [&] { result &= rp.verify(ubld_sig, all_attributes); });
+  check(result, "verifier.verify");
+  harness.measure("verifier.el_passo_verify_id", attribute_num, [&] {
+    result &= rp.el_passo_verify_id(proof, "alloc", "service", authority_pk, g, h);
+  });
+  check(result, "verifier.el_passo_verify_id");
+  harness.measure("verifier.el_passo_verify_id_without_id_retrieval", attribute_num, [&] {
+    result &= rp.el_passo_verify_id_without_id_retrieval(proof2, "alloc", "service");
+  });
+  check(result, "verifier.el_passo_verify_id_without_id_retrieval");
+  const size_t batch_size = 8;
+  std::vector<IdProof> proofs(batch_size, proof), proofs2(batch_size, proof2);
+  std::vector<std::string> associated_data(batch_size, "alloc"), service_names(batch_size, "service");
+  std::vector<bool> verdicts;
+  harness.measure("verifier.el_passo_verify_id_batch", attribute_num, [&] {
+    rp.el_passo_verify_id_batch(proofs, associated_data, service_names, authority_pk, g, h, verdicts);
+  });
+  for (bool verdict : verdicts) {
+    check(verdict, "verifier.el_passo_verify_id_batch");
+  }
+  harness.measure("verifier.el_passo_verify_id_batch_without_id_retrieval", attribute_num, [&] {
+    rp.el_passo_verify_id_batch_without_id_retrieval(proofs2, associated_data, service_names, verdicts);
+  });
+  for (bool verdict : verdicts) {
+    check(verdict, "verifier.el_passo_verify_id_batch_without_id_retrieval");
+  }
+
+  // PSBuffer
+  PSBuffer buf;
+  harness.measure("buffer.pk_encode", attribute_num, [&] { buf = pk.toBufferString(); });
+  harness.measure("buffer.pk_decode", attribute_num, [&] { pk = PSPubKey::fromBufferString(buf); });
+  harness.measure("buffer.request_encode", attribute_num, [&] { buf = request.toBufferString(); });
+  harness.measure("buffer.request_decode", attribute_num, [&] { request = PSCredRequest::fromBufferString(buf); });
+  harness.measure("buffer.credential_encode", attribute_num, [&] { buf = sig.toBufferString(); });
+  harness.measure("buffer.credential_decode", attribute_num, [&] { sig = PSCredential::fromBufferString(buf); });
+  harness.measure("buffer.proof_encode", attribute_num, [&] { buf = proof.toBufferString(); });
+  harness.measure("buffer.proof_decode", attribute_num, [&] { proof = IdProof::fromBufferString(buf); });
+  std::string base64;
+  harness.measure("buffer.base64_encode", attribute_num, [&] { base64 = buf.toBase64(); });
+  harness.measure("buffer.base64_decode", attribute_num, [&] { buf = PSBuffer::fromBase64(base64); });
+}
+
+int
+main(int argc, char const* argv[])
+{
+  std::string budgets_path = "test/alloc-budgets.txt";
+  bool record = false;
+  for (int i = 1; i < argc; i++) {
+    std::string option = argv[i];
+    if (option == "--record") {
+      record = true;
+    }
+    else if (option == "--budgets" && i + 1 < argc) {
+      budgets_path = argv[++i];
+    }
+    else {
+      std::cerr << "usage: alloc-tests [--budgets test/alloc-budgets.txt] [--record]" << std::endl;
+      return 1;
+    }
+  }
+
+  PSCurve::init();
+  PSAllocationHarness harness;
+  for (size_t attribute_num : {3, 16}) {
+    measureAll(harness, attribute_num);
+  }
+  if (record) {
+    PSAllocationBudgets().save(budgets_path, harness.counts());
+    std::cout << "recorded " << harness.counts().size() << " budgets to " << budgets_path << std::endl;
+    return 0;
+  }
+
+  std::cout << "****test_allocation_budgets Start****" << std::endl;
+  PSAllocationBudgets budgets;
+  if (!budgets.load(budgets_path)) {
+    std::cout << "cannot read " << budgets_path << std::endl;
+    return 1;
+  }
+  // byte budgets of another build say nothing about this one, allocation counts still do
+  bool same_build = budgets.build() == PSAllocationBudgets::currentBuild();
+  size_t failure_num = 0;
+  std::cout << "operation\tattributes\tallocs/call\tbytes/call\tbudget" << std::endl;
+  for (const auto& count : harness.counts()) {
+    const auto* budget = budgets.find(count.first);
+    std::string key = count.first;
+    key[key.rfind(' ')] = '\t';
+    std::cout << key << "\t" << count.second.allocations << "\t" << count.second.bytes << "\t";
+    if (budget == nullptr) {
+      std::cout << "none";
+      failure_num++;
+    }
+    else {
+      std::cout << budget->allocations << "/" << budget->bytes;
+      if (count.second.allocations > budget->allocations || (same_build && count.second.bytes > budget->bytes)) {
+        std::cout << "\tOVER BUDGET";
+        failure_num++;
+      }
+    }
+    std::cout << std::endl;
+  }
+  if (failure_num != 0) {
+    std::cout << failure_num << " operations without a budget or over it" << std::endl;
+    return 1;
+  }
+  if (!same_build) {
+    std::cout << "byte budgets were recorded for " << budgets.build() << ", not " << PSAllocationBudgets::currentBuild()
+              << "; run \"make alloc-budgets\" to record them for this build" << std::endl;
+    return 1;
+  }
+  std::cout << "****test_allocation_budgets ends without errors****\n" << std::endl;
+  return 0;
+}
@@ -272,7 +272,7 @@ test_el_passo(size_t total_attribute_num)
 int
 main(int argc, char const *argv[])
 {
-  initPairing();
+  PSCurve::init();
   test_ps_buffer_encoding();
   test_pk_with_different_attr_num();
   test_ps_sign_verify();
@@ -1,9 +1,32 @@
+#include <ps-authority.h>
+#include <ps-corpus.h>
+#include <ps-fixed-size.h>
+#include <ps-instrumentation.h>
+#include <ps-presentation-pool.h>
+#include <ps-random.h>
 #include <ps-requester.h>
+#include <ps-reverifier.h>
+#include <ps-shared-tables.h>
 #include <ps-signer.h>
+#include <ps-thread-pool.h>
+#include <ps-trace.h>
 #include <ps-verifier.h>
+#include <ps-wallet.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
 
 using namespace mcl::bls12;
 
@@ -50,6 +73,1292 @@ test_ps_sign_verify()
             << std::endl;
 }
 
+void
+test_tampered_request()
+{
+  std::cout << "****test_tampered_request Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  PSPubKey pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("secret1", true));
+  attributes.push_back(std::make_tuple("secret2", true));
+  attributes.push_back(std::make_tuple("plain1", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+
+  PSCredential sig;
+  if (idp.el_passo_provide_id(request, "other", sig)) {
+    std::cout << "request with wrong associated data accepted" << std::endl;
+    return;
+  }
+  auto missing_r = request;
+  missing_r.rs.pop_back();
+  if (idp.el_passo_provide_id(missing_r, "hello", sig)) {
+    std::cout << "request with missing r accepted" << std::endl;
+    return;
+  }
+  auto revealed = request;
+  revealed.attributes[0] = "secret1";
+  if (idp.el_passo_provide_id(revealed, "hello", sig)) {
+    std::cout << "request with a changed hidden slot accepted" << std::endl;
+    return;
+  }
+  std::cout << "****test_tampered_request ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_ps_key_file()
+{
+  std::cout << "****test_ps_key_file Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  idp.precompute();
+  idp.save_key("/tmp/ps-tests-key.bin");
+
+  auto begin = std::chrono::steady_clock::now();
+  PSSigner restarted_idp("/tmp/ps-tests-key.bin");
+  auto end = std::chrono::steady_clock::now();
+  std::cout << "IDP-LoadKey over 3 attributes: "
+            << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()
+            << "[µs]" << std::endl;
+  if (restarted_idp.get_pub_key().toBufferString() != pubKey.toBufferString()) {
+    std::cout << "loaded public key mismatch" << std::endl;
+    return;
+  }
+  // saving again replaces the file, leaving the one mapped by restarted_idp intact
+  idp.save_key("/tmp/ps-tests-key.bin");
+  struct stat key_stat;
+  if (stat("/tmp/ps-tests-key.bin", &key_stat) != 0 || (key_stat.st_mode & 0777) != 0600 ||
+      access("/tmp/ps-tests-key.bin.tmp", F_OK) == 0) {
+    std::cout << "key file was not replaced atomically" << std::endl;
+    return;
+  }
+
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("secret1", true));
+  attributes.push_back(std::make_tuple("secret2", true));
+  attributes.push_back(std::make_tuple("plain1", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  if (!restarted_idp.el_passo_provide_id(request, "hello", sig)) {
+    std::cout << "sign request with loaded key failure" << std::endl;
+    return;
+  }
+  auto ubld_sig = user.unblind_credential(sig);
+  std::vector<std::string> all_attributes{"secret1", "secret2", "plain1"};
+  if (!user.verify(ubld_sig, all_attributes)) {
+    std::cout << "credential from loaded key verification failure" << std::endl;
+    return;
+  }
+
+  // crafted headers whose sizes would wrap around are rejected: attribute_num, point_offset, table_offset
+  std::ifstream key_file("/tmp/ps-tests-key.bin", std::ios::binary);
+  std::string key_bytes((std::istreambuf_iterator<char>(key_file)), std::istreambuf_iterator<char>());
+  const size_t attribute_num_offset = 152;
+  std::vector<std::pair<size_t, uint64_t>> crafted = {{attribute_num_offset, uint64_t(1) << 61},
+                                                      {attribute_num_offset, ~uint64_t(0)},
+                                                      {attribute_num_offset + 8, ~uint64_t(0) - 64},
+                                                      {attribute_num_offset + 16, ~uint64_t(0) - 64}};
+  for (const auto& field : crafted) {
+    std::string crafted_bytes = key_bytes;
+    std::memcpy(&crafted_bytes[field.first], &field.second, sizeof(field.second));
+    std::ofstream("/tmp/ps-tests-crafted-key.bin", std::ios::binary) << crafted_bytes;
+    try {
+      PSSigner crafted_idp("/tmp/ps-tests-crafted-key.bin");
+      std::cout << "crafted key file was loaded" << std::endl;
+      return;
+    }
+    catch (const std::runtime_error&) {
+    }
+  }
+  std::remove("/tmp/ps-tests-crafted-key.bin");
+  std::remove("/tmp/ps-tests-key.bin");
+  std::cout << "****test_ps_key_file ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_parallel_key_gen()
+{
+  std::cout << "****test_parallel_key_gen Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(300, g, gg);
+  PSThreadPool pool(4);
+  std::ostringstream pk_stream;
+  auto pubKey = idp.key_gen(pool, pk_stream);
+  auto encoded = pubKey.toBufferString();
+  if (pk_stream.str() != std::string(encoded.begin(), encoded.end())) {
+    std::cout << "streamed public key encoding mismatch" << std::endl;
+    return;
+  }
+
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  std::vector<std::string> all_attributes;
+  for (size_t i = 0; i < 300; i++) {
+    attributes.push_back(std::make_tuple("attr" + std::to_string(i), i % 3 == 0));
+    all_attributes.push_back("attr" + std::to_string(i));
+  }
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  if (!idp.el_passo_provide_id(request, "hello", sig)) {
+    std::cout << "sign request with parallel key failure" << std::endl;
+    return;
+  }
+  if (!user.verify(user.unblind_credential(sig), all_attributes)) {
+    std::cout << "credential from parallel key verification failure" << std::endl;
+    return;
+  }
+  std::cout << "****test_parallel_key_gen ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_shared_tables()
+{
+  std::cout << "****test_shared_tables Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSSharedTables::remove("/ps-tests-tables");
+  auto published = PSSharedTables::publish("/ps-tests-tables", pubKey);
+  idp.use_tables(published.signerTables());
+
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  if (!idp.el_passo_provide_id(request, "hello", sig)) {
+    std::cout << "sign request with shared tables failure" << std::endl;
+    return;
+  }
+  auto ubld_sig = user.unblind_credential(sig);
+  G1 authority_pk;
+  G1 h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  auto prove = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+
+  // a forked worker attaches to the segment published by its parent
+  pid_t pid = fork();
+  if (pid == 0) {
+    auto attached = PSSharedTables::attach("/ps-tests-tables", pubKey);
+    PSVerifier rp(pubKey);
+    rp.use_tables(attached.verifierTables());
+    _exit(rp.el_passo_verify_id(prove, "hello", "service", authority_pk, g, h) ? 0 : 1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  PSSharedTables::remove("/ps-tests-tables");
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::cout << "EL PASSO Verify ID with attached tables failed" << std::endl;
+    return;
+  }
+  std::cout << "****test_shared_tables ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_deterministic_randomness()
+{
+  std::cout << "****test_deterministic_randomness Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp1(3, g, gg);
+  PSSigner idp2(3, g, gg);
+  PSRandom::setDeterministicSeed("benchmark-seed");
+  auto pubKey1 = idp1.key_gen();
+  PSRandom::setDeterministicSeed("benchmark-seed");
+  auto pubKey2 = idp2.key_gen();
+  PSRandom::setDeterministicSeed("");
+  if (pubKey1.toBufferString() != pubKey2.toBufferString()) {
+    std::cout << "seeded key generation is not reproducible" << std::endl;
+    return;
+  }
+  auto pubKey3 = idp2.key_gen();
+  if (pubKey1.toBufferString() == pubKey3.toBufferString()) {
+    std::cout << "OS seeded key generation repeats a seeded key" << std::endl;
+    return;
+  }
+  std::cout << "****test_deterministic_randomness ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_fork_randomness()
+{
+  std::cout << "****test_fork_randomness Start****" << std::endl;
+  // the parent has drawn before, so a child continuing its DRBG would repeat the parent's next bytes
+  uint8_t parent_bytes[32], child_bytes[32];
+  PSRandom::generateBytes(parent_bytes, sizeof(parent_bytes));
+  int fds[2];
+  if (pipe(fds) != 0) {
+    std::cout << "cannot create pipe" << std::endl;
+    return;
+  }
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    PSRandom::generateBytes(child_bytes, sizeof(child_bytes));
+    bool ok = write(fds[1], child_bytes, sizeof(child_bytes)) == sizeof(child_bytes);
+    _exit(ok ? 0 : 1);
+  }
+  close(fds[1]);
+  PSRandom::generateBytes(parent_bytes, sizeof(parent_bytes));
+  bool received = read(fds[0], child_bytes, sizeof(child_bytes)) == sizeof(child_bytes);
+  close(fds[0]);
+  int status = 0;
+  waitpid(pid, &status, 0);
+  if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::cout << "forked child failed" << std::endl;
+    return;
+  }
+  if (std::equal(parent_bytes, parent_bytes + sizeof(parent_bytes), child_bytes)) {
+    std::cout << "parent and forked child draw the same randomness" << std::endl;
+    return;
+  }
+  std::cout << "****test_fork_randomness ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_batch_verify_id()
+{
+  std::cout << "****test_batch_verify_id Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  idp.el_passo_provide_id(request, "hello", sig);
+  auto ubld_sig = user.unblind_credential(sig);
+
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  std::vector<IdProof> proofs, proofs2;
+  std::vector<std::string> associated_data, service_names;
+  for (size_t i = 0; i < 6; i++) {
+    associated_data.push_back("session" + std::to_string(i));
+    service_names.push_back("service" + std::to_string(i % 2));
+    proofs.push_back(user.el_passo_prove_id(ubld_sig, attributes, associated_data[i], service_names[i], authority_pk, g, h));
+    proofs2.push_back(user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, associated_data[i], service_names[i]));
+  }
+  // proof 1 has a wrong associated data, proof 4 a signature that fails only the pairing check
+  associated_data[1] = "other session";
+  G1::add(proofs[4].sig2, proofs[4].sig2, g);
+  G1::add(proofs2[4].sig2, proofs2[4].sig2, g);
+
+  PSVerifier rp(pubKey);
+  std::vector<bool> verdicts, verdicts2;
+  for (int round = 0; round < 2; round++) {
+    bool all_valid = rp.el_passo_verify_id_batch(proofs, associated_data, service_names, authority_pk, g, h, verdicts);
+    bool all_valid2 = rp.el_passo_verify_id_batch_without_id_retrieval(proofs2, associated_data, service_names, verdicts2);
+    if (all_valid || all_valid2) {
+      std::cout << "batch with invalid proofs verified" << std::endl;
+      return;
+    }
+    for (size_t i = 0; i < proofs.size(); i++) {
+      if (verdicts[i] != rp.el_passo_verify_id(proofs[i], associated_data[i], service_names[i], authority_pk, g, h) ||
+          verdicts2[i] != rp.el_passo_verify_id_without_id_retrieval(proofs2[i], associated_data[i], service_names[i]) ||
+          verdicts[i] != (i != 1 && i != 4)) {
+        std::cout << "batch verdict " << i << " differs from single verification" << std::endl;
+        return;
+      }
+    }
+    // the same with precomputed tables
+    rp.precompute();
+  }
+  proofs.erase(proofs.begin() + 4);
+  proofs.erase(proofs.begin() + 1);
+  associated_data.erase(associated_data.begin() + 4);
+  associated_data.erase(associated_data.begin() + 1);
+  service_names.erase(service_names.begin() + 4);
+  service_names.erase(service_names.begin() + 1);
+  if (!rp.el_passo_verify_id_batch(proofs, associated_data, service_names, authority_pk, g, h, verdicts)) {
+    std::cout << "batch of valid proofs failed" << std::endl;
+    return;
+  }
+  std::cout << "****test_batch_verify_id ends without errors****\n"
+            << std::endl;
+}
+
+// reusing a context would reuse its randomness, so it can only be moved
+static_assert(!std::is_copy_constructible_v<PSPresentationContext>);
+static_assert(!std::is_copy_assignable_v<PSPresentationContext>);
+static_assert(std::is_nothrow_move_constructible_v<PSPresentationContext>);
+
+void
+test_presentation_pool()
+{
+  std::cout << "****test_presentation_pool Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  idp.el_passo_provide_id(request, "hello", sig);
+  auto ubld_sig = user.unblind_credential(sig);
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  PSVerifier rp(pubKey);
+
+  // a consumed context cannot be used again
+  auto context = user.el_passo_prepare_prove_id_without_id_retrieval(ubld_sig, attributes);
+  auto proof = user.el_passo_prove_id_online(std::move(context), "hello", "service");
+  if (!context.empty() || !rp.el_passo_verify_id_without_id_retrieval(proof, "hello", "service")) {
+    std::cout << "online ProveID failed" << std::endl;
+    return;
+  }
+  try {
+    user.el_passo_prove_id_online(std::move(context), "hello", "service");
+    std::cout << "consumed context was used twice" << std::endl;
+    return;
+  }
+  catch (const std::runtime_error&) {
+  }
+  // a discarded context cannot be used either
+  auto discarded = user.el_passo_prepare_prove_id_without_id_retrieval(ubld_sig, attributes);
+  discarded.clear();
+  try {
+    user.el_passo_prove_id_online(std::move(discarded), "hello", "service");
+    std::cout << "cleared context was used" << std::endl;
+    return;
+  }
+  catch (const std::runtime_error&) {
+  }
+  // nor does a context that goes out of scope leave its secrets behind
+  alignas(PSPresentationContext) unsigned char storage[sizeof(PSPresentationContext)];
+  auto* scoped = new (storage) PSPresentationContext(user.el_passo_prepare_prove_id(ubld_sig, attributes,
+                                                                                    authority_pk, g, h));
+  std::vector<unsigned char> alive(storage, storage + sizeof(storage));
+  scoped->~PSPresentationContext();
+  if (std::equal(alive.begin(), alive.end(), storage)) {
+    std::cout << "destroyed context was not erased" << std::endl;
+    return;
+  }
+
+  PSThreadPool thread_pool(2);
+  PSPresentationPool pool(user, ubld_sig, attributes, authority_pk, g, h, 4, thread_pool);
+  pool.fill();
+  while (pool.readyNum() < 4) {
+    std::this_thread::yield();
+  }
+  for (size_t i = 0; i < 6; i++) {
+    auto begin = std::chrono::steady_clock::now();
+    auto pooled_proof = pool.prove("session" + std::to_string(i), "service" + std::to_string(i));
+    auto end = std::chrono::steady_clock::now();
+    if (i == 0) {
+      std::cout << "User-ProveID online: "
+                << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count()
+                << "[µs]" << std::endl;
+    }
+    if (!rp.el_passo_verify_id(pooled_proof, "session" + std::to_string(i), "service" + std::to_string(i), authority_pk, g, h)) {
+      std::cout << "pooled ProveID " << i << " failed" << std::endl;
+      return;
+    }
+  }
+  std::cout << "****test_presentation_pool ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_requester_tables()
+{
+  std::cout << "****test_requester_tables Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(4, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("sk", true));
+  attributes.push_back(std::make_tuple("tp", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  idp.el_passo_provide_id(request, "hello", sig);
+  auto ubld_sig = user.unblind_credential(sig);
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  PSVerifier rp(pubKey);
+
+  // the same randomness must give the same proof with and without tables
+  PSRequester table_user(pubKey);
+  table_user.precompute();
+  PSRandom::setDeterministicSeed("requester-tables");
+  auto proof1 = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("requester-tables");
+  auto proof2 = table_user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("");
+  if (proof1.toBufferString() != proof2.toBufferString()) {
+    std::cout << "ProveID with tables differs from ProveID without tables" << std::endl;
+    return;
+  }
+  if (!rp.el_passo_verify_id(proof2, "hello", "service", authority_pk, g, h)) {
+    std::cout << "ProveID with tables failed" << std::endl;
+    return;
+  }
+  auto proof3 = table_user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, "hello", "service");
+  if (!rp.el_passo_verify_id_without_id_retrieval(proof3, "hello", "service")) {
+    std::cout << "ProveID without id retrieval with tables failed" << std::endl;
+    return;
+  }
+  std::cout << "****test_requester_tables ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_blinding_context()
+{
+  std::cout << "****test_blinding_context Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  const PSRequester user(pubKey);
+
+  // one requester with requests in flight from several threads
+  size_t session_num = 8;
+  std::vector<std::vector<std::string>> all_attributes(session_num);
+  std::vector<PSBlindingContext> contexts(session_num);
+  std::vector<PSCredRequest> requests(session_num);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < session_num; i++) {
+    all_attributes[i] = {"s" + std::to_string(i), "gamma" + std::to_string(i), "tp"};
+    threads.emplace_back([&, i] {
+      std::vector<std::tuple<std::string, bool>> attributes;
+      attributes.push_back(std::make_tuple(all_attributes[i][0], true));
+      attributes.push_back(std::make_tuple(all_attributes[i][1], true));
+      attributes.push_back(std::make_tuple(all_attributes[i][2], false));
+      requests[i] = user.el_passo_request_id(attributes, "session" + std::to_string(i), contexts[i]);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // credentials come back in any order
+  for (size_t i = session_num; i-- > 0;) {
+    PSCredential sig;
+    if (!idp.el_passo_provide_id(requests[i], "session" + std::to_string(i), sig)) {
+      std::cout << "request " << i << " failed" << std::endl;
+      return;
+    }
+    auto ubld_sig = user.unblind_credential(sig, contexts[i]);
+    if (!user.verify(ubld_sig, all_attributes[i])) {
+      std::cout << "credential " << i << " failed" << std::endl;
+      return;
+    }
+  }
+  try {
+    user.unblind_credential(PSCredential(), PSBlindingContext());
+    std::cout << "empty blinding context was used" << std::endl;
+    return;
+  }
+  catch (const std::runtime_error&) {
+  }
+  std::cout << "****test_blinding_context ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_attribute_views()
+{
+  std::cout << "****test_attribute_views Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  std::string s = "s", gamma = "gamma", tp = "tp";
+  PSAttributeView attributes[] = {{s, true}, {gamma, true}, {tp, false}};
+  PSBlindingContext context;
+  PSCredRequest request;
+  user.el_passo_request_id(attributes, 3, "hello", context, request);
+  PSCredential sig;
+  if (!idp.el_passo_provide_id(request, "hello", sig)) {
+    std::cout << "request with attribute views failed" << std::endl;
+    return;
+  }
+  auto ubld_sig = user.unblind_credential(sig, context);
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  PSVerifier rp(pubKey);
+
+  // one proof object reused, with and without the identity retrieval token
+  IdProof proof;
+  for (size_t i = 0; i < 4; i++) {
+    auto associated_data = "session" + std::to_string(i);
+    if (i % 2 == 0) {
+      user.el_passo_prove_id(ubld_sig, attributes, 3, associated_data, "service", authority_pk, g, h, proof);
+      if (!rp.el_passo_verify_id(proof, associated_data, "service", authority_pk, g, h)) {
+        std::cout << "ProveID with attribute views failed" << std::endl;
+        return;
+      }
+    }
+    else {
+      user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, 3, associated_data, "service", proof);
+      if (proof.E1.has_value() || !rp.el_passo_verify_id_without_id_retrieval(proof, associated_data, "service")) {
+        std::cout << "ProveID without id retrieval with attribute views failed" << std::endl;
+        return;
+      }
+    }
+    if (proof.attributes.size() != 3 || proof.attributes[0] != "" || proof.attributes[2] != "tp") {
+      std::cout << "ProveID with attribute views has wrong attributes" << std::endl;
+      return;
+    }
+  }
+  std::cout << "****test_attribute_views ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_wallet()
+{
+  std::cout << "****test_wallet Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  PSVerifier rp(pubKey);
+
+  PSWallet wallet(user);
+  std::vector<std::vector<std::tuple<std::string, bool>>> all_attributes;
+  std::vector<PSCredential> sigs;
+  for (size_t i = 0; i < 2; i++) {
+    std::vector<std::tuple<std::string, bool>> attributes;
+    attributes.push_back(std::make_tuple("s" + std::to_string(i), true));
+    attributes.push_back(std::make_tuple("gamma" + std::to_string(i), true));
+    attributes.push_back(std::make_tuple("tp", false));
+    auto request = user.el_passo_request_id(attributes, "hello");
+    PSCredential sig;
+    idp.el_passo_provide_id(request, "hello", sig);
+    sigs.push_back(user.unblind_credential(sig));
+    wallet.addCredential(sigs.back(), attributes);
+    all_attributes.push_back(attributes);
+  }
+
+  // the cached values must give the same proof as PSRequester
+  PSRandom::setDeterministicSeed("wallet");
+  auto proof1 = wallet.prove(1, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("wallet");
+  auto proof2 = user.el_passo_prove_id(sigs[1], all_attributes[1], "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("");
+  if (proof1.toBufferString() != proof2.toBufferString() ||
+      !rp.el_passo_verify_id(proof1, "hello", "service", authority_pk, g, h)) {
+    std::cout << "wallet ProveID failed" << std::endl;
+    return;
+  }
+  PSRequester table_user(pubKey);
+  table_user.precompute();
+  PSWallet table_wallet(table_user);
+  table_wallet.addCredential(sigs[1], all_attributes[1]);
+  PSRandom::setDeterministicSeed("wallet");
+  auto proof3 = table_wallet.prove(0, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("");
+  if (proof1.toBufferString() != proof3.toBufferString()) {
+    std::cout << "wallet ProveID with tables failed" << std::endl;
+    return;
+  }
+  for (size_t i = 0; i < 4; i++) {
+    auto service_name = "service" + std::to_string(i % 2);
+    auto proof = wallet.prove(i % 2, "session" + std::to_string(i), service_name);
+    if (!rp.el_passo_verify_id_without_id_retrieval(proof, "session" + std::to_string(i), service_name)) {
+      std::cout << "wallet ProveID without id retrieval failed" << std::endl;
+      return;
+    }
+  }
+  // one credential to many RPs at once, each proof randomized on its own
+  PSThreadPool thread_pool(4);
+  std::vector<std::pair<std::string, std::string>> requests;
+  for (size_t i = 0; i < 12; i++) {
+    requests.emplace_back("bulk-service" + std::to_string(i % 6), "session" + std::to_string(i));
+  }
+  auto proofs = wallet.proveBulk(0, requests, authority_pk, g, h, thread_pool);
+  for (size_t i = 0; i < proofs.size(); i++) {
+    if (!rp.el_passo_verify_id(proofs[i], std::get<1>(requests[i]), std::get<0>(requests[i]), authority_pk, g, h)) {
+      std::cout << "bulk ProveID " << i << " failed" << std::endl;
+      return;
+    }
+    for (size_t j = 0; j < i; j++) {
+      if (proofs[i].sig1 == proofs[j].sig1 || proofs[i].k == proofs[j].k ||
+          (proofs[i].phi == proofs[j].phi) != (i % 6 == j % 6)) {
+        std::cout << "bulk ProveID " << i << " is linked to " << j << std::endl;
+        return;
+      }
+    }
+  }
+  // more service names than the wallet caches: the least recently used ones are evicted and hashed again
+  std::vector<std::pair<std::string, std::string>> many_requests;
+  for (size_t i = 0; i < PSWallet::SERVICE_HASH_CAPACITY + 4; i++) {
+    many_requests.emplace_back("many-service" + std::to_string(i), "session");
+  }
+  auto many_proofs = wallet.proveBulk(0, many_requests, thread_pool);
+  for (size_t i : {size_t(0), many_requests.size() - 1}) {
+    if (!rp.el_passo_verify_id_without_id_retrieval(many_proofs[i], "session", std::get<0>(many_requests[i]))) {
+      std::cout << "bulk ProveID beyond the service hash capacity failed" << std::endl;
+      return;
+    }
+  }
+  auto evicted = wallet.prove(0, "session", "many-service0");
+  if (!rp.el_passo_verify_id_without_id_retrieval(evicted, "session", "many-service0")) {
+    std::cout << "wallet ProveID with an evicted service hash failed" << std::endl;
+    return;
+  }
+  try {
+    wallet.prove(2, "hello", "service");
+    std::cout << "wallet proved with a missing credential" << std::endl;
+    return;
+  }
+  catch (const std::runtime_error&) {
+  }
+  std::cout << "****test_wallet ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_intra_op_parallelism()
+{
+  std::cout << "****test_intra_op_parallelism Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(40, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+
+  // enough hidden and plaintext attributes for single proofs and verifications to be split
+  std::vector<std::tuple<std::string, bool>> attributes;
+  for (size_t i = 0; i < 40; i++) {
+    attributes.push_back(std::make_tuple("attr" + std::to_string(i), i < 20));
+  }
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  idp.el_passo_provide_id(request, "hello", sig);
+  auto ubld_sig = user.unblind_credential(sig);
+
+  PSThreadPool thread_pool(4);
+  PSRequester pooled_user(pubKey);
+  pooled_user.use_thread_pool(&thread_pool);
+  PSRandom::setDeterministicSeed("parallel");
+  auto proof1 = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("parallel");
+  auto proof2 = pooled_user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("");
+  if (proof1.toBufferString() != proof2.toBufferString()) {
+    std::cout << "ProveID on a thread pool gave a different proof" << std::endl;
+    return;
+  }
+  pooled_user.precompute();
+  PSRandom::setDeterministicSeed("parallel");
+  auto proof3 = pooled_user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("");
+  if (proof1.toBufferString() != proof3.toBufferString()) {
+    std::cout << "ProveID with tables on a thread pool gave a different proof" << std::endl;
+    return;
+  }
+
+  PSVerifier rp(pubKey);
+  rp.use_thread_pool(&thread_pool);
+  if (!rp.el_passo_verify_id(proof2, "hello", "service", authority_pk, g, h)) {
+    std::cout << "VerifyID on a thread pool failed" << std::endl;
+    return;
+  }
+  if (rp.el_passo_verify_id(proof2, "hello", "other-service", authority_pk, g, h)) {
+    std::cout << "VerifyID on a thread pool accepted a wrong service" << std::endl;
+    return;
+  }
+  auto proof4 = pooled_user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, "hello", "service");
+  if (!rp.el_passo_verify_id_without_id_retrieval(proof4, "hello", "service")) {
+    std::cout << "VerifyID without id retrieval on a thread pool failed" << std::endl;
+    return;
+  }
+  proof4.attributes[39] = "tampered";
+  if (rp.el_passo_verify_id_without_id_retrieval(proof4, "hello", "service")) {
+    std::cout << "VerifyID on a thread pool accepted a tampered attribute" << std::endl;
+    return;
+  }
+  std::cout << "****test_intra_op_parallelism ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_fixed_size()
+{
+  std::cout << "****test_fixed_size Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(5, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+
+  // s and gamma in slots 0 and 1 are committed, the rest are plaintext
+  constexpr uint64_t REQUEST_MASK = 0b00011;
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp1", false));
+  attributes.push_back(std::make_tuple("tp2", false));
+  attributes.push_back(std::make_tuple("tp3", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSSignerN<5> fixed_idp(idp);
+  auto fixed_request = PSCredRequestN<5, REQUEST_MASK>::fromCredRequest(request);
+  PSCredential sig;
+  if (!fixed_idp.el_passo_provide_id(fixed_request, "hello", sig)) {
+    std::cout << "fixed-size ProvideID failed" << std::endl;
+    return;
+  }
+  if (fixed_idp.el_passo_provide_id(fixed_request, "other", sig)) {
+    std::cout << "fixed-size ProvideID accepted wrong associated data" << std::endl;
+    return;
+  }
+  auto ubld_sig = user.unblind_credential(sig);
+  if (!user.verify(ubld_sig, {"s", "gamma", "tp1", "tp2", "tp3"})) {
+    std::cout << "fixed-size credential failed" << std::endl;
+    return;
+  }
+
+  // the RP also learns nothing about slot 3
+  constexpr uint64_t PROOF_MASK = 0b01011;
+  std::get<1>(attributes[3]) = true;
+  PSVerifier rp(pubKey);
+  PSVerifierN<5> fixed_rp(pubKey);
+  auto proof = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  auto fixed_proof = IdProofN<5, PROOF_MASK>::fromIdProof(proof);
+  if (!fixed_rp.el_passo_verify_id(fixed_proof, "hello", "service", authority_pk, g, h) ||
+      fixed_rp.el_passo_verify_id(fixed_proof, "hello", "other-service", authority_pk, g, h) ||
+      !rp.el_passo_verify_id(fixed_proof.toIdProof(), "hello", "service", authority_pk, g, h)) {
+    std::cout << "fixed-size VerifyID failed" << std::endl;
+    return;
+  }
+  auto proof2 = user.el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, "hello", "service");
+  auto fixed_proof2 = IdProofN<5, PROOF_MASK>::fromIdProof(proof2);
+  if (!fixed_rp.el_passo_verify_id_without_id_retrieval(fixed_proof2, "hello", "service") ||
+      fixed_proof2.toIdProof().toBufferString() != proof2.toBufferString()) {
+    std::cout << "fixed-size VerifyID without id retrieval failed" << std::endl;
+    return;
+  }
+  fixed_proof2.attributes[4] = "tampered";
+  if (fixed_rp.el_passo_verify_id_without_id_retrieval(fixed_proof2, "hello", "service")) {
+    std::cout << "fixed-size VerifyID accepted a tampered attribute" << std::endl;
+    return;
+  }
+  // a proof hiding other slots does not fit the type
+  try {
+    IdProofN<5, REQUEST_MASK>::fromIdProof(proof);
+    std::cout << "fixed-size proof accepted a different layout" << std::endl;
+    return;
+  }
+  catch (const std::runtime_error&) {
+  }
+  std::cout << "****test_fixed_size ends without errors****\n"
+            << std::endl;
+}
+
+void
+test_instrumentation()
+{
+  std::cout << "****test_instrumentation Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  PSVerifier rp(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp", false));
+
+  PSInstrumentation::reset();
+  auto request = user.el_passo_request_id(attributes, "hello");
+  auto buffer = request.toBufferString();
+  request = PSCredRequest::fromBufferString(buffer);
+  PSCredential sig;
+  if (!idp.el_passo_provide_id(request, "hello", sig)) {
+    std::cout << "ProvideID failed" << std::endl;
+    return;
+  }
+  auto ubld_sig = user.unblind_credential(sig);
+  if (!rp.verify(ubld_sig, {"s", "gamma", "tp"})) {
+    std::cout << "credential verification failed" << std::endl;
+    return;
+  }
+
+  auto snapshot = PSInstrumentation::snapshot();
+  auto count = [&](PSComponent component, PSPhase phase) {
+    return snapshot.calls[static_cast<size_t>(component)][static_cast<size_t>(phase)];
+  };
+  if (!PSInstrumentation::ENABLED) {
+    // nothing is recorded without PS_ENABLE_INSTRUMENTATION
+    for (size_t c = 0; c < PSInstrumentation::COMPONENT_NUM; c++) {
+      for (size_t p = 0; p < PSInstrumentation::PHASE_NUM; p++) {
+        if (snapshot.calls[c][p] != 0 || snapshot.nanoseconds[c][p] != 0) {
+          std::cout << "disabled instrumentation recorded a phase" << std::endl;
+          return;
+        }
+      }
+    }
+  }
+  else if (count(PSComponent::REQUESTER, PSPhase::TRANSCRIPT) != 1 ||
+           count(PSComponent::SIGNER, PSPhase::TRANSCRIPT) != 1 ||
+           count(PSComponent::VERIFIER, PSPhase::PAIRING) != 1 ||
+           count(PSComponent::BUFFER, PSPhase::ENCODE) != 1 ||
+           count(PSComponent::BUFFER, PSPhase::DECODE) != 1 ||
+           count(PSComponent::SIGNER, PSPhase::HASH) == 0) {
+    std::cout << "unexpected phase counts" << std::endl;
+    return;
+  }
+  std::string metrics = snapshot.toPrometheus();
+  if (metrics.find("ps_phase_calls_total{component=\"verifier\",phase=\"pairing\"} " +
+                   std::to_string(count(PSComponent::VERIFIER, PSPhase::PAIRING)) + "\n") == std::string::npos ||
+      metrics.find("# TYPE ps_phase_seconds_total counter") == std::string::npos) {
+    std::cout << "unexpected Prometheus output" << std::endl;
+    return;
+  }
+
+  // counts of exited threads are kept
+  PSInstrumentation::reset();
+  std::thread([&] { rp.verify(ubld_sig, {"s", "gamma", "tp"}); }).join();
+  if (PSInstrumentation::ENABLED &&
+      PSInstrumentation::snapshot().calls[static_cast<size_t>(PSComponent::VERIFIER)][static_cast<size_t>(PSPhase::PAIRING)] != 1) {
+    std::cout << "phases of an exited thread were lost" << std::endl;
+    return;
+  }
+  std::cout << "****test_instrumentation ends without errors****\n" << std::endl;
+}
+
+void
+test_tracing()
+{
+  std::cout << "****test_tracing Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  PSVerifier rp(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  idp.el_passo_provide_id(request, "hello", sig);
+  auto ubld_sig = user.unblind_credential(sig);
+
+  // nothing is sampled by default
+  PSTracer::clear();
+  auto proof = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  if (!rp.el_passo_verify_id(proof, "hello", "service", authority_pk, g, h) || PSTracer::eventNum() != 0) {
+    std::cout << "unsampled run failed or was traced" << std::endl;
+    return;
+  }
+
+  PSTracer::setSampleRate(1);
+  if (!rp.el_passo_verify_id(proof, "hello", "service", authority_pk, g, h)) {
+    std::cout << "sampled verification failed" << std::endl;
+    return;
+  }
+  PSTracer::setSampleRate(0);
+  std::string json = PSTracer::toChromeJson();
+  if (!PSInstrumentation::ENABLED) {
+    if (PSTracer::eventNum() != 0) {
+      std::cout << "tracing recorded spans without instrumentation" << std::endl;
+      return;
+    }
+  }
+  else if (json.find("{\"name\":\"el_passo_verify_id\",\"cat\":\"el_passo\",\"ph\":\"X\"") == std::string::npos ||
+           json.find("{\"name\":\"pairing\",\"cat\":\"verifier\"") == std::string::npos ||
+           json.find("{\"name\":\"transcript\",\"cat\":\"verifier\"") == std::string::npos) {
+    std::cout << "unexpected trace: " << json << std::endl;
+    return;
+  }
+  char path[] = "/tmp/ps-trace-XXXXXX";
+  int fd = mkstemp(path);
+  close(fd);
+  PSTracer::writeChromeJson(path);
+  std::ifstream file(path);
+  std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  unlink(path);
+  if (written != json || PSTracer::eventNum() != 0) {
+    std::cout << "trace file does not match" << std::endl;
+    return;
+  }
+  std::cout << "****test_tracing ends without errors****\n" << std::endl;
+}
+
+void
+test_corpus()
+{
+  std::cout << "****test_corpus Start****" << std::endl;
+  char key_prefix[] = "/tmp/ps-corpus-XXXXXX";
+  int fd = mkstemp(key_prefix);
+  close(fd);
+  PSCorpusOptions options;
+  options.attribute_nums = {3, 6};
+  options.hidden_ratios = {0.5, 1};
+  options.kinds = {PSCorpusKind::REQUEST, PSCorpusKind::CREDENTIAL, PSCorpusKind::PROOF,
+                   PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL};
+  options.record_num = 6;
+  options.invalid_ratio = 0.5;
+  options.key_prefix = key_prefix;
+
+  // the same options give the same bytes
+  std::ostringstream first, second;
+  PSCorpus::generate(options, first);
+  PSCorpus::generate(options, second);
+  if (first.str() != second.str()) {
+    std::cout << "corpus is not reproducible" << std::endl;
+    return;
+  }
+  std::ofstream(key_prefix, std::ios::binary) << first.str();
+
+  // every record verifies as it is labeled
+  PSCorpusReader reader(key_prefix);
+  PSCorpusRecord record;
+  G1 authority_pk, g, h;
+  std::shared_ptr<PSVerifier> rp;
+  std::shared_ptr<PSSigner> idp;
+  size_t record_num = 0, invalid_num = 0;
+  while (reader.next(record)) {
+    if (record.kind == PSCorpusKind::AUTHORITY) {
+      size_t offset = record.object.parseG1Element(0, authority_pk);
+      offset += record.object.parseG1Element(offset, g);
+      record.object.parseG1Element(offset, h);
+      continue;
+    }
+    if (record.kind == PSCorpusKind::PUBKEY) {
+      auto pk = PSPubKey::fromBufferString(record.object);
+      rp = std::make_shared<PSVerifier>(pk);
+      idp = std::make_shared<PSSigner>(std::string(key_prefix) + "-" + std::to_string(pk.YYi.size()) + ".key");
+      continue;
+    }
+    bool valid = false;
+    try {
+      if (record.kind == PSCorpusKind::REQUEST) {
+        G1 commitment;
+        valid = idp->el_passo_verify_request(PSCredRequest::fromBufferString(record.object), record.context[0],
+                                             commitment);
+      }
+      else if (record.kind == PSCorpusKind::CREDENTIAL) {
+        valid = rp->verify(PSCredential::fromBufferString(record.object), record.context);
+      }
+      else if (record.kind == PSCorpusKind::PROOF) {
+        valid = rp->el_passo_verify_id(IdProof::fromBufferString(record.object), record.context[0],
+                                       record.context[1], authority_pk, g, h);
+      }
+      else {
+        valid = rp->el_passo_verify_id_without_id_retrieval(IdProof::fromBufferString(record.object),
+                                                            record.context[0], record.context[1]);
+      }
+    }
+    catch (const std::exception&) {
+      valid = false;
+    }
+    if (valid != record.expectedValid()) {
+      std::cout << PSCorpus::kindName(record.kind) << " record " << record_num << " with corruption "
+                << PSCorpus::corruptionName(record.corruption) << " verified as " << valid << std::endl;
+      return;
+    }
+    record_num++;
+    invalid_num += !valid;
+  }
+  unlink(key_prefix);
+  unlink((std::string(key_prefix) + "-3.key").c_str());
+  unlink((std::string(key_prefix) + "-6.key").c_str());
+  if (record_num != 2 * 2 * 4 * 6 || invalid_num == 0 || invalid_num == record_num) {
+    std::cout << "unexpected corpus size " << record_num << " with " << invalid_num << " invalid" << std::endl;
+    return;
+  }
+  std::cout << "****test_corpus ends without errors****\n" << std::endl;
+}
+
+void
+test_reverify()
+{
+  std::cout << "****test_reverify Start****" << std::endl;
+  PSCorpusOptions corpus;
+  corpus.attribute_nums = {4, 7};
+  corpus.kinds = {PSCorpusKind::PROOF, PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL, PSCorpusKind::CREDENTIAL};
+  corpus.record_num = 20;
+  corpus.invalid_ratio = 0.3;
+  char path[] = "/tmp/ps-archive-XXXXXX";
+  int fd = mkstemp(path);
+  close(fd);
+  {
+    std::ofstream out(path, std::ios::binary);
+    PSCorpus::generate(corpus, out);
+  }
+
+  // the verdicts are the same, in archive order, however the archive is split
+  std::vector<std::string> all_results;
+  for (size_t thread_num : {1, 3}) {
+    for (size_t batch_size : {1, 7, 64}) {
+      PSReverifyOptions options;
+      options.thread_num = thread_num;
+      options.batch_size = batch_size;
+      options.batches_in_flight = thread_num;
+      options.precompute = batch_size != 1;
+      std::ostringstream results;
+      auto report = PSReverifier::run(path, results, options);
+      if (report.proof_num != 2 * 2 * 20 || report.mislabeled_num != 0 || report.invalid_num == 0 ||
+          report.malformed_num == 0 || report.valid_num + report.invalid_num + report.malformed_num != report.proof_num) {
+        std::cout << "unexpected report with " << thread_num << " threads, batches of " << batch_size << ": "
+                  << report.valid_num << " valid, " << report.invalid_num << " invalid, " << report.malformed_num
+                  << " malformed, " << report.mislabeled_num << " mislabeled" << std::endl;
+        unlink(path);
+        return;
+      }
+      all_results.push_back(results.str());
+    }
+  }
+  PSCorpusReader reader(path);
+  PSCorpusRecord record;
+  std::string expected = all_results[0].substr(0, 12);
+  while (reader.next(record)) {
+    if (record.kind == PSCorpusKind::PROOF || record.kind == PSCorpusKind::PROOF_WITHOUT_ID_RETRIEVAL) {
+      auto verdict = record.corruption == PSCorruption::NONE        ? PSVerdict::VALID
+                     : record.corruption == PSCorruption::TRUNCATED ? PSVerdict::MALFORMED
+                                                                    : PSVerdict::INVALID;
+      expected.push_back(static_cast<char>(verdict));
+    }
+  }
+  unlink(path);
+  if (all_results[0].compare(0, 8, "PSVERDCT") != 0) {
+    std::cout << "results do not start with the magic" << std::endl;
+    return;
+  }
+  for (const auto& results : all_results) {
+    if (results != expected) {
+      std::cout << "verdicts are not in archive order" << std::endl;
+      return;
+    }
+  }
+  std::cout << "****test_reverify ends without errors****\n" << std::endl;
+}
+
+void
+test_authority_context()
+{
+  std::cout << "****test_authority_context Start****" << std::endl;
+  G1 g;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  G1 authority_pk, h;
+  hashAndMapToG1(authority_pk, "ghi");
+  hashAndMapToG1(h, "jkl");
+  PSSigner idp(4, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  PSVerifier rp(pubKey);
+  std::vector<std::tuple<std::string, bool>> attributes;
+  attributes.push_back(std::make_tuple("s", true));
+  attributes.push_back(std::make_tuple("gamma", true));
+  attributes.push_back(std::make_tuple("tp", false));
+  attributes.push_back(std::make_tuple("age", false));
+  auto request = user.el_passo_request_id(attributes, "hello");
+  PSCredential sig;
+  idp.el_passo_provide_id(request, "hello", sig);
+  auto ubld_sig = user.unblind_credential(sig);
+
+  PSAuthorityContext authority(authority_pk, g, h);
+  PSAuthorityContext tables = authority;
+  tables.precompute();
+  if (authority.precomputed() || !tables.precomputed() || !(tables.h() == h)) {
+    std::cout << "unexpected context state" << std::endl;
+    return;
+  }
+
+  // the tables give the same proof as the raw points
+  PSRandom::setDeterministicSeed("authority-seed");
+  auto proof = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", authority_pk, g, h);
+  PSRandom::setDeterministicSeed("authority-seed");
+  auto table_proof = user.el_passo_prove_id(ubld_sig, attributes, "hello", "service", tables);
+  PSRandom::setDeterministicSeed("");
+  if (proof.toBufferString() != table_proof.toBufferString()) {
+    std::cout << "proofs with and without tables differ" << std::endl;
+    return;
+  }
+  if (!rp.el_passo_verify_id(proof, "hello", "service", tables) ||
+      !rp.el_passo_verify_id(table_proof, "hello", "service", authority)) {
+    std::cout << "verification with a context failed" << std::endl;
+    return;
+  }
+
+  // a token for another authority or with a changed E2 is rejected
+  PSAuthorityContext other(h, g, authority_pk);
+  other.precompute();
+  auto tampered = table_proof;
+  G1::add(tampered.E2.value(), tampered.E2.value(), h);
+  std::vector<bool> verdicts;
+  rp.el_passo_verify_id_batch({table_proof, tampered}, {"hello", "hello"}, {"service", "service"}, tables, verdicts);
+  if (rp.el_passo_verify_id(table_proof, "hello", "service", other) || verdicts != std::vector<bool>{true, false}) {
+    std::cout << "invalid token accepted" << std::endl;
+    return;
+  }
+
+  // prepared presentations and wallets take the context too
+  PSThreadPool thread_pool(2);
+  PSPresentationPool pool(user, ubld_sig, attributes, tables, 2, thread_pool);
+  pool.fill();
+  PSWallet wallet(user);
+  wallet.addCredential(ubld_sig, attributes);
+  if (!rp.el_passo_verify_id(pool.prove("pool", "service"), "pool", "service", authority_pk, g, h) ||
+      !rp.el_passo_verify_id(wallet.prove(0, "wallet", "service", tables), "wallet", "service", tables)) {
+    std::cout << "prepared proof with a context failed" << std::endl;
+    return;
+  }
+  std::cout << "****test_authority_context ends without errors****\n" << std::endl;
+}
+
+void
+test_authority()
+{
+  std::cout << "****test_authority Start****" << std::endl;
+  G1 g, h;
+  G2 gg;
+  hashAndMapToG1(g, "abc");
+  hashAndMapToG2(gg, "edf");
+  hashAndMapToG1(h, "jkl");
+  PSThreadPool thread_pool(3);
+  PSAuthority authority(g, h);
+  authority.precompute();
+  std::vector<std::string> identities;
+  for (size_t i = 0; i < 100; i++) {
+    identities.push_back("user-" + std::to_string(i));
+  }
+  authority.enroll(identities, thread_pool);
+  authority.enroll({"late-user", "user-3", "late-user"}, thread_pool);
+  if (authority.enrolledNum() != 101) {
+    std::cout << "unexpected number of enrolled users" << std::endl;
+    return;
+  }
+
+  PSSigner idp(3, g, gg);
+  auto pubKey = idp.key_gen();
+  PSRequester user(pubKey);
+  PSVerifier rp(pubKey);
+  auto credential = [&](const std::string& identity) {
+    std::vector<std::tuple<std::string, bool>> attributes;
+    attributes.push_back(std::make_tuple("secret-of-" + identity, true));
+    attributes.push_back(std::make_tuple(identity, true));
+    attributes.push_back(std::make_tuple("tp", false));
+    auto request = user.el_passo_request_id(attributes, "hello");
+    PSCredential sig;
+    idp.el_passo_provide_id(request, "hello", sig);
+    return std::make_pair(user.unblind_credential(sig), attributes);
+  };
+
+  // the token of a verified proof leads back to its user
+  std::vector<IdProof> incident;
+  for (const std::string identity : {"user-42", "late-user", "stranger", "user-3"}) {
+    auto [sig, attributes] = credential(identity);
+    incident.push_back(user.el_passo_prove_id(sig, attributes, "hello", "service", authority.context()));
+    if (!rp.el_passo_verify_id(incident.back(), "hello", "service", authority.context())) {
+      std::cout << "proof for the authority failed" << std::endl;
+      return;
+    }
+  }
+  auto [sig, attributes] = credential("user-5");
+  incident.push_back(user.el_passo_prove_id_without_id_retrieval(sig, attributes, "hello", "service"));
+  Fr gamma;
+  gamma.setHashOf(std::string("user-42"));
+  G1 h_gamma;
+  G1::mul(h_gamma, h, gamma);
+  if (!(authority.decrypt(incident[0].E1.value(), incident[0].E2.value()) == h_gamma) ||
+      authority.identify(incident[0]) != std::optional<std::string>("user-42")) {
+    std::cout << "decryption failed" << std::endl;
+    return;
+  }
+  std::vector<std::optional<std::string>> expected = {"user-42", "late-user", std::nullopt, "user-3", std::nullopt};
+  if (authority.identifyBatch(incident, thread_pool) != expected) {
+    std::cout << "batch identification failed" << std::endl;
+    return;
+  }
+
+  // a restored authority decrypts the same tokens, another one does not
+  auto restored = PSAuthority::fromBufferString(authority.toBufferString());
+  restored.enroll(identities, thread_pool);
+  PSAuthority other(g, h);
+  other.enroll(identities, thread_pool);
+  if (restored.identify(incident[0]) != std::optional<std::string>("user-42") || other.identify(incident[0])) {
+    std::cout << "restored authority failed" << std::endl;
+    return;
+  }
+  std::cout << "****test_authority ends without errors****\n" << std::endl;
+}
+
 void
 test_el_passo(size_t total_attribute_num)
 {
@@ -139,7 +1448,27 @@ test_el_passo(size_t total_attribute_num)
 int
 main(int argc, char const *argv[])
 {
-  initPairing();
+  PSCurve::init();
   test_ps_sign_verify();
+  test_tampered_request();
+  test_ps_key_file();
+  test_parallel_key_gen();
+  test_shared_tables();
+  test_deterministic_randomness();
+  test_fork_randomness();
+  test_batch_verify_id();
+  test_presentation_pool();
+  test_requester_tables();
+  test_blinding_context();
+  test_attribute_views();
+  test_wallet();
+  test_intra_op_parallelism();
+  test_fixed_size();
+  test_instrumentation();
+  test_tracing();
+  test_corpus();
+  test_reverify();
+  test_authority_context();
+  test_authority();
   test_el_passo(3);
 }
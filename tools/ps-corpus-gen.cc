@@ -0,0 +1,115 @@
+#include "ps-daemon-util.h"
+#include <ps-corpus.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+/**
+ * ps-corpus-gen: write a reproducible corpus of valid and invalid requests, credentials and proofs.
+ *
+ * For each of --attributes, the corpus holds the public key and, for each of --hidden-ratios and
+ * --kinds, --records records, --invalid-ratio of them corrupted with one of --corruptions. The same
+ * options and --seed always produce the same file, so benchmarks and replays can stream it instead of
+ * generating proofs. With --save-key, the signer keys go to PREFIX-N.key, e.g., for ps-issuer --key to
+ * check the requests.
+ *
+ * Usage:
+ *   ps-corpus-gen --out FILE [--seed ps-corpus] [--attributes 8] [--hidden-ratios 0.25]
+ *                 [--kinds request,credential,proof] [--records 100] [--invalid-ratio 0.1]
+ *                 [--corruptions challenge,response,signature,attribute,context,truncated]
+ *                 [--attribute-size 16] [--save-key PREFIX]
+ */
+
+static std::vector<std::string>
+splitList(const std::string& list)
+{
+  std::vector<std::string> items;
+  for (size_t begin = 0; begin < list.size();) {
+    size_t end = std::min(list.find(',', begin), list.size());
+    items.push_back(list.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return items;
+}
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  try {
+    options = parseOptions(argc, argv);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (options.count("help") || !options.count("out")) {
+    std::cerr << "usage: ps-corpus-gen --out FILE [--seed ps-corpus] [--attributes 8] [--hidden-ratios 0.25]\n"
+              << "                     [--kinds request,credential,proof] [--records 100] [--invalid-ratio 0.1]\n"
+              << "                     [--corruptions challenge,response,signature,attribute,context,truncated]\n"
+              << "                     [--attribute-size 16] [--save-key PREFIX]" << std::endl;
+    return 1;
+  }
+
+  PSCorpusOptions corpus;
+  try {
+    corpus.seed = getOption(options, "seed", corpus.seed);
+    corpus.attribute_nums.clear();
+    for (const auto& item : splitList(getOption(options, "attributes", "8"))) {
+      corpus.attribute_nums.push_back(std::stoul(item));
+    }
+    corpus.hidden_ratios.clear();
+    for (const auto& item : splitList(getOption(options, "hidden-ratios", "0.25"))) {
+      corpus.hidden_ratios.push_back(std::stod(item));
+    }
+    corpus.kinds.clear();
+    for (const auto& item : splitList(getOption(options, "kinds", "request,credential,proof"))) {
+      corpus.kinds.push_back(PSCorpus::kindOf(item));
+    }
+    for (const auto& item : splitList(getOption(options, "corruptions", ""))) {
+      auto corruption = PSCorpus::corruptionOf(item);
+      if (corruption == PSCorruption::NUM) {
+        throw std::runtime_error("unknown corruption " + item);
+      }
+      corpus.corruptions.push_back(corruption);
+    }
+    corpus.record_num = std::stoul(getOption(options, "records", "100"));
+    corpus.invalid_ratio = std::stod(getOption(options, "invalid-ratio", "0.1"));
+    corpus.attribute_size = std::stoul(getOption(options, "attribute-size", "16"));
+    corpus.key_prefix = getOption(options, "save-key", "");
+
+    PSCurve::init();
+    std::ofstream out(options["out"], std::ios::binary);
+    if (!out) {
+      throw std::runtime_error("cannot open " + options["out"]);
+    }
+    PSCorpus::generate(corpus, out);
+    out.close();
+    if (!out) {
+      throw std::runtime_error("cannot write " + options["out"]);
+    }
+
+    // read the corpus back as a summary
+    size_t counts[size_t(PSCorpusKind::NUM)][size_t(PSCorruption::NUM)] = {};
+    PSCorpusReader reader(options["out"]);
+    PSCorpusRecord record;
+    while (reader.next(record)) {
+      counts[size_t(record.kind)][size_t(record.corruption)]++;
+    }
+    std::cout << "kind\tcorruption\trecords" << std::endl;
+    for (size_t k = 0; k < size_t(PSCorpusKind::NUM); k++) {
+      for (size_t c = 0; c < size_t(PSCorruption::NUM); c++) {
+        if (counts[k][c] != 0) {
+          std::cout << PSCorpus::kindName(PSCorpusKind(k)) << "\t" << PSCorpus::corruptionName(PSCorruption(c))
+                    << "\t" << counts[k][c] << std::endl;
+        }
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
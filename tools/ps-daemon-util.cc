@@ -0,0 +1,409 @@
+#include "ps-daemon-util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+static bool
+readAll(int fd, uint8_t* buf, size_t size)
+{
+  while (size > 0) {
+    ssize_t ret = read(fd, buf, size);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+    buf += ret;
+    size -= ret;
+  }
+  return true;
+}
+
+static bool
+writeAll(int fd, const uint8_t* buf, size_t size)
+{
+  while (size > 0) {
+    ssize_t ret = send(fd, buf, size, MSG_NOSIGNAL);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+    buf += ret;
+    size -= ret;
+  }
+  return true;
+}
+
+// writeAll() that gives up at @p deadline, waiting for the socket with poll() instead of blocking in send()
+static bool
+writeAllUntil(int fd, const uint8_t* buf, size_t size, std::chrono::steady_clock::time_point deadline)
+{
+  while (size > 0) {
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+    if (remaining.count() <= 0) {
+      return false;
+    }
+    pollfd _poll_fd = {fd, POLLOUT, 0};
+    int ready = poll(&_poll_fd, 1, remaining.count());
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready <= 0) {
+      return false;
+    }
+    ssize_t ret = send(fd, buf, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (ret < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+    buf += ret;
+    size -= ret;
+  }
+  return true;
+}
+
+bool
+readFrame(int fd, std::vector<uint8_t>& body)
+{
+  uint8_t length[4];
+  if (!readAll(fd, length, sizeof(length))) {
+    return false;
+  }
+  size_t size = (static_cast<size_t>(length[0]) << 24) | (length[1] << 16) | (length[2] << 8) | length[3];
+  if (size > PS_FRAME_MAX_SIZE) {
+    return false;
+  }
+  body.resize(size);
+  return readAll(fd, body.data(), size);
+}
+
+bool
+writeFrame(int fd, const std::vector<uint8_t>& body)
+{
+  std::vector<uint8_t> frame;
+  frame.reserve(body.size() + 4);
+  frame.push_back((body.size() >> 24) & 0xFF);
+  frame.push_back((body.size() >> 16) & 0xFF);
+  frame.push_back((body.size() >> 8) & 0xFF);
+  frame.push_back(body.size() & 0xFF);
+  frame.insert(frame.end(), body.begin(), body.end());
+  return writeAll(fd, frame.data(), frame.size());
+}
+
+bool
+writeFrame(int fd, const std::vector<uint8_t>& body, std::chrono::milliseconds timeout)
+{
+  std::vector<uint8_t> frame;
+  frame.reserve(body.size() + 4);
+  frame.push_back((body.size() >> 24) & 0xFF);
+  frame.push_back((body.size() >> 16) & 0xFF);
+  frame.push_back((body.size() >> 8) & 0xFF);
+  frame.push_back(body.size() & 0xFF);
+  frame.insert(frame.end(), body.begin(), body.end());
+  return writeAllUntil(fd, frame.data(), frame.size(), std::chrono::steady_clock::now() + timeout);
+}
+
+void
+appendFrameHeader(std::vector<uint8_t>& body, uint32_t request_id, uint8_t code)
+{
+  body.push_back((request_id >> 24) & 0xFF);
+  body.push_back((request_id >> 16) & 0xFF);
+  body.push_back((request_id >> 8) & 0xFF);
+  body.push_back(request_id & 0xFF);
+  body.push_back(code);
+}
+
+bool
+parseFrameHeader(const std::vector<uint8_t>& body, uint32_t& request_id, uint8_t& code)
+{
+  if (body.size() < PS_FRAME_HEADER_SIZE) {
+    return false;
+  }
+  request_id = (static_cast<uint32_t>(body[0]) << 24) | (body[1] << 16) | (body[2] << 8) | body[3];
+  code = body[4];
+  return true;
+}
+
+PSBuffer
+decodePayload(const std::vector<uint8_t>& body, uint8_t encoding)
+{
+  if (encoding == PS_FRAME_BASE64) {
+    return PSBuffer::fromBase64(std::string(body.begin() + PS_FRAME_HEADER_SIZE, body.end()));
+  }
+  PSBuffer payload;
+  payload.assign(body.begin() + PS_FRAME_HEADER_SIZE, body.end());
+  return payload;
+}
+
+void
+appendPayload(std::vector<uint8_t>& body, PSBuffer& payload, uint8_t encoding)
+{
+  if (encoding == PS_FRAME_BASE64) {
+    auto text = payload.toBase64();
+    body.insert(body.end(), text.begin(), text.end());
+  }
+  else {
+    body.insert(body.end(), payload.begin(), payload.end());
+  }
+}
+
+PSBuffer
+readFileBuffer(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  PSBuffer buffer;
+  buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  if (!file || buffer.empty()) {
+    throw std::runtime_error("cannot read " + path);
+  }
+  return buffer;
+}
+
+static sockaddr_un
+makeAddress(const std::string& path)
+{
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("socket path too long: " + path);
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size());
+  return addr;
+}
+
+int
+listenUnix(const std::string& path, mode_t mode)
+{
+  auto addr = makeAddress(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw std::runtime_error("cannot create socket");
+  }
+  unlink(path.c_str());
+  // bind() creates the file owner-only, and chmod() then grants exactly mode; called before other threads start
+  mode_t old_umask = umask(0177);
+  bool bound = bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+  umask(old_umask);
+  if (!bound || chmod(path.c_str(), mode) != 0 || listen(fd, 128) != 0) {
+    close(fd);
+    throw std::runtime_error("cannot listen on " + path);
+  }
+  return fd;
+}
+
+int
+connectUnix(const std::string& path)
+{
+  auto addr = makeAddress(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw std::runtime_error("cannot create socket");
+  }
+  if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+    close(fd);
+    throw std::runtime_error("cannot connect to " + path);
+  }
+  return fd;
+}
+
+std::map<std::string, std::string>
+parseOptions(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  for (int i = 1; i < argc; i++) {
+    std::string name = argv[i];
+    if (name.compare(0, 2, "--") != 0) {
+      throw std::runtime_error("unexpected argument " + name);
+    }
+    name = name.substr(2);
+    if (i + 1 < argc && std::string(argv[i + 1]).compare(0, 2, "--") != 0) {
+      options[name] = argv[++i];
+    }
+    else {
+      options[name] = "1";
+    }
+  }
+  return options;
+}
+
+std::string
+getOption(const std::map<std::string, std::string>& options, const std::string& name,
+          const std::string& default_value)
+{
+  auto it = options.find(name);
+  return it == options.end() ? default_value : it->second;
+}
+
+size_t
+getNumberOption(const std::map<std::string, std::string>& options, const std::string& name,
+                size_t default_value, int base)
+{
+  auto it = options.find(name);
+  if (it == options.end()) {
+    return default_value;
+  }
+  const auto& value = it->second;
+  size_t end = 0;
+  size_t number = 0;
+  try {
+    number = std::stoul(value, &end, base);
+  }
+  catch (const std::exception&) {
+    end = 0;
+  }
+  if (end == 0 || end != value.size() || value[0] == '-') {
+    throw std::runtime_error("invalid value for --" + name + ": " + value);
+  }
+  return number;
+}
+
+double
+getDoubleOption(const std::map<std::string, std::string>& options, const std::string& name,
+                double default_value)
+{
+  auto it = options.find(name);
+  if (it == options.end()) {
+    return default_value;
+  }
+  const auto& value = it->second;
+  size_t end = 0;
+  double number = 0;
+  try {
+    number = std::stod(value, &end);
+  }
+  catch (const std::exception&) {
+    end = 0;
+  }
+  if (end == 0 || end != value.size()) {
+    throw std::runtime_error("invalid value for --" + name + ": " + value);
+  }
+  return number;
+}
+
+double
+percentile(std::vector<double>& samples, double p)
+{
+  if (samples.empty()) {
+    return 0;
+  }
+  std::sort(samples.begin(), samples.end());
+  size_t index = static_cast<size_t>(p / 100 * (samples.size() - 1) + 0.5);
+  return samples[std::min(index, samples.size() - 1)];
+}
+
+void
+runLoadConnection(const std::string& socket_path, const std::vector<std::vector<uint8_t>>& payloads,
+                  uint8_t encoding, size_t request_num, size_t inflight_num, const PSLoadCheck& check,
+                  PSLoadResult& result)
+{
+  int fd = connectUnix(socket_path);
+  std::vector<std::chrono::steady_clock::time_point> sent_times(request_num);
+  std::atomic<size_t> sent_num{0};
+  std::mutex window_mutex;
+  std::condition_variable window_cv;
+  size_t received_num = 0;
+
+  std::thread writer([&] {
+    std::vector<uint8_t> body;
+    for (size_t i = 0; i < request_num; i++) {
+      {
+        std::unique_lock<std::mutex> lock(window_mutex);
+        window_cv.wait(lock, [&] { return i - received_num < inflight_num; });
+      }
+      const auto& payload = payloads[i % payloads.size()];
+      body.clear();
+      appendFrameHeader(body, static_cast<uint32_t>(i), encoding);
+      body.insert(body.end(), payload.begin(), payload.end());
+      sent_times[i] = std::chrono::steady_clock::now();
+      sent_num = i + 1;
+      if (!writeFrame(fd, body)) {
+        break;
+      }
+    }
+  });
+
+  std::vector<uint8_t> body;
+  while (received_num < request_num && readFrame(fd, body)) {
+    auto now = std::chrono::steady_clock::now();
+    uint32_t request_id;
+    uint8_t status;
+    if (!parseFrameHeader(body, request_id, status) || request_id >= sent_num) {
+      break;
+    }
+    result.latencies_us.push_back(std::chrono::duration<double, std::micro>(now - sent_times[request_id]).count());
+    bool ok = false;
+    try {
+      ok = check(request_id, status, decodePayload(body, encoding));
+    }
+    catch (const std::exception&) {
+    }
+    ok ? result.ok_num++ : result.failed_num++;
+    std::lock_guard<std::mutex> lock(window_mutex);
+    received_num++;
+    window_cv.notify_one();
+  }
+  // unblock the writer if the daemon went away
+  shutdown(fd, SHUT_RDWR);
+  {
+    std::lock_guard<std::mutex> lock(window_mutex);
+    received_num = request_num;
+    window_cv.notify_one();
+  }
+  writer.join();
+  close(fd);
+}
+
+bool
+runLoad(const std::string& socket_path, const std::vector<std::vector<uint8_t>>& payloads, uint8_t encoding,
+        size_t connection_num, size_t request_num, size_t inflight_num, const PSLoadCheck& check)
+{
+  std::vector<PSLoadResult> results(connection_num);
+  std::vector<std::thread> clients;
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < connection_num; i++) {
+    size_t share = request_num / connection_num + (i < request_num % connection_num ? 1 : 0);
+    clients.emplace_back([&, i, share] {
+      try {
+        runLoadConnection(socket_path, payloads, encoding, share, inflight_num, check, results[i]);
+      }
+      catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+  std::vector<double> latencies_us;
+  uint64_t ok_num = 0, failed_num = 0;
+  for (auto& result : results) {
+    latencies_us.insert(latencies_us.end(), result.latencies_us.begin(), result.latencies_us.end());
+    ok_num += result.ok_num;
+    failed_num += result.failed_num;
+  }
+  std::cout << "requests\tok\tfailed\tthroughput[req/s]\tp50[us]\tp99[us]\tmax[us]" << std::endl;
+  std::cout << latencies_us.size() << "\t" << ok_num << "\t" << failed_num << "\t" << latencies_us.size() / seconds
+            << "\t" << percentile(latencies_us, 50) << "\t" << percentile(latencies_us, 99) << "\t"
+            << percentile(latencies_us, 100) << std::endl;
+  return failed_num == 0 && latencies_us.size() == request_num;
+}
@@ -0,0 +1,238 @@
+#ifndef PS_TOOLS_PS_DAEMON_UTIL_H_
+#define PS_TOOLS_PS_DAEMON_UTIL_H_
+
+#include <ps-encoding.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * Helpers shared by the local daemons (ps-issuer, ps-verifierd) and their load generators.
+ *
+ * Frames on the UNIX stream socket are a 4-byte big-endian body length followed by the body.
+ * Request body:  u32 request id | u8 encoding | payload
+ * Response body: u32 request id | u8 status   | payload
+ * The encoding is PS_FRAME_BINARY (payload is a PSBuffer) or PS_FRAME_BASE64 (payload is the base64
+ * text of that PSBuffer); a response uses the encoding of its request. Responses on one connection
+ * can come back in any order and are matched by request id.
+ */
+static const uint8_t PS_FRAME_BINARY = 0;
+static const uint8_t PS_FRAME_BASE64 = 1;
+
+static const uint8_t PS_STATUS_OK = 0;
+static const uint8_t PS_STATUS_REJECTED = 1;   // well-formed, but the proof does not verify
+static const uint8_t PS_STATUS_MALFORMED = 2;  // the payload cannot be decoded
+
+static const size_t PS_FRAME_MAX_SIZE = 16 << 20;
+static const size_t PS_FRAME_HEADER_SIZE = 5;  // request id and encoding or status
+
+/**
+ * @brief Read one frame body. Returns false on end of stream, error, or oversized frame.
+ */
+bool
+readFrame(int fd, std::vector<uint8_t>& body);
+
+/**
+ * @brief Write one frame. Returns false on error.
+ */
+bool
+writeFrame(int fd, const std::vector<uint8_t>& body);
+
+/**
+ * @brief Write one frame within @p timeout, however slowly the peer reads. Returns false on error or
+ *        timeout, after which the stream may hold part of the frame.
+ */
+bool
+writeFrame(int fd, const std::vector<uint8_t>& body, std::chrono::milliseconds timeout);
+
+void
+appendFrameHeader(std::vector<uint8_t>& body, uint32_t request_id, uint8_t code);
+
+/**
+ * @brief Parse the request id and encoding or status. Returns false if the body is too short.
+ */
+bool
+parseFrameHeader(const std::vector<uint8_t>& body, uint32_t& request_id, uint8_t& code);
+
+/**
+ * @brief Decode the payload following the frame header.
+ */
+PSBuffer
+decodePayload(const std::vector<uint8_t>& body, uint8_t encoding);
+
+/**
+ * @brief Append @p payload to @p body in the given encoding.
+ */
+void
+appendPayload(std::vector<uint8_t>& body, PSBuffer& payload, uint8_t encoding);
+
+/**
+ * @brief Read a whole file, e.g., an encoded public key.
+ * @throw std::runtime_error if the file cannot be read or is empty.
+ */
+PSBuffer
+readFileBuffer(const std::string& path);
+
+/**
+ * @brief Create, bind and listen on a UNIX stream socket, replacing a stale socket file.
+ *
+ * The socket file gets permissions @p mode, by default only the owner may connect. It is never
+ * accessible to others in between, whatever the umask.
+ * @throw std::runtime_error on failure.
+ */
+int
+listenUnix(const std::string& path, mode_t mode = 0600);
+
+/**
+ * @throw std::runtime_error on failure.
+ */
+int
+connectUnix(const std::string& path);
+
+/**
+ * @brief Parse "--name value" pairs. A "--name" followed by another option or nothing maps to "1".
+ */
+std::map<std::string, std::string>
+parseOptions(int argc, char const* argv[]);
+
+std::string
+getOption(const std::map<std::string, std::string>& options, const std::string& name,
+          const std::string& default_value);
+
+/**
+ * @brief Option @p name as an unsigned number in @p base, e.g., 8 for a file mode.
+ * @throw std::runtime_error naming the option if the value is not a number.
+ */
+size_t
+getNumberOption(const std::map<std::string, std::string>& options, const std::string& name,
+                size_t default_value, int base = 10);
+
+/**
+ * @throw std::runtime_error naming the option if the value is not a number.
+ */
+double
+getDoubleOption(const std::map<std::string, std::string>& options, const std::string& name,
+                double default_value);
+
+/**
+ * @brief The @p p-th percentile (0 to 100) of @p samples, which get sorted.
+ */
+double
+percentile(std::vector<double>& samples, double p);
+
+struct PSLoadResult {
+  std::vector<double> latencies_us;
+  uint64_t ok_num = 0;
+  uint64_t failed_num = 0;
+};
+
+/**
+ * @brief Decide whether a response counts as a success, given its request id, status and decoded payload.
+ */
+using PSLoadCheck = std::function<bool(uint32_t request_id, uint8_t status, const PSBuffer& payload)>;
+
+/**
+ * @brief Send @p request_num requests on one connection, request i carrying payloads[i % payloads.size()]
+ *        (already in @p encoding), with up to @p inflight_num requests outstanding.
+ * @throw std::runtime_error if the connection cannot be made.
+ */
+void
+runLoadConnection(const std::string& socket_path, const std::vector<std::vector<uint8_t>>& payloads,
+                  uint8_t encoding, size_t request_num, size_t inflight_num, const PSLoadCheck& check,
+                  PSLoadResult& result);
+
+/**
+ * @brief Split @p request_num requests over @p connection_num connections, each on its own thread,
+ *        and print throughput and latency percentiles.
+ * @return true if every request got a response that passed @p check.
+ */
+bool
+runLoad(const std::string& socket_path, const std::vector<std::vector<uint8_t>>& payloads, uint8_t encoding,
+        size_t connection_num, size_t request_num, size_t inflight_num, const PSLoadCheck& check);
+
+/**
+ * @brief A bounded multi-producer multi-consumer queue between two pipeline stages.
+ */
+template<class T>
+class PSBoundedQueue {
+public:
+  explicit PSBoundedQueue(size_t capacity)
+      : m_capacity(capacity)
+  {
+  }
+
+  /**
+   * @brief Block while the queue is full. Returns false if the queue is closed.
+   */
+  bool
+  push(T item)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_full.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed) {
+      return false;
+    }
+    m_items.push_back(std::move(item));
+    m_not_empty.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Wait for at least one item, then keep collecting until @p max_num items are taken or
+   *        @p window has passed since the first one. Returns false once the queue is closed and empty.
+   */
+  bool
+  popBatch(std::vector<T>& batch, size_t max_num, std::chrono::microseconds window)
+  {
+    batch.clear();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_not_empty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+    auto deadline = std::chrono::steady_clock::now() + window;
+    while (batch.size() < max_num) {
+      while (!m_items.empty() && batch.size() < max_num) {
+        batch.push_back(std::move(m_items.front()));
+        m_items.pop_front();
+      }
+      m_not_full.notify_all();
+      if (batch.size() >= max_num || m_closed ||
+          !m_not_empty.wait_until(lock, deadline, [this] { return m_closed || !m_items.empty(); })) {
+        break;
+      }
+    }
+    return !batch.empty();
+  }
+
+  size_t
+  size()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_items.size();
+  }
+
+  void
+  close()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_not_empty.notify_all();
+    m_not_full.notify_all();
+  }
+
+private:
+  size_t m_capacity;
+  std::deque<T> m_items;
+  std::mutex m_mutex;
+  std::condition_variable m_not_empty;
+  std::condition_variable m_not_full;
+  bool m_closed = false;
+};
+
+#endif  // PS_TOOLS_PS_DAEMON_UTIL_H_
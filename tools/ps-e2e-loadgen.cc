@@ -0,0 +1,337 @@
+#include "ps-daemon-util.h"
+#include <ps-instrumentation.h>
+#include <ps-requester.h>
+#include <ps-signer.h>
+#include <ps-trace.h>
+#include <ps-verifier.h>
+
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace mcl::bls12;
+
+/**
+ * ps-e2e-loadgen: run the whole EL PASSO flow for many users in-process and report what each role costs.
+ *
+ * --users users are spread over --threads threads. Every user gets its own attributes and runs
+ * request_id -> provide_id -> unblind -> prove_id -> verify_id against one shared IdP, requester and RP.
+ * The first max(2, --hidden-ratio * --attributes) attributes are committed (s and gamma among them), and
+ * every attribute has --attribute-size bytes. --no-id-retrieval proves and verifies without the identity
+ * retrieval token.
+ *
+ * For each stage, the capacity is the throughput the threads would reach running only that stage:
+ * operations / (summed stage latency / threads). The IdP role is provide_id, the RP role verify_id, and
+ * the user role the other stages. --sweep repeats the run for 1, 2, 4, ... threads up to --threads to
+ * show how each role scales with cores. With --metrics, the per-phase counters of an instrumented build
+ * (make INSTRUMENTATION=1) are written to FILE in the Prometheus text format at the end. With --trace, the
+ * same builds sample --trace-sample of the protocol calls and write their spans to FILE as Chrome trace
+ * events.
+ *
+ * Usage:
+ *   ps-e2e-loadgen [--users 1000] [--threads <cores>] [--attributes 8] [--hidden-ratio 0.25]
+ *                  [--attribute-size 16] [--no-id-retrieval] [--precompute] [--sweep] [--metrics FILE]
+ *                  [--trace FILE] [--trace-sample 0.01]
+ */
+
+enum PSStage : size_t {
+  PS_STAGE_REQUEST_ID,
+  PS_STAGE_PROVIDE_ID,
+  PS_STAGE_UNBLIND,
+  PS_STAGE_PROVE_ID,
+  PS_STAGE_VERIFY_ID,
+  PS_STAGE_NUM
+};
+
+static const char* const STAGE_NAMES[PS_STAGE_NUM] = {"request_id", "provide_id", "unblind", "prove_id", "verify_id"};
+static const char* const STAGE_ROLES[PS_STAGE_NUM] = {"user", "idp", "user", "user", "rp"};
+
+// log2 buckets of the latency histogram, the last one collecting everything slower
+static const size_t HISTOGRAM_BUCKET_NUM = 24;
+
+struct PSFlowConfig {
+  size_t attribute_num;
+  size_t hidden_num;
+  size_t attribute_size;
+  bool id_retrieval;
+};
+
+struct PSFlowSamples {
+  std::vector<double> latencies_us[PS_STAGE_NUM];
+  uint64_t failed_num = 0;
+};
+
+struct PSFlowRun {
+  size_t thread_num;
+  double seconds;
+  PSFlowSamples samples;
+};
+
+class PSFlow {
+public:
+  PSFlow(const PSFlowConfig& config, bool precompute)
+      : m_config(config)
+      , m_idp(config.attribute_num)
+  {
+    auto pk = m_idp.key_gen();
+    m_user = std::make_unique<PSRequester>(pk);
+    m_rp = std::make_unique<PSVerifier>(pk);
+    G1 g, h, authority_pk;
+    hashAndMapToG1(g, "loadgen-g");
+    hashAndMapToG1(h, "loadgen-h");
+    hashAndMapToG1(authority_pk, "loadgen-authority");
+    m_authority = std::make_unique<PSAuthorityContext>(authority_pk, g, h);
+    if (precompute) {
+      m_idp.precompute();
+      m_user->precompute();
+      m_rp->precompute();
+      m_authority->precompute();
+    }
+  }
+
+  PSFlowRun
+  run(size_t user_num, size_t thread_num)
+  {
+    std::atomic<size_t> next_user(0);
+    std::vector<PSFlowSamples> thread_samples(thread_num);
+    std::vector<std::thread> threads;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < thread_num; t++) {
+      threads.emplace_back([&, t] {
+        for (size_t i = next_user++; i < user_num; i = next_user++) {
+          runUser(i, thread_samples[t]);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    PSFlowRun result;
+    result.thread_num = thread_num;
+    result.seconds = std::chrono::duration<double>(end - begin).count();
+    for (auto& samples : thread_samples) {
+      for (size_t stage = 0; stage < PS_STAGE_NUM; stage++) {
+        auto& latencies = result.samples.latencies_us[stage];
+        latencies.insert(latencies.end(), samples.latencies_us[stage].begin(), samples.latencies_us[stage].end());
+      }
+      result.samples.failed_num += samples.failed_num;
+    }
+    return result;
+  }
+
+private:
+  void
+  runUser(size_t user_index, PSFlowSamples& samples) const
+  {
+    std::vector<std::tuple<std::string, bool>> attributes;
+    for (size_t j = 0; j < m_config.attribute_num; j++) {
+      auto value = "u" + std::to_string(user_index) + "-a" + std::to_string(j) + "-";
+      value.resize(std::max(value.size(), m_config.attribute_size), 'x');
+      attributes.emplace_back(value, j < m_config.hidden_num);
+    }
+    auto associated_data = "session-" + std::to_string(user_index);
+    auto timed = [&](PSStage stage, auto f) {
+      auto begin = std::chrono::steady_clock::now();
+      f();
+      auto end = std::chrono::steady_clock::now();
+      samples.latencies_us[stage].push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+    };
+
+    PSBlindingContext context;
+    PSCredRequest request;
+    timed(PS_STAGE_REQUEST_ID, [&] { request = m_user->el_passo_request_id(attributes, associated_data, context); });
+    PSCredential sig;
+    bool issued = false;
+    timed(PS_STAGE_PROVIDE_ID, [&] { issued = m_idp.el_passo_provide_id(request, associated_data, sig); });
+    if (!issued) {
+      samples.failed_num++;
+      return;
+    }
+    PSCredential ubld_sig;
+    timed(PS_STAGE_UNBLIND, [&] { ubld_sig = m_user->unblind_credential(sig, context); });
+    IdProof proof;
+    timed(PS_STAGE_PROVE_ID, [&] {
+      proof = m_config.id_retrieval
+                ? m_user->el_passo_prove_id(ubld_sig, attributes, associated_data, "loadgen-rp", *m_authority)
+                : m_user->el_passo_prove_id_without_id_retrieval(ubld_sig, attributes, associated_data, "loadgen-rp");
+    });
+    bool verified = false;
+    timed(PS_STAGE_VERIFY_ID, [&] {
+      verified = m_config.id_retrieval
+                   ? m_rp->el_passo_verify_id(proof, associated_data, "loadgen-rp", *m_authority)
+                   : m_rp->el_passo_verify_id_without_id_retrieval(proof, associated_data, "loadgen-rp");
+    });
+    if (!verified) {
+      samples.failed_num++;
+    }
+  }
+
+private:
+  PSFlowConfig m_config;
+  PSSigner m_idp;
+  std::unique_ptr<PSRequester> m_user;
+  std::unique_ptr<PSVerifier> m_rp;
+  std::unique_ptr<PSAuthorityContext> m_authority;
+};
+
+// operations per second the run's threads sustain on the given stages alone
+static double
+capacityOf(const PSFlowRun& run, std::initializer_list<PSStage> stages)
+{
+  double busy_us = 0;
+  for (auto stage : stages) {
+    for (double latency : run.samples.latencies_us[stage]) {
+      busy_us += latency;
+    }
+  }
+  size_t op_num = run.samples.latencies_us[*stages.begin()].size();
+  return busy_us == 0 ? 0 : op_num * run.thread_num / (busy_us / 1e6);
+}
+
+static void
+printStages(PSFlowRun& run)
+{
+  std::cout << "stage\trole\tops\tcapacity[op/s]\tp50[µs]\tp99[µs]\tmax[µs]" << std::endl;
+  for (size_t stage = 0; stage < PS_STAGE_NUM; stage++) {
+    auto& latencies = run.samples.latencies_us[stage];
+    std::cout << STAGE_NAMES[stage] << "\t" << STAGE_ROLES[stage] << "\t" << latencies.size() << "\t"
+              << capacityOf(run, {static_cast<PSStage>(stage)}) << "\t" << percentile(latencies, 50) << "\t"
+              << percentile(latencies, 99) << "\t" << percentile(latencies, 100) << std::endl;
+  }
+
+  std::cout << "\nlatency histogram, operations per bucket" << std::endl;
+  std::cout << "<=[µs]";
+  for (size_t stage = 0; stage < PS_STAGE_NUM; stage++) {
+    std::cout << "\t" << STAGE_NAMES[stage];
+  }
+  std::cout << std::endl;
+  size_t counts[HISTOGRAM_BUCKET_NUM][PS_STAGE_NUM] = {};
+  for (size_t stage = 0; stage < PS_STAGE_NUM; stage++) {
+    for (double latency : run.samples.latencies_us[stage]) {
+      size_t bucket = latency < 1 ? 0 : static_cast<size_t>(std::ceil(std::log2(latency)));
+      counts[std::min(bucket, HISTOGRAM_BUCKET_NUM - 1)][stage]++;
+    }
+  }
+  for (size_t bucket = 0; bucket < HISTOGRAM_BUCKET_NUM; bucket++) {
+    size_t row_sum = 0;
+    for (size_t stage = 0; stage < PS_STAGE_NUM; stage++) {
+      row_sum += counts[bucket][stage];
+    }
+    if (row_sum == 0) {
+      continue;
+    }
+    if (bucket == HISTOGRAM_BUCKET_NUM - 1) {
+      std::cout << "inf";
+    }
+    else {
+      std::cout << (1ul << bucket);
+    }
+    for (size_t stage = 0; stage < PS_STAGE_NUM; stage++) {
+      std::cout << "\t" << counts[bucket][stage];
+    }
+    std::cout << std::endl;
+  }
+}
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  try {
+    options = parseOptions(argc, argv);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (options.count("help")) {
+    std::cerr << "usage: ps-e2e-loadgen [--users 1000] [--threads <cores>] [--attributes 8] [--hidden-ratio 0.25]\n"
+              << "                      [--attribute-size 16] [--no-id-retrieval] [--precompute] [--sweep]\n"
+              << "                      [--metrics FILE] [--trace FILE] [--trace-sample 0.01]" << std::endl;
+    return 1;
+  }
+  size_t core_num = std::max(1u, std::thread::hardware_concurrency());
+  size_t user_num = std::max(1ul, std::stoul(getOption(options, "users", "1000")));
+  size_t thread_num = std::max(1ul, std::stoul(getOption(options, "threads", std::to_string(core_num))));
+  PSFlowConfig config;
+  config.attribute_num = std::max(2ul, std::stoul(getOption(options, "attributes", "8")));
+  config.attribute_size = std::stoul(getOption(options, "attribute-size", "16"));
+  config.id_retrieval = options.count("no-id-retrieval") == 0;
+  double hidden_ratio = std::stod(getOption(options, "hidden-ratio", "0.25"));
+  config.hidden_num = std::min(config.attribute_num,
+                               std::max<size_t>(2, std::lround(hidden_ratio * config.attribute_num)));
+
+  if (options.count("trace")) {
+    PSTracer::setSampleRate(std::stod(getOption(options, "trace-sample", "0.01")));
+  }
+
+  PSCurve::init();
+  PSFlow flow(config, options.count("precompute") > 0);
+  std::cout << PSCurve::NAME << ", " << config.attribute_num << " attributes (" << config.hidden_num
+            << " committed), " << (config.id_retrieval ? "with" : "without") << " id retrieval, "
+            << user_num << " users" << std::endl;
+
+  bool ok = true;
+  if (options.count("sweep")) {
+    std::vector<size_t> thread_nums;
+    for (size_t t = 1; t < thread_num; t *= 2) {
+      thread_nums.push_back(t);
+    }
+    thread_nums.push_back(thread_num);
+    std::cout << "threads\tflows/s\tidp[op/s]\trp[op/s]\tuser[op/s]\tidp_speedup\trp_speedup\tuser_speedup" << std::endl;
+    double idp_base = 0, rp_base = 0, user_base = 0;
+    for (size_t t : thread_nums) {
+      auto run = flow.run(user_num, t);
+      ok &= run.samples.failed_num == 0;
+      double idp = capacityOf(run, {PS_STAGE_PROVIDE_ID});
+      double rp = capacityOf(run, {PS_STAGE_VERIFY_ID});
+      double user = capacityOf(run, {PS_STAGE_REQUEST_ID, PS_STAGE_UNBLIND, PS_STAGE_PROVE_ID});
+      if (t == 1) {
+        idp_base = idp;
+        rp_base = rp;
+        user_base = user;
+      }
+      std::cout << t << "\t" << user_num / run.seconds << "\t" << idp << "\t" << rp << "\t" << user << "\t"
+                << idp / idp_base << "\t" << rp / rp_base << "\t" << user / user_base << std::endl;
+    }
+  }
+  else {
+    auto run = flow.run(user_num, thread_num);
+    ok = run.samples.failed_num == 0;
+    std::cout << thread_num << " threads, " << user_num / run.seconds << " flows/s, "
+              << run.samples.failed_num << " failed\n" << std::endl;
+    printStages(run);
+  }
+  if (options.count("metrics")) {
+    if (!PSInstrumentation::ENABLED) {
+      std::cerr << "--metrics needs a build with INSTRUMENTATION=1, the counters are all zero" << std::endl;
+    }
+    std::ofstream metrics(options["metrics"]);
+    metrics << PSInstrumentation::snapshot().toPrometheus();
+    if (!metrics) {
+      std::cerr << "cannot write " << options["metrics"] << std::endl;
+      return 1;
+    }
+  }
+  if (options.count("trace")) {
+    if (!PSInstrumentation::ENABLED) {
+      std::cerr << "--trace needs a build with INSTRUMENTATION=1, the trace is empty" << std::endl;
+    }
+    try {
+      PSTracer::writeChromeJson(options["trace"]);
+    }
+    catch (const std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return 1;
+    }
+  }
+  if (!ok) {
+    std::cerr << "some flows failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
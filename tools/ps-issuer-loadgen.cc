@@ -0,0 +1,91 @@
+#include "ps-daemon-util.h"
+#include <ps-requester.h>
+
+#include <iostream>
+
+using namespace mcl::bls12;
+
+/**
+ * ps-issuer-loadgen: drive a local ps-issuer and report issuance throughput and latency.
+ *
+ * A pool of distinct requests is generated up front so that the measurement only covers the daemon.
+ * Each connection keeps up to --inflight requests outstanding and matches responses by request id.
+ * With --verify, every issued credential is unblinded and verified against the public key.
+ *
+ * Usage:
+ *   ps-issuer-loadgen --socket PATH --pubkey FILE [--connections 4] [--requests 10000]
+ *                     [--inflight 32] [--hidden 1] [--pool 64] [--base64] [--verify]
+ */
+
+struct PSLoadgenRequest {
+  PSBlindingContext context;
+  std::vector<std::string> attributes;
+};
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  try {
+    options = parseOptions(argc, argv);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  auto socket_path = getOption(options, "socket", "");
+  auto pk_path = getOption(options, "pubkey", "");
+  if (socket_path.empty() || pk_path.empty()) {
+    std::cerr << "usage: ps-issuer-loadgen --socket PATH --pubkey FILE [--connections 4] [--requests 10000]\n"
+              << "                         [--inflight 32] [--hidden 1] [--pool 64] [--base64] [--verify]" << std::endl;
+    return 1;
+  }
+  size_t connection_num = std::max(1ul, std::stoul(getOption(options, "connections", "4")));
+  size_t request_num = std::stoul(getOption(options, "requests", "10000"));
+  size_t inflight_num = std::max(1ul, std::stoul(getOption(options, "inflight", "32")));
+  size_t hidden_num = std::stoul(getOption(options, "hidden", "1"));
+  size_t pool_size = std::max(1ul, std::stoul(getOption(options, "pool", "64")));
+  uint8_t encoding = options.count("base64") ? PS_FRAME_BASE64 : PS_FRAME_BINARY;
+  bool verify = options.count("verify") > 0;
+
+  PSCurve::init();
+  PSPubKey pk;
+  try {
+    pk = PSPubKey::fromBufferString(readFileBuffer(pk_path));
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  size_t attribute_num = pk.Yi.size();
+  hidden_num = std::min(hidden_num, attribute_num);
+
+  PSRequester requester(pk);
+  std::vector<PSLoadgenRequest> pool(pool_size);
+  std::vector<std::vector<uint8_t>> payloads(pool_size);
+  for (size_t i = 0; i < pool_size; i++) {
+    auto& request = pool[i];
+    std::vector<std::tuple<std::string, bool>> attributes;
+    for (size_t j = 0; j < attribute_num; j++) {
+      request.attributes.push_back("attribute-" + std::to_string(i) + "-" + std::to_string(j));
+      attributes.emplace_back(request.attributes.back(), j < hidden_num);
+    }
+    std::string associated_data = "loadgen-" + std::to_string(i);
+    PSBuffer payload;
+    payload.appendStrList({associated_data});
+    auto cred_request = requester.el_passo_request_id(attributes, associated_data, request.context).toBufferString();
+    payload.insert(payload.end(), cred_request.begin(), cred_request.end());
+    appendPayload(payloads[i], payload, encoding);
+  }
+
+  bool ok = runLoad(socket_path, payloads, encoding, connection_num, request_num, inflight_num,
+                    [&](uint32_t request_id, uint8_t status, const PSBuffer& payload) {
+                      if (status != PS_STATUS_OK || !verify) {
+                        return status == PS_STATUS_OK;
+                      }
+                      const auto& request = pool[request_id % pool.size()];
+                      auto sig = requester.unblind_credential(PSCredential::fromBufferString(payload), request.context);
+                      return requester.verify(sig, request.attributes);
+                    });
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,326 @@
+#include "ps-daemon-util.h"
+#include <ps-signer.h>
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace mcl::bls12;
+
+/**
+ * ps-issuer: a local EL PASSO issuance daemon.
+ *
+ * Clients send PSCredRequest frames (see ps-daemon-util.h) whose payload is
+ *   StrList[associated_data] | PSCredRequest
+ * and get back a PSCredential (blinded, as returned by PSSigner::sign_commitment()) when the status
+ * is PS_STATUS_OK, or an empty payload otherwise.
+ *
+ * Each request goes through four stages, connected by bounded queues:
+ *   parse -> verify (PSSigner::el_passo_verify_request) -> sign (PSSigner::sign_commitment) -> encode
+ * Every stage takes up to --batch jobs at a time, waiting at most --window-us for a batch to fill,
+ * so a busy daemon hands jobs over in batches instead of one queue operation per request.
+ * Full queues block the previous stage, and eventually the connection readers.
+ *
+ * The socket only accepts connections from the daemon's user unless --socket-mode (octal) allows more.
+ *
+ * A response must be written within --write-timeout-ms. A client that does not read its responses in
+ * time is disconnected, so it holds up at most one of the --encode-workers for that long.
+ *
+ * Usage:
+ *   ps-issuer --socket PATH (--key FILE | --attributes N [--save-key FILE]) [--pubkey FILE]
+ *             [--precompute] [--batch 32] [--window-us 200] [--queue 1024]
+ *             [--verify-workers N] [--sign-workers N] [--encode-workers 2] [--write-timeout-ms 1000]
+ *             [--socket-mode 0600]
+ */
+
+struct PSIssuerConnection {
+  int fd;
+  std::mutex write_mutex;
+  bool broken = false;  // a write failed or timed out, guarded by write_mutex
+
+  ~PSIssuerConnection()
+  {
+    close(fd);
+  }
+};
+
+struct PSIssuerJob {
+  std::shared_ptr<PSIssuerConnection> connection;
+  uint32_t request_id = 0;
+  uint8_t encoding = PS_FRAME_BINARY;
+  uint8_t status = PS_STATUS_OK;
+  std::vector<uint8_t> frame;
+  PSCredRequest request;
+  std::string associated_data;
+  G1 commitment;
+  PSCredential sig;
+};
+
+using PSIssuerJobQueue = PSBoundedQueue<std::unique_ptr<PSIssuerJob>>;
+
+struct PSIssuerConfig {
+  size_t batch_size;
+  std::chrono::microseconds batch_window;
+  std::chrono::milliseconds write_timeout;
+};
+
+static std::atomic<bool> s_stopped{false};
+static int s_listen_fd = -1;
+
+static void
+handleSignal(int)
+{
+  s_stopped = true;
+  // wakes up accept(); shutdown() is async-signal-safe
+  shutdown(s_listen_fd, SHUT_RDWR);
+}
+
+// Run one pipeline stage: @p process handles a job and returns the queue of the next stage for it.
+static void
+runStage(PSIssuerJobQueue& in, const PSIssuerConfig& config,
+         const std::function<PSIssuerJobQueue&(PSIssuerJob&)>& process)
+{
+  std::vector<std::unique_ptr<PSIssuerJob>> batch;
+  while (in.popBatch(batch, config.batch_size, config.batch_window)) {
+    for (auto& job : batch) {
+      process(*job).push(std::move(job));
+    }
+  }
+}
+
+static void
+parseJob(PSIssuerJob& job)
+{
+  if (job.encoding != PS_FRAME_BINARY && job.encoding != PS_FRAME_BASE64) {
+    job.status = PS_STATUS_MALFORMED;
+    return;
+  }
+  auto payload = decodePayload(job.frame, job.encoding);
+  job.frame.clear();
+  try {
+    std::vector<std::string> _associated_data;
+    size_t step = payload.parseStrList(0, _associated_data);
+    if (step == 0 || _associated_data.size() != 1) {
+      job.status = PS_STATUS_MALFORMED;
+      return;
+    }
+    job.associated_data = std::move(_associated_data[0]);
+    payload.erase(payload.begin(), payload.begin() + step);
+    job.request = PSCredRequest::fromBufferString(payload);
+  }
+  catch (const std::exception&) {
+    job.status = PS_STATUS_MALFORMED;
+  }
+}
+
+static void
+encodeJob(PSIssuerJob& job, const PSIssuerConfig& config)
+{
+  std::vector<uint8_t> body;
+  appendFrameHeader(body, job.request_id, job.status);
+  if (job.status == PS_STATUS_OK) {
+    auto payload = job.sig.toBufferString();
+    appendPayload(body, payload, job.encoding);
+  }
+  auto& connection = *job.connection;
+  std::lock_guard<std::mutex> lock(connection.write_mutex);
+  if (connection.broken) {
+    return;
+  }
+  if (!writeFrame(connection.fd, body, config.write_timeout)) {
+    // the stream may end in a partial frame; disconnect, which also stops the reader
+    connection.broken = true;
+    shutdown(connection.fd, SHUT_RDWR);
+  }
+}
+
+static void
+readConnection(std::shared_ptr<PSIssuerConnection> connection, PSIssuerJobQueue& parse_queue)
+{
+  std::vector<uint8_t> frame;
+  while (readFrame(connection->fd, frame)) {
+    auto job = std::make_unique<PSIssuerJob>();
+    job->connection = connection;
+    if (!parseFrameHeader(frame, job->request_id, job->encoding)) {
+      break;
+    }
+    job->frame = std::move(frame);
+    if (!parse_queue.push(std::move(job))) {
+      break;
+    }
+  }
+}
+
+static void
+printUsage()
+{
+  std::cerr << "usage: ps-issuer --socket PATH (--key FILE | --attributes N [--save-key FILE]) [--pubkey FILE]\n"
+            << "                 [--precompute] [--batch 32] [--window-us 200] [--queue 1024]\n"
+            << "                 [--verify-workers N] [--sign-workers N] [--encode-workers 2] [--write-timeout-ms 1000]\n"
+            << "                 [--socket-mode 0600]" << std::endl;
+}
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  std::string socket_path, key_path;
+  size_t attribute_num;
+  PSIssuerConfig config;
+  size_t queue_size, verify_worker_num, sign_worker_num, encode_worker_num;
+  mode_t socket_mode;
+  try {
+    options = parseOptions(argc, argv);
+    socket_path = getOption(options, "socket", "");
+    key_path = getOption(options, "key", "");
+    attribute_num = getNumberOption(options, "attributes", 0);
+    size_t half_thread_num = std::max(1u, std::thread::hardware_concurrency() / 2);
+    config.batch_size = std::max<size_t>(1, getNumberOption(options, "batch", 32));
+    config.batch_window = std::chrono::microseconds(getNumberOption(options, "window-us", 200));
+    config.write_timeout = std::chrono::milliseconds(getNumberOption(options, "write-timeout-ms", 1000));
+    queue_size = std::max<size_t>(1, getNumberOption(options, "queue", 1024));
+    verify_worker_num = std::max<size_t>(1, getNumberOption(options, "verify-workers", half_thread_num));
+    sign_worker_num = std::max<size_t>(1, getNumberOption(options, "sign-workers", half_thread_num));
+    encode_worker_num = std::max<size_t>(1, getNumberOption(options, "encode-workers", 2));
+    socket_mode = getNumberOption(options, "socket-mode", 0600, 8);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    printUsage();
+    return 1;
+  }
+  if (socket_path.empty() || (key_path.empty() && attribute_num == 0)) {
+    printUsage();
+    return 1;
+  }
+
+  PSCurve::init();
+  std::unique_ptr<PSSigner> signer;
+  try {
+    if (!key_path.empty()) {
+      signer = std::make_unique<PSSigner>(key_path);
+    }
+    else {
+      signer = std::make_unique<PSSigner>(attribute_num);
+      PSThreadPool pool;
+      signer->key_gen(pool);
+    }
+    if (options.count("precompute")) {
+      signer->precompute();
+    }
+    if (options.count("save-key")) {
+      signer->save_key(options["save-key"]);
+    }
+    if (options.count("pubkey")) {
+      auto pk_buffer = signer->get_pub_key().toBufferString();
+      std::ofstream pk_file(options["pubkey"], std::ios::binary);
+      pk_file.write(reinterpret_cast<const char*>(pk_buffer.data()), pk_buffer.size());
+      if (!pk_file) {
+        throw std::runtime_error("cannot write the public key to " + options["pubkey"]);
+      }
+    }
+    s_listen_fd = listenUnix(socket_path, socket_mode);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  PSIssuerJobQueue parse_queue(queue_size), verify_queue(queue_size), sign_queue(queue_size), encode_queue(queue_size);
+  std::atomic<uint64_t> ok_num{0}, rejected_num{0}, malformed_num{0};
+
+  std::vector<std::thread> parse_workers, verify_workers, sign_workers, encode_workers;
+  parse_workers.emplace_back(runStage, std::ref(parse_queue), std::cref(config), [&](PSIssuerJob& job) -> PSIssuerJobQueue& {
+    parseJob(job);
+    return job.status == PS_STATUS_OK ? verify_queue : encode_queue;
+  });
+  for (size_t i = 0; i < verify_worker_num; i++) {
+    verify_workers.emplace_back(runStage, std::ref(verify_queue), std::cref(config), [&](PSIssuerJob& job) -> PSIssuerJobQueue& {
+      if (!signer->el_passo_verify_request(job.request, job.associated_data, job.commitment)) {
+        job.status = PS_STATUS_REJECTED;
+        return encode_queue;
+      }
+      return sign_queue;
+    });
+  }
+  for (size_t i = 0; i < sign_worker_num; i++) {
+    sign_workers.emplace_back(runStage, std::ref(sign_queue), std::cref(config), [&](PSIssuerJob& job) -> PSIssuerJobQueue& {
+      job.sig = signer->sign_commitment(job.commitment);
+      return encode_queue;
+    });
+  }
+  for (size_t i = 0; i < encode_worker_num; i++) {
+    encode_workers.emplace_back([&] {
+      std::vector<std::unique_ptr<PSIssuerJob>> batch;
+      while (encode_queue.popBatch(batch, config.batch_size, config.batch_window)) {
+        for (auto& job : batch) {
+          encodeJob(*job, config);
+          auto& counter = job->status == PS_STATUS_OK ? ok_num : (job->status == PS_STATUS_REJECTED ? rejected_num : malformed_num);
+          counter++;
+        }
+      }
+    });
+  }
+
+  struct sigaction action = {};
+  action.sa_handler = handleSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  std::cout << "ps-issuer: listening on " << socket_path << " with " << verify_worker_num << " verify and "
+            << sign_worker_num << " sign workers" << std::endl;
+
+  // connection readers are detached; the set tracks the live ones so that they can be stopped
+  std::mutex connections_mutex;
+  std::condition_variable connections_cv;
+  std::set<std::shared_ptr<PSIssuerConnection>> connections;
+  while (!s_stopped) {
+    int fd = accept(s_listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    auto connection = std::make_shared<PSIssuerConnection>();
+    connection->fd = fd;
+    {
+      std::lock_guard<std::mutex> lock(connections_mutex);
+      connections.insert(connection);
+    }
+    std::thread([&, connection] {
+      readConnection(connection, parse_queue);
+      std::lock_guard<std::mutex> lock(connections_mutex);
+      connections.erase(connection);
+      connections_cv.notify_all();
+    }).detach();
+  }
+
+  // stop reading, then drain the pipeline stage by stage
+  {
+    std::unique_lock<std::mutex> lock(connections_mutex);
+    for (const auto& connection : connections) {
+      shutdown(connection->fd, SHUT_RD);
+    }
+    connections_cv.wait(lock, [&] { return connections.empty(); });
+  }
+  std::vector<std::pair<PSIssuerJobQueue*, std::vector<std::thread>*>> stages = {
+      {&parse_queue, &parse_workers}, {&verify_queue, &verify_workers}, {&sign_queue, &sign_workers}, {&encode_queue, &encode_workers}};
+  for (auto& stage : stages) {
+    stage.first->close();
+    for (auto& worker : *stage.second) {
+      worker.join();
+    }
+  }
+  close(s_listen_fd);
+  unlink(socket_path.c_str());
+  std::cout << "ps-issuer: issued " << ok_num << ", rejected " << rejected_num << ", malformed " << malformed_num << std::endl;
+  return 0;
+}
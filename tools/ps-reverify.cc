@@ -0,0 +1,68 @@
+#include "ps-daemon-util.h"
+#include <ps-reverifier.h>
+
+#include <fstream>
+#include <iostream>
+
+/**
+ * ps-reverify: re-verify an archive of IdProofs, e.g., stored sign-on proofs for an audit.
+ *
+ * The archive is a corpus file (see PSCorpusWriter) of PROOF and PROOF_WITHOUT_ID_RETRIEVAL records,
+ * after the PUBKEY and AUTHORITY records they are verified with; ps-corpus-gen writes such files.
+ * Proofs are streamed from the memory-mapped archive in batches of --batch, each verified on one of
+ * --threads threads with a single batched pairing check, and one verdict byte per proof (0 invalid,
+ * 1 valid, 2 malformed) is written to --out in archive order. Memory use does not grow with the archive.
+ *
+ * Usage:
+ *   ps-reverify --archive FILE --out FILE [--threads 0] [--batch 64] [--in-flight 0] [--no-precompute]
+ */
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  try {
+    options = parseOptions(argc, argv);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  if (options.count("help") || !options.count("archive") || !options.count("out")) {
+    std::cerr << "usage: ps-reverify --archive FILE --out FILE [--threads 0] [--batch 64] [--in-flight 0]"
+              << " [--no-precompute]" << std::endl;
+    return 1;
+  }
+
+  try {
+    PSReverifyOptions reverify;
+    reverify.thread_num = std::stoul(getOption(options, "threads", "0"));
+    reverify.batch_size = std::stoul(getOption(options, "batch", "64"));
+    reverify.batches_in_flight = std::stoul(getOption(options, "in-flight", "0"));
+    reverify.precompute = !options.count("no-precompute");
+
+    PSCurve::init();
+    std::ofstream out(options["out"], std::ios::binary);
+    if (!out) {
+      throw std::runtime_error("cannot open " + options["out"]);
+    }
+    auto report = PSReverifier::run(options["archive"], out, reverify);
+    out.close();
+    if (!out) {
+      throw std::runtime_error("cannot write " + options["out"]);
+    }
+
+    std::cout << "proofs:     " << report.proof_num << std::endl
+              << "valid:      " << report.valid_num << std::endl
+              << "invalid:    " << report.invalid_num << std::endl
+              << "malformed:  " << report.malformed_num << std::endl
+              << "mislabeled: " << report.mislabeled_num << std::endl
+              << "seconds:    " << report.seconds << std::endl
+              << "proofs/s:   " << (report.seconds > 0 ? report.proof_num / report.seconds : 0) << std::endl;
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
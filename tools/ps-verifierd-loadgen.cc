@@ -0,0 +1,117 @@
+#include "ps-daemon-util.h"
+#include <ps-requester.h>
+#include <ps-signer.h>
+#include <ps-verifier.h>
+
+#include <iostream>
+
+using namespace mcl::bls12;
+
+/**
+ * ps-verifierd-loadgen: drive a local ps-verifierd and report verification throughput and latency.
+ *
+ * Credentials are issued locally with the signer key in --key (written by ps-issuer --save-key), and a
+ * pool of proofs for --service is generated up front. Every --invalid-every-th proof is sent with a
+ * wrong associated data and must be rejected; every other proof must be accepted with the pseudonym
+ * of its user. With --authority FILE (as for ps-verifierd), proofs carry an identity retrieval token.
+ *
+ * Usage:
+ *   ps-verifierd-loadgen --socket PATH --key FILE [--service NAME] [--authority FILE] [--connections 4]
+ *                        [--requests 10000] [--inflight 32] [--pool 64] [--invalid-every 0] [--base64]
+ */
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  try {
+    options = parseOptions(argc, argv);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  auto socket_path = getOption(options, "socket", "");
+  auto key_path = getOption(options, "key", "");
+  if (socket_path.empty() || key_path.empty()) {
+    std::cerr << "usage: ps-verifierd-loadgen --socket PATH --key FILE [--service NAME] [--authority FILE] [--connections 4]\n"
+              << "                            [--requests 10000] [--inflight 32] [--pool 64] [--invalid-every 0] [--base64]"
+              << std::endl;
+    return 1;
+  }
+  auto service_name = getOption(options, "service", "rp.example");
+  size_t connection_num = std::max(1ul, std::stoul(getOption(options, "connections", "4")));
+  size_t request_num = std::stoul(getOption(options, "requests", "10000"));
+  size_t inflight_num = std::max(1ul, std::stoul(getOption(options, "inflight", "32")));
+  size_t pool_size = std::max(1ul, std::stoul(getOption(options, "pool", "64")));
+  size_t invalid_every = std::stoul(getOption(options, "invalid-every", "0"));
+  uint8_t encoding = options.count("base64") ? PS_FRAME_BASE64 : PS_FRAME_BINARY;
+
+  PSCurve::init();
+  std::unique_ptr<PSSigner> signer;
+  std::vector<G1> authority;
+  try {
+    signer = std::make_unique<PSSigner>(key_path);
+    if (options.count("authority")) {
+      readFileBuffer(options["authority"]).parseG1List(0, authority);
+      if (authority.size() != 3) {
+        throw std::runtime_error("the authority file must hold authority_pk, g and h");
+      }
+    }
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+  auto pk = signer->get_pub_key();
+  size_t attribute_num = pk.Yi.size();
+  // s, and gamma when the identity retrieval token is needed, are committed
+  size_t hidden_num = authority.empty() ? 1 : 2;
+  if (attribute_num < hidden_num) {
+    std::cerr << "the key supports too few attributes" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> pseudonyms(pool_size);
+  std::vector<bool> expect_valid(pool_size);
+  std::vector<std::vector<uint8_t>> payloads(pool_size);
+  for (size_t i = 0; i < pool_size; i++) {
+    std::vector<std::tuple<std::string, bool>> attributes;
+    for (size_t j = 0; j < attribute_num; j++) {
+      attributes.emplace_back("attribute-" + std::to_string(i) + "-" + std::to_string(j), j < hidden_num);
+    }
+    PSRequester user(pk);
+    auto request = user.el_passo_request_id(attributes, "issue");
+    PSCredential sig;
+    if (!signer->el_passo_provide_id(request, "issue", sig)) {
+      std::cerr << "credential issuance failed" << std::endl;
+      return 1;
+    }
+    sig = user.unblind_credential(sig);
+    std::string associated_data = "session-" + std::to_string(i);
+    auto proof = authority.empty()
+                     ? user.el_passo_prove_id_without_id_retrieval(sig, attributes, associated_data, service_name)
+                     : user.el_passo_prove_id(sig, attributes, associated_data, service_name,
+                                              authority[0], authority[1], authority[2]);
+    pseudonyms[i] = PSVerifier::get_user_name_from_signon_request(proof);
+    expect_valid[i] = invalid_every == 0 || i % invalid_every != invalid_every - 1;
+
+    PSBuffer payload;
+    payload.appendStrList({expect_valid[i] ? associated_data : "other-" + associated_data, service_name});
+    auto proof_buffer = proof.toBufferString();
+    payload.insert(payload.end(), proof_buffer.begin(), proof_buffer.end());
+    appendPayload(payloads[i], payload, encoding);
+  }
+
+  bool ok = runLoad(socket_path, payloads, encoding, connection_num, request_num, inflight_num,
+                    [&](uint32_t request_id, uint8_t status, const PSBuffer& payload) {
+                      size_t i = request_id % pool_size;
+                      if (!expect_valid[i]) {
+                        return status == PS_STATUS_REJECTED;
+                      }
+                      std::vector<std::string> strs;
+                      return status == PS_STATUS_OK && payload.parseStrList(0, strs) > 0 &&
+                             strs.size() == 1 && strs[0] == pseudonyms[i];
+                    });
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,335 @@
+#include "ps-daemon-util.h"
+#include <ps-verifier.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <pthread.h>
+#include <set>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace mcl::bls12;
+
+/**
+ * ps-verifierd: a local EL PASSO verification daemon for RPs.
+ *
+ * Clients send IdProof frames (see ps-daemon-util.h) whose payload is
+ *   StrList[associated_data, service_name] | IdProof
+ * and get back PS_STATUS_OK with StrList[pseudonym] (PSVerifier::get_user_name_from_signon_request()),
+ * PS_STATUS_REJECTED with an empty payload, or PS_STATUS_MALFORMED.
+ * With --authority, proofs must carry an identity retrieval token for the authority public key and the
+ * g, h given in FILE (an encoded G1List of authority_pk, g, h).
+ * --precompute builds the fixed-base tables of the public key and, with --authority, of authority_pk, g, h.
+ *
+ * Every worker takes whatever is queued, up to the current batch limit, without waiting for more.
+ * Under low load that is a single proof, verified right away. Under high load proofs pile up and are
+ * verified together with PSVerifier::el_passo_verify_id_batch(). The batch limit follows the measured
+ * cost per proof so that verifying one batch takes about half of --latency-target-us, leaving the other
+ * half for queueing.
+ *
+ * The socket only accepts connections from the daemon's user unless --socket-mode (octal) allows more.
+ *
+ * A response must be written within --write-timeout-ms. A client that does not read its responses in
+ * time is disconnected and its later responses are dropped, so it cannot hold up the workers.
+ *
+ * Usage:
+ *   ps-verifierd --socket PATH --pubkey FILE [--authority FILE] [--precompute] [--workers N] [--pin]
+ *                [--latency-target-us 2000] [--max-batch 64] [--queue 4096] [--write-timeout-ms 1000]
+ *                [--socket-mode 0600]
+ */
+
+struct PSVerifierdConnection {
+  int fd;
+  std::mutex write_mutex;
+  bool broken = false;  // a write failed or timed out, guarded by write_mutex
+
+  ~PSVerifierdConnection()
+  {
+    close(fd);
+  }
+};
+
+struct PSVerifierdJob {
+  std::shared_ptr<PSVerifierdConnection> connection;
+  uint32_t request_id = 0;
+  uint8_t encoding = PS_FRAME_BINARY;
+  std::vector<uint8_t> frame;
+};
+
+using PSVerifierdJobQueue = PSBoundedQueue<std::unique_ptr<PSVerifierdJob>>;
+
+static std::atomic<bool> s_stopped{false};
+static int s_listen_fd = -1;
+
+static void
+handleSignal(int)
+{
+  s_stopped = true;
+  // wakes up accept(); shutdown() is async-signal-safe
+  shutdown(s_listen_fd, SHUT_RDWR);
+}
+
+static void
+respond(PSVerifierdJob& job, uint8_t status, PSBuffer& payload, std::chrono::milliseconds write_timeout)
+{
+  std::vector<uint8_t> body;
+  appendFrameHeader(body, job.request_id, status);
+  appendPayload(body, payload, job.encoding);
+  auto& connection = *job.connection;
+  std::lock_guard<std::mutex> lock(connection.write_mutex);
+  if (connection.broken) {
+    return;
+  }
+  if (!writeFrame(connection.fd, body, write_timeout)) {
+    // the stream may end in a partial frame; disconnect, which also stops the reader
+    connection.broken = true;
+    shutdown(connection.fd, SHUT_RDWR);
+  }
+}
+
+// Adapts the batch limit to the measured verification cost per proof.
+class PSBatchController {
+public:
+  PSBatchController(double latency_target_us, size_t max_batch_size)
+      : m_budget_us(latency_target_us / 2)
+      , m_max_batch_size(max_batch_size)
+      , m_limit(1)
+  {
+  }
+
+  size_t
+  limit() const
+  {
+    return m_limit;
+  }
+
+  void
+  record(size_t batch_size, double elapsed_us)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double cost_us = elapsed_us / batch_size;
+    m_cost_us = m_cost_us == 0 ? cost_us : 0.9 * m_cost_us + 0.1 * cost_us;
+    size_t limit = static_cast<size_t>(m_budget_us / m_cost_us);
+    m_limit = std::max<size_t>(1, std::min(limit, m_max_batch_size));
+  }
+
+private:
+  double m_budget_us;
+  size_t m_max_batch_size;
+  std::atomic<size_t> m_limit;
+  std::mutex m_mutex;
+  double m_cost_us = 0;  // moving average, guarded by m_mutex
+};
+
+static void
+runWorker(PSVerifierdJobQueue& queue, const PSVerifier& verifier, const PSAuthorityContext* authority,
+          PSBatchController& controller, std::chrono::milliseconds write_timeout)
+{
+  std::vector<std::unique_ptr<PSVerifierdJob>> batch, valid_jobs;
+  std::vector<IdProof> proofs;
+  std::vector<std::string> associated_data, service_names;
+  std::vector<bool> verdicts;
+  PSBuffer empty;
+  while (queue.popBatch(batch, controller.limit(), std::chrono::microseconds(0))) {
+    valid_jobs.clear();
+    proofs.clear();
+    associated_data.clear();
+    service_names.clear();
+    for (auto& job : batch) {
+      try {
+        if (job->encoding != PS_FRAME_BINARY && job->encoding != PS_FRAME_BASE64) {
+          throw std::runtime_error("unknown encoding");
+        }
+        auto payload = decodePayload(job->frame, job->encoding);
+        std::vector<std::string> strs;
+        size_t step = payload.parseStrList(0, strs);
+        if (step == 0 || strs.size() != 2) {
+          throw std::runtime_error("missing associated data or service name");
+        }
+        payload.erase(payload.begin(), payload.begin() + step);
+        proofs.push_back(IdProof::fromBufferString(payload));
+        associated_data.push_back(std::move(strs[0]));
+        service_names.push_back(std::move(strs[1]));
+        valid_jobs.push_back(std::move(job));
+      }
+      catch (const std::exception&) {
+        respond(*job, PS_STATUS_MALFORMED, empty, write_timeout);
+      }
+    }
+    if (valid_jobs.empty()) {
+      continue;
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    if (authority != nullptr) {
+      verifier.el_passo_verify_id_batch(proofs, associated_data, service_names, *authority, verdicts);
+    }
+    else {
+      verifier.el_passo_verify_id_batch_without_id_retrieval(proofs, associated_data, service_names, verdicts);
+    }
+    auto end = std::chrono::steady_clock::now();
+    controller.record(valid_jobs.size(), std::chrono::duration<double, std::micro>(end - begin).count());
+
+    for (size_t i = 0; i < valid_jobs.size(); i++) {
+      if (verdicts[i]) {
+        PSBuffer payload;
+        payload.appendStrList({PSVerifier::get_user_name_from_signon_request(proofs[i])});
+        respond(*valid_jobs[i], PS_STATUS_OK, payload, write_timeout);
+      }
+      else {
+        respond(*valid_jobs[i], PS_STATUS_REJECTED, empty, write_timeout);
+      }
+    }
+  }
+}
+
+static void
+readConnection(std::shared_ptr<PSVerifierdConnection> connection, PSVerifierdJobQueue& queue)
+{
+  std::vector<uint8_t> frame;
+  while (readFrame(connection->fd, frame)) {
+    auto job = std::make_unique<PSVerifierdJob>();
+    job->connection = connection;
+    if (!parseFrameHeader(frame, job->request_id, job->encoding)) {
+      break;
+    }
+    job->frame = std::move(frame);
+    if (!queue.push(std::move(job))) {
+      break;
+    }
+  }
+}
+
+static void
+printUsage()
+{
+  std::cerr << "usage: ps-verifierd --socket PATH --pubkey FILE [--authority FILE] [--precompute] [--workers N] [--pin]\n"
+            << "                    [--latency-target-us 2000] [--max-batch 64] [--queue 4096] [--write-timeout-ms 1000]\n"
+            << "                    [--socket-mode 0600]" << std::endl;
+}
+
+int
+main(int argc, char const* argv[])
+{
+  std::map<std::string, std::string> options;
+  std::string socket_path, pk_path;
+  size_t cpu_num = std::max(1u, std::thread::hardware_concurrency());
+  size_t worker_num, max_batch_size, queue_size;
+  double latency_target_us;
+  std::chrono::milliseconds write_timeout;
+  mode_t socket_mode;
+  try {
+    options = parseOptions(argc, argv);
+    socket_path = getOption(options, "socket", "");
+    pk_path = getOption(options, "pubkey", "");
+    worker_num = std::max<size_t>(1, getNumberOption(options, "workers", cpu_num));
+    latency_target_us = getDoubleOption(options, "latency-target-us", 2000);
+    max_batch_size = std::max<size_t>(1, getNumberOption(options, "max-batch", 64));
+    queue_size = std::max<size_t>(1, getNumberOption(options, "queue", 4096));
+    write_timeout = std::chrono::milliseconds(getNumberOption(options, "write-timeout-ms", 1000));
+    socket_mode = getNumberOption(options, "socket-mode", 0600, 8);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    printUsage();
+    return 1;
+  }
+  if (socket_path.empty() || pk_path.empty()) {
+    printUsage();
+    return 1;
+  }
+
+  PSCurve::init();
+  std::unique_ptr<PSVerifier> verifier;
+  std::unique_ptr<PSAuthorityContext> authority;
+  try {
+    verifier = std::make_unique<PSVerifier>(PSPubKey::fromBufferString(readFileBuffer(pk_path)));
+    if (options.count("precompute")) {
+      verifier->precompute();
+    }
+    if (options.count("authority")) {
+      std::vector<G1> points;
+      readFileBuffer(options["authority"]).parseG1List(0, points);
+      if (points.size() != 3) {
+        throw std::runtime_error("the authority file must hold authority_pk, g and h");
+      }
+      authority = std::make_unique<PSAuthorityContext>(points[0], points[1], points[2]);
+      if (options.count("precompute")) {
+        authority->precompute();
+      }
+    }
+    s_listen_fd = listenUnix(socket_path, socket_mode);
+  }
+  catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  PSVerifierdJobQueue queue(queue_size);
+  PSBatchController controller(latency_target_us, max_batch_size);
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < worker_num; i++) {
+    workers.emplace_back(runWorker, std::ref(queue), std::cref(*verifier),
+                         authority.get(), std::ref(controller), write_timeout);
+    if (options.count("pin")) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(i % cpu_num, &cpu_set);
+      pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpu_set), &cpu_set);
+    }
+  }
+
+  struct sigaction action = {};
+  action.sa_handler = handleSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  std::cout << "ps-verifierd: listening on " << socket_path << " with " << worker_num << " workers" << std::endl;
+
+  // connection readers are detached; the set tracks the live ones so that they can be stopped
+  std::mutex connections_mutex;
+  std::condition_variable connections_cv;
+  std::set<std::shared_ptr<PSVerifierdConnection>> connections;
+  while (!s_stopped) {
+    int fd = accept(s_listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    auto connection = std::make_shared<PSVerifierdConnection>();
+    connection->fd = fd;
+    {
+      std::lock_guard<std::mutex> lock(connections_mutex);
+      connections.insert(connection);
+    }
+    std::thread([&, connection] {
+      readConnection(connection, queue);
+      std::lock_guard<std::mutex> lock(connections_mutex);
+      connections.erase(connection);
+      connections_cv.notify_all();
+    }).detach();
+  }
+
+  // stop reading, then verify what is already queued
+  {
+    std::unique_lock<std::mutex> lock(connections_mutex);
+    for (const auto& connection : connections) {
+      shutdown(connection->fd, SHUT_RD);
+    }
+    connections_cv.wait(lock, [&] { return connections.empty(); });
+  }
+  queue.close();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  close(s_listen_fd);
+  unlink(socket_path.c_str());
+  std::cout << "ps-verifierd: stopped with batch limit " << controller.limit() << std::endl;
+  return 0;
+}
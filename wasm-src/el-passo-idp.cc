@@ -6,7 +6,7 @@ using namespace mcl::bls12;
 
 // a function that should be called before any other exported functions
 void initPS() {
-  initPairing();
+  PSCurve::init();
 }
 
 // a helper function to simplify the parameter passing from Javascript to C++ in EL PASSO ProveID
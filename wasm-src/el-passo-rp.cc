@@ -6,7 +6,7 @@ using namespace mcl::bls12;
 
 // a function that should be called before any other exported functions
 void initPS() {
-  initPairing();
+  PSCurve::init();
 }
 
 EMSCRIPTEN_BINDINGS(my_module) {
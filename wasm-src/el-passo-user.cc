@@ -8,7 +8,7 @@ using namespace mcl::bls12;
 
 // a function that should be called before any other exported functions
 void initPS() {
-  initPairing();
+  PSCurve::init();
 }
 
 // helper function to split string into a vector
@@ -90,10 +90,18 @@ EMSCRIPTEN_BINDINGS(my_module) {
   class_<PSRequester>("PSRequester")
     .constructor<PSPubKey>()
     .function("maxAllowedAttrNum", &PSRequester::maxAllowedAttrNum)
-    .function("el_passo_request_id", &PSRequester::el_passo_request_id)
-    .function("unblind_credential", &PSRequester::unblind_credential)
+    .function("el_passo_request_id",
+              select_overload<PSCredRequest(const std::vector<std::tuple<std::string, bool>>, const std::string&)>(
+                  &PSRequester::el_passo_request_id))
+    .function("unblind_credential", select_overload<PSCredential(const PSCredential&) const>(&PSRequester::unblind_credential))
     .function("verify", &PSRequester::verify)
     .function("randomize_credential", &PSRequester::randomize_credential)
-    .function("el_passo_prove_id", &PSRequester::el_passo_prove_id)
-    .function("el_passo_prove_id_without_id_retrieval", &PSRequester::el_passo_prove_id_without_id_retrieval);
+    .function("el_passo_prove_id",
+              select_overload<IdProof(const PSCredential&, const std::vector<std::tuple<std::string, bool>>,
+                                      const std::string&, const std::string&, const G1&, const G1&, const G1&) const>(
+                  &PSRequester::el_passo_prove_id))
+    .function("el_passo_prove_id_without_id_retrieval",
+              select_overload<IdProof(const PSCredential&, const std::vector<std::tuple<std::string, bool>>,
+                                      const std::string&, const std::string&) const>(
+                  &PSRequester::el_passo_prove_id_without_id_retrieval));
 }
\ No newline at end of file
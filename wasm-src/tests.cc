@@ -100,7 +100,7 @@ extern "C" {
 void EMSCRIPTEN_KEEPALIVE
 run_tests()
 {
-  initPairing();
+  PSCurve::init();
   test_el_passo(3);
 }
 